@@ -0,0 +1,105 @@
+// Times the genome comparison kernels (see genome_diff.h): the scalar loop, the vector kernel
+// in use and the bounded variant, on genomes of 64 and 2048 genes. The reference column is the
+// loop the comparison started as, over genomes stored as std::vector<unsigned int> (four bytes
+// a gene), so the gain from one-byte genes shows apart from the gain from the kernels.
+//   genome_diff_bench [ITERATIONS]
+// Related pairs differ in a few genes, unrelated ones are independent random genomes; the
+// bounded variant runs with the relative limit, as in Bot::areRelatives().
+#include "config.h"
+#include "genome_diff.h"
+#include "random.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const int PAIRS = 64; // Cycled through, so a run is not one pair in cache
+
+// Nanoseconds per comparison; checksum collects the results so nothing is optimized away.
+template <typename Gene>
+static double timePairs(int (*compare)(const std::vector<Gene>&, const std::vector<Gene>&),
+                        const std::vector<std::vector<Gene>>& a, const std::vector<std::vector<Gene>>& b,
+                        long long iterations, long long& checksum) {
+    Clock::time_point start = Clock::now();
+    for (long long i = 0; i < iterations; i++) {
+        checksum += compare(a[i % PAIRS], b[i % PAIRS]);
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+}
+
+// The original Bot::_genomeDifference().
+static int reference(const std::vector<unsigned int>& a, const std::vector<unsigned int>& b) {
+    int differences = 0;
+    size_t min_size = std::min(a.size(), b.size());
+    size_t max_size = std::max(a.size(), b.size());
+    for (size_t i = 0; i < min_size; ++i) {
+        if (a[i] != b[i]) {
+            differences++;
+        }
+    }
+    return differences + (max_size - min_size);
+}
+static int scalar(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+    return genomeDifferenceScalar(a.data(), a.size(), b.data(), b.size());
+}
+static int vectorized(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+    return genomeDifference(a.data(), a.size(), b.data(), b.size());
+}
+static int bounded(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+    return genomeDifferenceBounded(a.data(), a.size(), b.data(), b.size(), RELATIVE_GENOME_DIFFERENCE);
+}
+
+int main(int argc, char** argv) {
+    long long iterations = argc > 1 ? std::max(1LL, atoll(argv[1])) : 2000000;
+    Random random(1);
+    printf("kernel in use: %s, %lld comparisons per row (a 16th of that for 2048 genes)\n", genomeDifferenceKernel(), iterations);
+    printf("%6s  %-9s %12s %10s %10s %10s\n", "genes", "pairs", "reference ns", "scalar ns", "vector ns", "bounded ns");
+
+    long long checksum = 0;
+    bool agree = true;
+    for (int size : {64, 2048}) {
+        std::vector<std::vector<uint8_t>> first(PAIRS), related(PAIRS), unrelated(PAIRS);
+        for (int p = 0; p < PAIRS; p++) {
+            for (int i = 0; i < size; i++) {
+                first[p].push_back((uint8_t)random.next(0, 127));
+                unrelated[p].push_back((uint8_t)random.next(0, 127));
+            }
+            related[p] = first[p];
+            for (int m = 0; m < RELATIVE_GENOME_DIFFERENCE - 2; m++) related[p][random.next(0, size - 1)] ^= 1;
+        }
+        std::vector<std::vector<unsigned int>> wide_first(PAIRS), wide_related(PAIRS), wide_unrelated(PAIRS);
+        for (int p = 0; p < PAIRS; p++) {
+            wide_first[p].assign(first[p].begin(), first[p].end());
+            wide_related[p].assign(related[p].begin(), related[p].end());
+            wide_unrelated[p].assign(unrelated[p].begin(), unrelated[p].end());
+        }
+        for (int p = 0; p < PAIRS; p++) {
+            agree = agree && reference(wide_first[p], wide_related[p]) == scalar(first[p], related[p]) &&
+                    reference(wide_first[p], wide_unrelated[p]) == scalar(first[p], unrelated[p]) &&
+                    scalar(first[p], related[p]) == vectorized(first[p], related[p]) &&
+                    scalar(first[p], unrelated[p]) == vectorized(first[p], unrelated[p]) &&
+                    scalar(first[p], related[p]) == bounded(first[p], related[p]);
+        }
+        const std::vector<std::vector<uint8_t>>* seconds[] = {&related, &unrelated};
+        const std::vector<std::vector<unsigned int>>* wide_seconds[] = {&wide_related, &wide_unrelated};
+        const char* names[] = {"related", "unrelated"};
+        for (int k = 0; k < 2; k++) {
+            // Long genomes take longer per call; keep every row at a similar total time.
+            long long count = size > 64 ? std::max(1LL, iterations / 16) : iterations;
+            double reference_ns = timePairs(reference, wide_first, *wide_seconds[k], count, checksum);
+            double scalar_ns = timePairs(scalar, first, *seconds[k], count, checksum);
+            double vector_ns = timePairs(vectorized, first, *seconds[k], count, checksum);
+            double bounded_ns = timePairs(bounded, first, *seconds[k], count, checksum);
+            printf("%6d  %-9s %12.1f %10.1f %10.1f %10.1f\n", size, names[k], reference_ns, scalar_ns, vector_ns, bounded_ns);
+        }
+    }
+    printf("(checksum %lld)\n", checksum);
+    if (!agree) {
+        printf("the kernels disagree\n");
+        return 1;
+    }
+    return 0;
+}
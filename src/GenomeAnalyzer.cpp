@@ -3,40 +3,18 @@
 #include "imgui.h"
 #include "instructions.h"
 #include <string>
-#include <map>
-#include <functional>
-
-// A map to associate instruction enum values with human-readable string names.
-const std::map<int, std::string> instruction_names = {
-    {MOVE, "MOVE"}, {TURN, "TURN"}, {LOOK, "LOOK"}, {ATTACK, "ATTACK"},
-    {PHOTOSYNTHIZE, "PHOTO"}, {CHECK_RELATIVE, "CH_RELATIVE"},
-    {SHARE_ENERGY, "SHARE"}, {CONSUME_ORGANIC, "EAT_ORGANIC"},
-    {REPRODUCE, "REPRODUCE"},
-    {CHECK_BIOME, "CH_BIOME"}, {CHECK_X, "CHECK_X"}, {CHECK_Y, "CHECK_Y"},
-    {CHECK_ENERGY, "CHECK_ENERGY"}, {CHECK_AGE, "CHECK_AGE"},
-    {JUMP_IF_EQUAL, "JMP_EQ"}, {JUMP_IF_NOT_EQUAL, "JMP_NE"}, {JUMP_IF_GREATER, "JMP_GT"}
-};
-
-/**
- * @brief Converts an instruction value to its string representation.
- * @param instruction The unsigned integer value of the instruction.
- * @return A string name for the instruction.
- */
-std::string getInstructionName(unsigned int instruction) {
-    if (instruction_names.count(instruction)) {
-        return instruction_names.at(instruction);
-    }
-    if (instruction >= JUMP && instruction <= MAX_INSTRUCTION_VALUE) {
-        return "JMP";
-    }
-    return "UNKNOWN";
-}
+#include <algorithm>
+#include <cmath>
+#include "genome_diff.h"
 
 GenomeAnalyzer::GenomeAnalyzer() {}
 
 // Destructor ensures the local simulation world is cleaned up.
 GenomeAnalyzer::~GenomeAnalyzer() {
+    cancelRun();
+    cancelSurvivalEstimate();
     delete local_world;
+    delete original_bot;
 }
 
 // Returns true if the analyzer window is currently open.
@@ -46,19 +24,26 @@ bool GenomeAnalyzer::isOpen() const {
 
 // Closes the analyzer, cleaning up all simulation-specific data.
 void GenomeAnalyzer::close() {
+    cancelRun();
+    cancelSurvivalEstimate();
+    show_survival_window = false;
     is_open = false;
     current_placement_mode = PLACE_NONE;
     sim_bot = nullptr;
     delete local_world; // This will delete the sim_bot and other bots inside it
     local_world = nullptr;
+    events = BotEvents();
+    delete original_bot;
     original_bot = nullptr;
 }
 
 // Opens the analyzer for a given bot, pausing the main simulation.
-void GenomeAnalyzer::analyze(Bot* bot) {
-    if (!bot) return;
-
-    original_bot = bot;
+void GenomeAnalyzer::analyze(const Bot& bot) {
+    cancelRun();
+    cancelSurvivalEstimate();
+    has_survival_report = false;
+    delete original_bot;
+    original_bot = new Bot(bot);
     is_open = true;
     is_paused = true;
 
@@ -67,7 +52,9 @@ void GenomeAnalyzer::analyze(Bot* bot) {
 
 // Resets the local simulation to its initial state based on the original bot.
 void GenomeAnalyzer::resetSimulation() {
+    cancelRun();
     delete local_world;
+    run_result.clear();
 
     // Create a deep copy of the bot for local simulation and place it in the center
     sim_bot = new Bot(*original_bot);
@@ -76,6 +63,9 @@ void GenomeAnalyzer::resetSimulation() {
     // Create a small local world for the simulation
     local_world = new World(LOCAL_WORLD_SIZE, LOCAL_WORLD_SIZE);
     local_world->addBot(sim_bot);
+    events = BotEvents();
+    events.bot = sim_bot;
+    local_world->setObserver(&events);
 
     buildGraphLayout();
 }
@@ -83,26 +73,136 @@ void GenomeAnalyzer::resetSimulation() {
 // Advances the local simulation by one step, processing the bot's genome.
 void GenomeAnalyzer::step() {
     if (sim_bot && local_world) {
+        bool was_dead = events.died;
         local_world->process();
-        // If the main bot died during the process() call, it has been deallocated.
-        // We must not access it further. The is_dead check handles this.
-        if (sim_bot == nullptr) {
-            return;
-        }
-        if (sim_bot->is_dead) {
+        if (events.died && !was_dead) {
+            // The world frees dead bots (corpses once eaten), so from now on the analyzer
+            // shows the copy taken at the moment of death.
+            sim_bot = events.final_state.get();
             is_paused = true; // Auto-pause on death of the main bot
         }
     }
 }
 
+void GenomeAnalyzer::BotEvents::onReproduce(const Bot& parent, const Bot& child) {
+    if (&parent == bot) reproductions++;
+}
+
+void GenomeAnalyzer::BotEvents::onAttack(const Bot& attacker, const Bot& victim) {
+    if (&attacker == bot) attacks++;
+}
+
+void GenomeAnalyzer::BotEvents::onDeath(const Bot& dead_bot) {
+    if (&dead_bot != bot) return;
+    died = true;
+    final_state = std::make_unique<Bot>(dead_bot);
+    bot = nullptr;
+}
+
+void GenomeAnalyzer::startRun() {
+    if (run_active || !sim_bot || !local_world) return;
+    cancelRun(); // Joins the thread of the previous run
+    is_paused = true;
+    current_placement_mode = PLACE_NONE;
+    run_cancel = false;
+    run_progress = 0;
+    run_result.clear();
+    run_active = true;
+    run_thread = std::thread(&GenomeAnalyzer::runUntilCondition, this);
+}
+
+void GenomeAnalyzer::cancelRun() {
+    if (!run_thread.joinable()) return;
+    run_cancel = true;
+    run_thread.join();
+}
+
+// Runs on the background thread. The local world draws from its own random generator, so
+// nothing else is shared with the UI thread.
+void GenomeAnalyzer::runUntilCondition() {
+    const int reproductions_before = events.reproductions;
+    const int attacks_before = events.attacks;
+    long long steps = 0;
+    std::string result;
+    while (true) {
+        if (run_cancel.load(std::memory_order_relaxed)) {
+            result = "Cancelled";
+            break;
+        }
+        if (steps >= run_max_steps) {
+            result = "Step limit reached";
+            break;
+        }
+        step();
+        run_progress.store(++steps, std::memory_order_relaxed);
+        if (run_condition != RUN_UNTIL_DEATH && events.died) {
+            result = "The bot died";
+            break;
+        }
+        if (isRunConditionMet(reproductions_before, attacks_before)) {
+            result = "Condition met";
+            break;
+        }
+    }
+    run_result = result + " after " + std::to_string(steps) + (steps == 1 ? " step" : " steps");
+    run_active.store(false, std::memory_order_release);
+}
+
+bool GenomeAnalyzer::isRunConditionMet(int reproductions_before, int attacks_before) const {
+    switch (run_condition) {
+        case RUN_UNTIL_REPRODUCE: return events.reproductions > reproductions_before;
+        case RUN_UNTIL_ATTACK: return events.attacks > attacks_before;
+        case RUN_UNTIL_DEATH: return events.died;
+        case RUN_UNTIL_PC: {
+            // The interpreter wraps pc at the start of the next instruction.
+            return !events.died && sim_bot->getGenomeSize() > 0 &&
+                   (int)(sim_bot->getPC() % sim_bot->getGenomeSize()) == run_pc;
+        }
+        case RUN_UNTIL_MEMORY: {
+            if (events.died) return false;
+            const std::vector<unsigned int>& memory = sim_bot->getMemory();
+            long long value;
+            if (run_memory_operand == MEMORY_OPERAND_SIZE) {
+                value = (long long)memory.size();
+            } else if (!memory.empty()) {
+                value = memory.back();
+            } else {
+                return false; // No top to compare
+            }
+            switch (run_comparison) {
+                case COMPARE_EQUAL: return value == run_memory_value;
+                case COMPARE_NOT_EQUAL: return value != run_memory_value;
+                case COMPARE_LESS: return value < run_memory_value;
+                case COMPARE_GREATER: return value > run_memory_value;
+            }
+            return false;
+        }
+        default: return false;
+    }
+}
+
 void GenomeAnalyzer::draw() {
     // Don't draw if the window is not open.
     if (!is_open || !original_bot) {
         return;
     }
 
+    // A finished background run hands the local world back to the UI.
+    if (!run_active.load(std::memory_order_acquire) && run_thread.joinable()) {
+        run_thread.join();
+    }
+
     ImGui::SetNextWindowSize(ImVec2(1000, 700), ImGuiCond_FirstUseEver);
     if (ImGui::Begin("Genome Analyzer", &is_open)) {
+        // While a background run owns the local world, only its progress is shown.
+        if (run_active.load(std::memory_order_acquire)) {
+            drawRunControls();
+            ImGui::End();
+            drawSurvivalWindow();
+            if (!is_open) close();
+            return;
+        }
+
         // Handle keyboard shortcuts for play/pause and step when the window is focused.
         if (ImGui::IsWindowFocused(ImGuiFocusedFlags_RootAndChildWindows)) {
             // RMB cancels placement mode
@@ -127,11 +227,23 @@ void GenomeAnalyzer::draw() {
         }
 
         drawControls();
+        drawRunControls();
         ImGui::Separator();
 
         // --- Left Pane: Genome Graph ---
         ImGui::BeginChild("LeftPane", ImVec2(ImGui::GetContentRegionAvail().x * 0.6f, 0), false);
         ImGui::Text("Genome Program Flow Graph");
+        if (layout) {
+            const GenomeAnalysis& analysis = layout->analysis;
+            ImGui::TextDisabled("Reachable %d of %d genes, %d actions, %d loops (%d action-free)%s",
+                                analysis.getReachableCount(), (int)layout->genome.size(), analysis.getActionCount(),
+                                analysis.getLoopCount(), analysis.getActionFreeLoopCount(),
+                                analysis.isInert() ? ", never acts" : "");
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Orange outline: loop without actions that can still be left.\n"
+                                  "Purple outline: no action can follow, a bot that gets here only starves.");
+            }
+        }
         // The graph is in its own child window to enable scrolling for large genomes.
         ImGui::BeginChild("Graph", ImVec2(0, 0), true, ImGuiWindowFlags_HorizontalScrollbar);
             drawGenomeGraph();
@@ -162,6 +274,8 @@ void GenomeAnalyzer::draw() {
     }
     ImGui::End();
 
+    drawSurvivalWindow();
+
     // If the window was closed by the user (clicking 'x'), perform cleanup.
     if (!is_open) {
         close(); // Cleanup if window was closed
@@ -182,275 +296,439 @@ void GenomeAnalyzer::drawControls() {
     if (ImGui::Button("Reset")) {
         resetSimulation();
     }
+    ImGui::SameLine();
+    if (ImGui::Button("Estimate Survival...")) {
+        show_survival_window = true;
+    }
 }
 
-/**
- * @brief Builds the visual layout of the genome graph.
- * This function performs a recursive traversal (DFS) starting from PC 0 to identify all reachable
- * instructions. It then positions them in a hierarchical layout to make control flow clear.
- */
-void GenomeAnalyzer::buildGraphLayout() {
-    node_positions.clear();
-    if (!sim_bot) return;
+void GenomeAnalyzer::setNeighborPool(std::shared_ptr<const std::vector<Bot>> pool) {
+    survival_settings.neighbor_pool = std::move(pool);
+}
 
-    const auto& genome = sim_bot->getGenome();
-    if (genome.empty()) return;
+void GenomeAnalyzer::startSurvivalEstimate() {
+    if (survival_active || !original_bot) return;
+    cancelSurvivalEstimate(); // Joins the thread of the previous estimate
+    survival_cancel = false;
+    survival_progress = 0;
+    has_survival_report = false;
+    survival_active = true;
+    // The thread works on its own copies, so the analyzer may be reset meanwhile.
+    survival_thread = std::thread([this, bot = *original_bot, settings = survival_settings]() {
+        survival_report = evaluateSurvival(bot, settings, &survival_progress, &survival_cancel);
+        survival_active.store(false, std::memory_order_release);
+    });
+}
 
-    node_positions.assign(genome.size(), ImVec2(-1, -1)); // Use -1,-1 to mark non-reachable/not-yet-placed
+void GenomeAnalyzer::cancelSurvivalEstimate() {
+    if (!survival_thread.joinable()) return;
+    survival_cancel = true;
+    survival_thread.join();
+}
 
-    // Constants for controlling the graph's appearance.
-    const float LEVEL_HEIGHT = 50.0f + 50.0f;
-    const float NODE_SPACING_X = 170.0f + 40.0f;
+// Settings, progress and results of the Monte Carlo survival estimate.
+void GenomeAnalyzer::drawSurvivalWindow() {
+    if (!survival_active.load(std::memory_order_acquire) && survival_thread.joinable()) {
+        survival_thread.join();
+        has_survival_report = !survival_report.scenarios.empty();
+    }
+    if (!show_survival_window) return;
+
+    ImGui::SetNextWindowSize(ImVec2(520, 560), ImGuiCond_FirstUseEver);
+    if (ImGui::Begin("Survival Estimate", &show_survival_window)) {
+        ImGui::TextWrapped("Runs the analyzed genome as a newborn in many random %dx%d worlds "
+                           "(biome, neighbors, corpses and relatives vary) on all cores.", LOCAL_WORLD_SIZE, LOCAL_WORLD_SIZE);
+        if (survival_settings.neighbor_pool && !survival_settings.neighbor_pool->empty()) {
+            ImGui::Text("Neighbors are drawn from %d banked genomes.", (int)survival_settings.neighbor_pool->size());
+            ImGui::SameLine();
+            if (ImGui::SmallButton("Use Random")) survival_settings.neighbor_pool.reset();
+        }
+        if (survival_active.load(std::memory_order_acquire)) {
+            int done = survival_progress.load(std::memory_order_relaxed);
+            std::string overlay = std::to_string(done) + " / " + std::to_string(survival_settings.scenarios) + " scenarios";
+            ImGui::ProgressBar((float)done / std::max(1, survival_settings.scenarios), ImVec2(-100, 0), overlay.c_str());
+            ImGui::SameLine();
+            if (ImGui::Button("Cancel")) survival_cancel = true;
+        } else {
+            ImGui::InputInt("Scenarios", &survival_settings.scenarios, 50, 500);
+            ImGui::InputInt("Steps per scenario", &survival_settings.max_steps, 500, 5000);
+            int seed = (int)survival_settings.seed;
+            if (ImGui::InputInt("Seed", &seed)) survival_settings.seed = (uint64_t)(unsigned int)seed;
+            survival_settings.scenarios = std::clamp(survival_settings.scenarios, 1, 100000);
+            survival_settings.max_steps = std::clamp(survival_settings.max_steps, 1, 1000000);
+            if (ImGui::Button("Run Estimate")) startSurvivalEstimate();
+        }
 
-    std::vector<int> nodes_at_depth(genome.size(), 0);
+        if (has_survival_report) {
+            const EvaluationReport& report = survival_report;
+            ImGui::Separator();
+            ImGui::Text("%d scenarios%s", (int)report.scenarios.size(), report.cancelled ? " (cancelled)" : "");
+            ImGui::Text("Survived %d steps: %.0f%%  (sunny %.0f%%, balanced %.0f%%, dark %.0f%%)",
+                        survival_settings.max_steps, report.survival_rate * 100.0f,
+                        report.survival_rate_by_biome[BIOME_SUNNY] * 100.0f,
+                        report.survival_rate_by_biome[BIOME_BALANCED] * 100.0f,
+                        report.survival_rate_by_biome[BIOME_DARK] * 100.0f);
+            auto distribution_row = [](const char* label, const Distribution& d) {
+                ImGui::Text("%-14s mean %7.1f  min %6.0f  p10 %6.0f  median %6.0f  p90 %6.0f  max %6.0f",
+                            label, d.mean, d.min, d.p10, d.median, d.p90, d.max);
+            };
+            distribution_row("Survival steps", report.survival_steps);
+            distribution_row("Reproductions", report.reproductions);
+
+            ImGui::Text("Energy every %d steps (p90, median, p10):", report.energy_interval);
+            float width = ImGui::GetContentRegionAvail().x;
+            ImGui::PlotLines("##EnergyP90", report.energy_p90.data(), (int)report.energy_p90.size(), 0, nullptr, 0.0f, (float)MAX_ENERGY, ImVec2(width, 60));
+            ImGui::PlotLines("##EnergyMedian", report.energy_median.data(), (int)report.energy_median.size(), 0, nullptr, 0.0f, (float)MAX_ENERGY, ImVec2(width, 60));
+            ImGui::PlotLines("##EnergyP10", report.energy_p10.data(), (int)report.energy_p10.size(), 0, nullptr, 0.0f, (float)MAX_ENERGY, ImVec2(width, 60));
+        }
+    }
+    ImGui::End();
+}
 
-    // A recursive lambda function to place nodes.
-    std::function<void(int, int, int)> place_node_recursive;
-    place_node_recursive = 
-        [&](int pc, int depth, int parent_col) {
+// Draws the fast-forward controls: a stop condition, the step limit and the Run button.
+// While a run is active, shows its progress and a Cancel button instead.
+void GenomeAnalyzer::drawRunControls() {
+    if (run_active.load(std::memory_order_acquire)) {
+        long long done = run_progress.load(std::memory_order_relaxed);
+        std::string overlay = std::to_string(done) + " / " + std::to_string(run_max_steps) + " steps";
+        ImGui::ProgressBar(run_max_steps > 0 ? (float)done / run_max_steps : 0.0f, ImVec2(300, 0), overlay.c_str());
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel")) {
+            run_cancel = true;
+        }
+        return;
+    }
 
-            // Base cases for recursion: out of bounds or already visited.
-            if (pc < 0 || pc >= genome.size()) return;
-            // If node is already placed at this or a shallower depth, stop to prevent cycles/clutter.
-            // This makes backward jumps (loops) use the "GOTO" rendering instead of drawing long lines up.
-            if (node_positions[pc].x != -1 && node_positions[pc].y <= (float)(depth * LEVEL_HEIGHT + 50)) {
-                return;
-            }
-            // Calculate the position for the current node.
-            int current_col = std::max(parent_col, nodes_at_depth[depth]);
-            node_positions[pc] = ImVec2((float)(current_col * NODE_SPACING_X + 50), (float)(depth * LEVEL_HEIGHT + 50));
-            // Update layout metadata to prevent future nodes from overlapping.
-            nodes_at_depth[depth] = current_col + 1;
-            for (int i = depth + 1; i < genome.size(); ++i) {
-                nodes_at_depth[i] = std::max(nodes_at_depth[i], current_col);
-            }
+    static const char* condition_names[] = {"N steps", "Reproduce", "Attack", "Death", "PC reached", "Memory"};
+    ImGui::SetNextItemWidth(120);
+    ImGui::Combo("##RunCondition", &run_condition, condition_names, IM_ARRAYSIZE(condition_names));
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(100);
+    ImGui::InputInt(run_condition == RUN_STEPS ? "Steps" : "Max steps", &run_max_steps, 100, 1000);
+    run_max_steps = std::max(1, run_max_steps);
+    if (run_condition == RUN_UNTIL_PC) {
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(80);
+        ImGui::InputInt("PC", &run_pc);
+        run_pc = std::clamp(run_pc, 0, std::max(0, sim_bot->getGenomeSize() - 1));
+    } else if (run_condition == RUN_UNTIL_MEMORY) {
+        static const char* operand_names[] = {"Top", "Size"};
+        static const char* comparison_names[] = {"==", "!=", "<", ">"};
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(60);
+        ImGui::Combo("##MemoryOperand", &run_memory_operand, operand_names, IM_ARRAYSIZE(operand_names));
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(50);
+        ImGui::Combo("##Comparison", &run_comparison, comparison_names, IM_ARRAYSIZE(comparison_names));
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(80);
+        ImGui::InputInt("##MemoryValue", &run_memory_value);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Fast-Forward")) {
+        startRun();
+    }
+    if (!run_result.empty()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%s", run_result.c_str());
+    }
+}
+
+// Constants for controlling the graph's appearance.
+static const float LEVEL_HEIGHT = 50.0f + 50.0f;
+static const float NODE_SPACING_X = 170.0f + 40.0f;
+static const ImVec2 NODE_SIZE(200, 30);             // Rectangle for plain instructions
+static const ImVec2 CONDITIONAL_NODE_SIZE(200, 50); // Diamond for LOOK and conditional jumps
+static const float LONG_JUMP_DISTANCE_X = 400.0f;   // Edges spanning more than this become GOTO boxes
+static const int MINIMAP_CELLS = 64;                // Resolution of the minimap's occupancy grid
+static const float MINIMAP_SIZE = 160.0f;
+
+static bool isConditional(unsigned int instruction) {
+    InstructionFlow flow = getInstructionInfo(instruction).flow;
+    return flow == FLOW_LOOK || flow == FLOW_CONDITIONAL;
+}
+
+// Everything about the graph that does not change while it is shown is computed here once,
+// so drawing only has to look at what is visible.
+GenomeAnalyzer::GraphLayout::GraphLayout(const std::vector<uint8_t>& genome) : genome(genome), graph(genome), analysis(genome, graph) {
+    const int size = (int)genome.size();
+    node_positions.assign(size, ImVec2(-1, -1)); // Use -1,-1 to mark non-reachable nodes
+    for (int pc : graph.getReachableNodes()) {
+        node_positions[pc] = ImVec2(graph.getColumn(pc) * NODE_SPACING_X + 50, graph.getDepth(pc) * LEVEL_HEIGHT + 50);
+    }
 
-            unsigned int instruction = genome[pc];
-            
-            // Recursively call for the next nodes based on the current instruction type.
-            if (instruction == LOOK) {
-                place_node_recursive((pc + 1) % genome.size(), depth + 1, current_col); // Empty
-                place_node_recursive((pc + 2) % genome.size(), depth + 1, current_col); // Bot
-                place_node_recursive((pc + 3) % genome.size(), depth + 1, current_col); // Organic
-            } else if (instruction >= JUMP_IF_EQUAL && instruction <= JUMP_IF_GREATER) {
-                int jump_offset = (pc + 1 < genome.size()) ? (genome[pc + 1] % 10) : 0;
-                place_node_recursive((pc + jump_offset) % genome.size(), depth + 1, current_col); // True path (down)
-                place_node_recursive((pc + 2) % genome.size(), depth + 1, current_col + 1); // False path (right)
-            } else if (instruction >= JUMP && instruction <= MAX_INSTRUCTION_VALUE) {
-                // Unconditional jump
-                place_node_recursive((pc + instruction) % genome.size(), depth + 1, current_col);
+    // Rows: the breadth-first order already lists every depth with increasing columns.
+    rows.assign(graph.getMaxDepth() + 1, {});
+    for (int pc : graph.getReachableNodes()) {
+        rows[graph.getDepth(pc)].push_back(pc);
+    }
+
+    // Node labels, and the green/red tint of conditional nodes that are the short-range
+    // "taken" or "not taken" target of a conditional jump (the last such jump wins).
+    labels.resize(size);
+    node_colors.assign(size, IM_COL32(50, 50, 50, 255));
+    node_borders.assign(size, IM_COL32(150, 150, 150, 255));
+    for (int pc : graph.getReachableNodes()) {
+        if (analysis.isTrapped(pc)) {
+            node_borders[pc] = IM_COL32(170, 90, 255, 255); // No action can ever follow
+        } else if (analysis.isActionFreeLoop(analysis.getComponent(pc))) {
+            node_borders[pc] = IM_COL32(255, 150, 0, 255);  // A loop without actions that can still be left
+        }
+    }
+    edge_start.assign(size + 1, 0);
+    for (int i = 0; i < size; ++i) {
+        labels[i] = std::to_string(i) + ": " + disassemble(genome, (unsigned int)i);
+    }
+
+    // Edges, grouped by source node.
+    for (int i = 0; i < size; ++i) {
+        if (graph.isReachable(i)) {
+            const InstructionFlow flow = getInstructionInfo(genome[i]).flow;
+            const unsigned int* successors = graph.successorsBegin(i);
+            auto add_edge = [&](int target, ImU32 color, EdgeStart start) {
+                if (!graph.isReachable(target)) return;
+                // An edge that goes up more than one level (a loop, including sequential flow
+                // that wraps around from the last gene) or far sideways gets a "GOTO N" box
+                // instead of a long line. drawGenomeGraph() relies on this to cull edges by row.
+                bool is_long_jump = node_positions[target].y < node_positions[i].y - LEVEL_HEIGHT ||
+                                    std::abs(node_positions[target].x - node_positions[i].x) > LONG_JUMP_DISTANCE_X;
+                edges.push_back({target, color, start, is_long_jump});
+            };
+            if (flow == FLOW_LOOK) {
+                add_edge(successors[0], IM_COL32(200, 200, 200, 150), EDGE_FROM_CENTER); // Gray for "empty"
+                add_edge(successors[1], IM_COL32(0, 255, 0, 150), EDGE_FROM_CENTER);
+                add_edge(successors[2], IM_COL32(0, 0, 255, 150), EDGE_FROM_CENTER);
+            } else if (flow == FLOW_CONDITIONAL) {
+                // True path leaves from the left corner, false path from the right one.
+                add_edge(successors[0], IM_COL32(0, 255, 0, 200), EDGE_FROM_LEFT);
+                add_edge(successors[1], IM_COL32(255, 0, 0, 200), EDGE_FROM_RIGHT);
+                // Tint the false target first, so a node that is both targets ends up green.
+                for (int e = (int)edges.size() - 1; e >= edge_start[i]; e--) {
+                    if (!edges[e].is_long_jump && isConditional(genome[edges[e].target])) {
+                        node_colors[edges[e].target] = edges[e].start == EDGE_FROM_LEFT ? IM_COL32(0, 60, 0, 255) : IM_COL32(60, 0, 0, 255);
+                    }
+                }
+            } else if (flow == FLOW_JUMP) {
+                add_edge(successors[0], IM_COL32(255, 255, 255, 200), EDGE_FROM_CENTER);
             } else {
-                place_node_recursive((pc + 1) % genome.size(), depth + 1, current_col);
+                add_edge(successors[0], IM_COL32(255, 255, 255, 150), EDGE_FROM_CENTER);
             }
-        };
+        }
+        edge_start[i + 1] = (int)edges.size();
+    }
 
-    // Start the recursive layout process from the first instruction (PC=0).
-    place_node_recursive(0, 0, 0);
+    // Graph extent and the minimap's occupancy grid.
+    extent = ImVec2(0, 0);
+    for (int pc : graph.getReachableNodes()) {
+        extent.x = std::max(extent.x, node_positions[pc].x + NODE_SIZE.x + 50.0f);
+        extent.y = std::max(extent.y, node_positions[pc].y + CONDITIONAL_NODE_SIZE.y + 50.0f);
+    }
+    float cell = std::max(extent.x, extent.y) / MINIMAP_CELLS;
+    std::vector<bool> occupied(MINIMAP_CELLS * MINIMAP_CELLS, false);
+    for (int pc : graph.getReachableNodes()) {
+        int cx = std::min(MINIMAP_CELLS - 1, (int)(node_positions[pc].x / cell));
+        int cy = std::min(MINIMAP_CELLS - 1, (int)(node_positions[pc].y / cell));
+        if (!occupied[cy * MINIMAP_CELLS + cx]) {
+            occupied[cy * MINIMAP_CELLS + cx] = true;
+            minimap_cells.push_back(cy * MINIMAP_CELLS + cx);
+        }
+    }
+}
+
+/**
+ * @brief Builds the visual layout of the genome graph.
+ * The control-flow graph is laid out in layers by a breadth-first walk from PC 0 (see GenomeGraph),
+ * so back edges (loops) point upwards and are drawn as "GOTO" boxes. The result is cached by genome.
+ */
+void GenomeAnalyzer::buildGraphLayout() {
+    layout.reset();
+    if (!sim_bot || sim_bot->getGenome().empty()) return;
+
+    const auto& genome = sim_bot->getGenome();
+    uint64_t hash = hashGenome(genome.data(), genome.size());
+    auto it = layout_cache.find(hash);
+    if (it != layout_cache.end() && it->second->genome == genome) {
+        layout = it->second;
+        return;
+    }
+
+    if ((int)layout_cache.size() >= LAYOUT_CACHE_SIZE) layout_cache.clear();
+    layout = std::make_shared<const GraphLayout>(genome);
+    layout_cache[hash] = layout;
 }
 
 /**
  * @brief Draws the genome graph using ImGui's custom drawing API.
- * It iterates through all reachable nodes, drawing them and the connections (edges) between them.
+ * Only the rows and columns that intersect the scrolled view are visited. Every edge drawn as
+ * a line spans at most one row up or down and LONG_JUMP_DISTANCE_X sideways: the breadth-first
+ * layout never goes down more than one row, and all other edges, sequential flow included,
+ * are GOTO boxes next to their source. So the edges of the visible rows plus one row and a
+ * few columns of margin are all that can reach the view.
  */
 void GenomeAnalyzer::drawGenomeGraph() {
-    if (node_positions.empty() || !sim_bot) return;
+    if (!layout || !sim_bot) return;
+    const GraphLayout& graph = *layout;
 
     ImDrawList* draw_list = ImGui::GetWindowDrawList();
     ImVec2 p = ImGui::GetCursorScreenPos();
-
-    const auto& genome = sim_bot->getGenome();
     unsigned int current_pc = sim_bot->getPC();
 
-    float max_x = 0.0f, max_y = 0.0f;
+    // The visible part of the graph, in layout coordinates.
+    ImVec2 view_min = ImVec2(draw_list->GetClipRectMin().x - p.x, draw_list->GetClipRectMin().y - p.y);
+    ImVec2 view_max = ImVec2(draw_list->GetClipRectMax().x - p.x, draw_list->GetClipRectMax().y - p.y);
+    int first_row = std::max(0, (int)std::floor((view_min.y - 50.0f - CONDITIONAL_NODE_SIZE.y) / LEVEL_HEIGHT));
+    int last_row = std::min((int)graph.rows.size() - 1, (int)std::floor((view_max.y - 50.0f) / LEVEL_HEIGHT));
+    int first_column = (int)std::floor((view_min.x - 50.0f - NODE_SIZE.x) / NODE_SPACING_X);
+    int last_column = (int)std::floor((view_max.x - 50.0f) / NODE_SPACING_X);
+
+    // Calls fn for every node of the rows and columns in range.
+    auto for_each_node = [&](int row_from, int row_to, int column_from, int column_to, auto fn) {
+        for (int row = std::max(0, row_from); row <= std::min((int)graph.rows.size() - 1, row_to); row++) {
+            const std::vector<int>& nodes = graph.rows[row];
+            auto it = std::lower_bound(nodes.begin(), nodes.end(), column_from,
+                                       [&](int node, int column) { return graph.graph.getColumn(node) < column; });
+            for (; it != nodes.end() && graph.graph.getColumn(*it) <= column_to; ++it) {
+                fn(*it);
+            }
+        }
+    };
 
     // --- Pass 1: Draw Edges ---
     // Edges are drawn first so they appear underneath the nodes.
-    for (int i = 0; i < genome.size(); ++i) {
-        if (node_positions[i].x < 0) continue; // Skip non-reachable nodes
-
-        unsigned int instruction = genome[i];
-        ImVec2 default_start_pos = ImVec2(p.x + node_positions[i].x + 75, p.y + node_positions[i].y + 15);
-
-        // Helper lambda to draw a single edge with an optional label and arrow.
-        auto draw_edge = [&](int target_idx, ImU32 color, const char* label = nullptr, bool force_bezier = false, ImVec2* start_pos_override = nullptr) {
-            if (target_idx >= 0 && target_idx < genome.size() && node_positions[target_idx].x >= 0) {
-                ImVec2 end_pos = ImVec2(p.x + node_positions[target_idx].x + 75, p.y + node_positions[target_idx].y + 15);
-
-                // Use bezier for non-sequential jumps to reduce clutter
-                bool is_sequential_flow = (target_idx == (i + 1) % genome.size() || target_idx == (i + 2) % genome.size() || target_idx == (i + 3) % genome.size());
-                
-                // Heuristic for a "long jump": a non-sequential jump that goes up more than one level, or across a large horizontal distance.
-                bool is_long_jump = !is_sequential_flow && (
-                    node_positions[target_idx].y < node_positions[i].y - 100.0f || // Jumps "up" (loops)
-                    std::abs(node_positions[target_idx].x - node_positions[i].x) > 400.0f // Jumps far sideways
-                );
-
-                bool is_false_branch_from_conditional = (label && strcmp(label, "False") == 0);
-
-                ImVec2 start_pos = start_pos_override ? *start_pos_override : default_start_pos;
-
-                if (is_long_jump) { // For long jumps, draw a "GOTO N" node instead of a long line.
-                    // Draw a short stub line pointing down from the node.
-                    ImVec2 goto_node_pos;
-                    if (is_false_branch_from_conditional) {
-                        // For a 'false' branch, the GOTO should be to the right.
-                        goto_node_pos = ImVec2(start_pos.x + 100.0f, start_pos.y + 60.0f);
-                        draw_list->AddLine(ImVec2(start_pos.x + 20, start_pos.y + 25), goto_node_pos, color, 2.0f);
-                    } else {
-                        // For 'true' or unconditional jumps, the GOTO is straight down.
-                        goto_node_pos = ImVec2(start_pos.x, start_pos.y + 60.0f);
-                        draw_list->AddLine(start_pos, goto_node_pos, color, 2.0f);
-                    }
-                    
-                    // Create the "GOTO" text and calculate its size.
-                    std::string goto_text = "GOTO " + std::to_string(target_idx);
-                    ImVec2 text_size = ImGui::CalcTextSize(goto_text.c_str());
-                    ImVec2 rect_pos = ImVec2(goto_node_pos.x - text_size.x / 2.0f - 5.0f, goto_node_pos.y);
-                    ImVec2 rect_end = ImVec2(rect_pos.x + text_size.x + 10, rect_pos.y + text_size.y + 4);
-
-                    // Draw the GOTO box with a background, border, and text.
-                    draw_list->AddRectFilled(rect_pos, rect_end, IM_COL32(30, 30, 30, 200), 3.0f);
-                    draw_list->AddRect(rect_pos, rect_end, color, 3.0f);
-                    draw_list->AddText(ImVec2(rect_pos.x + 5, rect_pos.y + 2), IM_COL32(255, 255, 255, 255), goto_text.c_str());
-                } else if (force_bezier) { // Use bezier curves for specific cases like LOOK (currently unused)
-                    ImVec2 cp1 = ImVec2(start_pos.x, start_pos.y + 50);
-                    ImVec2 cp2 = ImVec2(end_pos.x, end_pos.y - 50);
-                    draw_list->AddBezierCubic(start_pos, cp1, cp2, end_pos, color, 2.0f);
-                } else { // Use straight lines for everything else (sequential flow and labeled branches).
-                    draw_list->AddLine(start_pos, end_pos, color, 2.0f);
-                    if (label) draw_list->AddText(ImVec2(start_pos.x + (end_pos.x-start_pos.x)*0.2f, start_pos.y + (end_pos.y-start_pos.y)*0.2f - 15), color, label);
+    const int EDGE_MARGIN_COLUMNS = (int)(LONG_JUMP_DISTANCE_X / NODE_SPACING_X) + 1;
+    for_each_node(first_row - 1, last_row + 1, first_column - EDGE_MARGIN_COLUMNS, last_column + EDGE_MARGIN_COLUMNS, [&](int i) {
+        const ImVec2 node_pos = ImVec2(p.x + graph.node_positions[i].x, p.y + graph.node_positions[i].y);
+        for (int e = graph.edge_start[i]; e < graph.edge_start[i + 1]; e++) {
+            const GraphEdge& edge = graph.edges[e];
+            ImVec2 start_pos;
+            switch (edge.start) {
+                case EDGE_FROM_LEFT: start_pos = ImVec2(node_pos.x, node_pos.y + CONDITIONAL_NODE_SIZE.y * 0.5f); break;
+                case EDGE_FROM_RIGHT: start_pos = ImVec2(node_pos.x + CONDITIONAL_NODE_SIZE.x, node_pos.y + CONDITIONAL_NODE_SIZE.y * 0.5f); break;
+                default: start_pos = ImVec2(node_pos.x + 75, node_pos.y + 15); break;
+            }
+            ImVec2 end_pos;
+            if (edge.is_long_jump) { // For long jumps, draw a "GOTO N" node instead of a long line.
+                if (edge.start == EDGE_FROM_RIGHT) {
+                    // For a 'false' branch, the GOTO should be to the right.
+                    start_pos = ImVec2(start_pos.x + 20, start_pos.y + 25);
+                    end_pos = ImVec2(start_pos.x + 80.0f, start_pos.y + 35.0f);
+                } else {
+                    // For 'true' or unconditional jumps, the GOTO is straight down.
+                    end_pos = ImVec2(start_pos.x, start_pos.y + 60.0f);
                 }
+                draw_list->AddLine(start_pos, end_pos, edge.color, 2.0f);
+
+                // Draw the GOTO box with a background, border, and text.
+                std::string goto_text = "GOTO " + std::to_string(edge.target);
+                ImVec2 text_size = ImGui::CalcTextSize(goto_text.c_str());
+                ImVec2 rect_pos = ImVec2(end_pos.x - text_size.x / 2.0f - 5.0f, end_pos.y);
+                ImVec2 rect_end = ImVec2(rect_pos.x + text_size.x + 10, rect_pos.y + text_size.y + 4);
+                draw_list->AddRectFilled(rect_pos, rect_end, IM_COL32(30, 30, 30, 200), 3.0f);
+                draw_list->AddRect(rect_pos, rect_end, edge.color, 3.0f);
+                draw_list->AddText(ImVec2(rect_pos.x + 5, rect_pos.y + 2), IM_COL32(255, 255, 255, 255), goto_text.c_str());
+            } else {
+                end_pos = ImVec2(p.x + graph.node_positions[edge.target].x + 75, p.y + graph.node_positions[edge.target].y + 15);
+                draw_list->AddLine(start_pos, end_pos, edge.color, 2.0f);
+            }
 
-                // Draw a simple triangle arrow head at the end of the edge.
-                ImVec2 dir = ImVec2(end_pos.x - start_pos.x, end_pos.y - start_pos.y);
-                float len = sqrtf(dir.x*dir.x + dir.y*dir.y);
-                if (len > 0) {
-                    dir.x /= len; dir.y /= len;
-                    ImVec2 p1 = ImVec2(end_pos.x - dir.x * 10 - dir.y * 4, end_pos.y - dir.y * 10 + dir.x * 4);
-                    ImVec2 p2 = ImVec2(end_pos.x - dir.x * 10 + dir.y * 4, end_pos.y - dir.y * 10 - dir.x * 4);
-                    draw_list->AddTriangleFilled(end_pos, p1, p2, color);
-                }
+            // Draw a simple triangle arrow head at the end of the edge.
+            ImVec2 dir = ImVec2(end_pos.x - start_pos.x, end_pos.y - start_pos.y);
+            float len = sqrtf(dir.x*dir.x + dir.y*dir.y);
+            if (len > 0) {
+                dir.x /= len; dir.y /= len;
+                ImVec2 p1 = ImVec2(end_pos.x - dir.x * 10 - dir.y * 4, end_pos.y - dir.y * 10 + dir.x * 4);
+                ImVec2 p2 = ImVec2(end_pos.x - dir.x * 10 + dir.y * 4, end_pos.y - dir.y * 10 - dir.x * 4);
+                draw_list->AddTriangleFilled(end_pos, p1, p2, edge.color);
             }
-        };
-
-        // Determine which edges to draw based on the instruction type.
-        if (instruction == LOOK) {
-            draw_edge((i + 1) % genome.size(), IM_COL32(200, 200, 200, 150), ""); // Gray for "empty"
-            draw_edge((i + 2) % genome.size(), IM_COL32(0, 255, 0, 150), "");
-            draw_edge((i + 3) % genome.size(), IM_COL32(0, 0, 255, 150), "");
-        } else if (instruction >= JUMP_IF_EQUAL && instruction <= JUMP_IF_GREATER) {
-            ImVec2 node_pos = ImVec2(p.x + node_positions[i].x, p.y + node_positions[i].y);
-            ImVec2 node_size(200, 50);
-
-            // Define start points for true (bottom) and false (right) paths
-            ImVec2 true_start_pos = ImVec2(node_pos.x, node_pos.y + node_size.y * 0.5f);
-            ImVec2 false_start_pos = ImVec2(node_pos.x + node_size.x, node_pos.y + node_size.y * 0.5f);
-
-            int jump_offset = (i + 1 < genome.size()) ? (genome[i + 1] % 10) : 0;
-            draw_edge((i + jump_offset) % genome.size(), IM_COL32(0, 255, 0, 200), "", false, &true_start_pos);
-            draw_edge((i + 2) % genome.size(), IM_COL32(255, 0, 0, 200), "", false, &false_start_pos);
-        } else if (instruction >= JUMP && instruction <= MAX_INSTRUCTION_VALUE) {
-            int jump_offset = instruction;
-            draw_edge((i + jump_offset) % genome.size(), IM_COL32(255, 255, 255, 200));
-        } else {
-            draw_edge((i + 1) % genome.size(), IM_COL32(255, 255, 255, 150), nullptr, false, &default_start_pos);
         }
-    }
+    });
 
     // --- Pass 2: Draw Nodes ---
     // Nodes are drawn on top of the edges.
-    for (int i = 0; i < genome.size(); ++i) {
-        if (node_positions[i].x < 0) continue; // Skip non-reachable nodes
-
-        ImVec2 node_pos = ImVec2(p.x + node_positions[i].x, p.y + node_positions[i].y);
-        ImVec2 node_size(0, 0);
-
-        const unsigned int instruction = genome[i];
-        // Diamond shape for conditional nodes
-        bool is_conditional = (instruction == LOOK ||
-                               (instruction >= JUMP_IF_EQUAL && instruction <= JUMP_IF_GREATER));
-        
-        bool is_active = (i == current_pc);
-        ImU32 node_bg_color = IM_COL32(50, 50, 50, 255); // Default BG
+    for_each_node(first_row, last_row, first_column, last_column, [&](int i) {
+        ImVec2 node_pos = ImVec2(p.x + graph.node_positions[i].x, p.y + graph.node_positions[i].y);
+        bool is_conditional = isConditional(graph.genome[i]);
+        ImVec2 node_size = is_conditional ? CONDITIONAL_NODE_SIZE : NODE_SIZE;
+        bool is_active = (i == (int)current_pc);
 
         // Draw the node shape (diamond for conditionals, rectangle for others).
         if (is_conditional) {
-            node_size = ImVec2(200, 50);
             ImVec2 points[] = {
                 ImVec2(node_pos.x + node_size.x * 0.5f, node_pos.y),
                 ImVec2(node_pos.x + node_size.x, node_pos.y + node_size.y * 0.5f),
                 ImVec2(node_pos.x + node_size.x * 0.5f, node_pos.y + node_size.y),
                 ImVec2(node_pos.x, node_pos.y + node_size.y * 0.5f)
             };
-
-            // Check if this node is a target of a conditional jump to apply a green/red tint,
-            // but only if it's not a long jump (which is handled by GOTO coloring).
-            for (int j = 0; j < genome.size(); ++j) {
-                if (node_positions[j].x < 0) continue;
-                unsigned int source_instr = genome[j];
-                if (source_instr >= JUMP_IF_EQUAL && source_instr <= JUMP_IF_GREATER) {
-                    int jump_offset = (j + 1 < genome.size()) ? (genome[j + 1] % 10) : 0;
-                    int true_target = (j + jump_offset) % genome.size();
-                    int false_target = (j + 2) % genome.size();
-
-                    // Only color the node if it's NOT a long/backward jump (which will be a GOTO)
-                    // This logic must exactly match the heuristic in `draw_edge`.
-                    bool is_long_jump_true = (node_positions[true_target].y < node_positions[j].y - 100.0f) ||
-                                             (std::abs(node_positions[true_target].x - node_positions[j].x) > 400.0f);
-                    
-                    bool is_long_jump_false = (node_positions[false_target].y < node_positions[j].y - 100.0f) ||
-                                              (std::abs(node_positions[false_target].x - node_positions[j].x) > 400.0f);
-
-
-                    if (i == true_target && !is_long_jump_true) node_bg_color = IM_COL32(0, 60, 0, 255);
-                    else if (i == false_target && !is_long_jump_false) node_bg_color = IM_COL32(60, 0, 0, 255);
-                }
-            }
-
-            draw_list->AddConvexPolyFilled(points, 4, node_bg_color);
-            draw_list->AddPolyline(points, 4, IM_COL32(150, 150, 150, 255), ImDrawFlags_Closed, 1.0f);
+            draw_list->AddConvexPolyFilled(points, 4, graph.node_colors[i]);
+            draw_list->AddPolyline(points, 4, graph.node_borders[i], ImDrawFlags_Closed, 1.0f);
         } else {
-            node_size = ImVec2(200, 30); // Increased width for text
-            draw_list->AddRectFilled(node_pos, ImVec2(node_pos.x + node_size.x, node_pos.y + node_size.y), node_bg_color, 5.0f);
-            draw_list->AddRect(node_pos, ImVec2(node_pos.x + node_size.x, node_pos.y + node_size.y), IM_COL32(150, 150, 150, 255), 5.0f);
+            draw_list->AddRectFilled(node_pos, ImVec2(node_pos.x + node_size.x, node_pos.y + node_size.y), IM_COL32(50, 50, 50, 255), 5.0f);
+            draw_list->AddRect(node_pos, ImVec2(node_pos.x + node_size.x, node_pos.y + node_size.y), graph.node_borders[i], 5.0f);
         }
 
         // The currently active node gets a special yellow highlight.
         if (is_active) draw_list->AddRect(node_pos, ImVec2(node_pos.x + node_size.x, node_pos.y + node_size.y), IM_COL32(255, 255, 0, 255), 5.0f, 0, 2.0f);
 
         // Draw the instruction text centered inside the node.
-        std::string text = std::to_string(i) + ": " + getInstructionName(genome[i]);
-        if (instruction >= JUMP && instruction <= MAX_INSTRUCTION_VALUE) {
-            int jump_target = (i + instruction) % genome.size();
-            text = std::to_string(i) + ": JMP [" + std::to_string(jump_target) + "]";
-        } else {
-            text = std::to_string(i) + ": " + getInstructionName(instruction);
-        }
-        if (instruction >= JUMP && instruction <= MAX_INSTRUCTION_VALUE) {
-            int jump_target = (i + instruction) % genome.size();
-            text = std::to_string(i) + ": JMP [" + std::to_string(jump_target) + "]";
-        } else {
-            text = std::to_string(i) + ": " + getInstructionName(instruction);
-        }
+        const std::string& text = graph.labels[i];
         ImVec2 text_size = ImGui::CalcTextSize(text.c_str());
         ImVec2 text_pos = ImVec2(
             node_pos.x + (node_size.x - text_size.x) * 0.5f,
             node_pos.y + (node_size.y - text_size.y) * 0.5f
         );
+        draw_list->AddText(text_pos, is_active ? IM_COL32(255, 255, 0, 255) : IM_COL32(255, 255, 255, 255), text.c_str());
+    });
 
-        if (is_active) {
-            draw_list->AddText(text_pos, IM_COL32(255, 255, 0, 255), text.c_str());
-        } else {
-            draw_list->AddText(text_pos, IM_COL32(255, 255, 255, 255), text.c_str());
-        }
-
-        // Keep track of the graph's total size for scrolling.
-        max_x = std::max(max_x, node_pos.x + node_size.x);
-        max_y = std::max(max_y, node_pos.y + node_size.y);
-    }
+    drawGraphMinimap(p, view_min, view_max);
 
     // Create a dummy item with the total size of the graph to make the scrollbars work.
-    ImGui::Dummy(ImVec2(max_x - p.x + 50.0f, max_y - p.y + 50.0f));
+    ImGui::SetCursorScreenPos(p);
+    ImGui::Dummy(graph.extent);
+}
+
+/**
+ * @brief Draws an overview of the whole graph in the top-right corner of the graph view.
+ * The graph is shown as a fixed-size occupancy grid, so the cost does not grow with the genome.
+ * Clicking or dragging on the minimap scrolls the view there.
+ */
+void GenomeAnalyzer::drawGraphMinimap(ImVec2 origin, ImVec2 view_min, ImVec2 view_max) {
+    const GraphLayout& graph = *layout;
+    float graph_size = std::max(graph.extent.x, graph.extent.y);
+    if (graph_size <= 0.0f) return;
+    // Only worth it when the graph does not fit into the view.
+    if (graph.extent.x <= view_max.x - view_min.x && graph.extent.y <= view_max.y - view_min.y) return;
+
+    ImDrawList* draw_list = ImGui::GetWindowDrawList();
+    float scale = MINIMAP_SIZE / graph_size;
+    ImVec2 size = ImVec2(std::max(20.0f, graph.extent.x * scale), std::max(20.0f, graph.extent.y * scale));
+    ImVec2 corner = ImVec2(origin.x + view_max.x - size.x - 10.0f, origin.y + view_min.y + 10.0f);
+
+    draw_list->AddRectFilled(corner, ImVec2(corner.x + size.x, corner.y + size.y), IM_COL32(20, 20, 20, 220), 3.0f);
+    float cell = MINIMAP_SIZE / MINIMAP_CELLS;
+    for (int index : graph.minimap_cells) {
+        ImVec2 cell_pos = ImVec2(corner.x + (index % MINIMAP_CELLS) * cell, corner.y + (index / MINIMAP_CELLS) * cell);
+        draw_list->AddRectFilled(cell_pos, ImVec2(cell_pos.x + std::max(cell, 1.0f), cell_pos.y + std::max(cell, 1.0f)), IM_COL32(150, 150, 150, 255));
+    }
+    // The active instruction and the visible area.
+    unsigned int current_pc = sim_bot->getPC();
+    if (current_pc < graph.node_positions.size() && graph.node_positions[current_pc].x >= 0) {
+        ImVec2 pc_pos = ImVec2(corner.x + graph.node_positions[current_pc].x * scale, corner.y + graph.node_positions[current_pc].y * scale);
+        draw_list->AddCircleFilled(pc_pos, 3.0f, IM_COL32(255, 255, 0, 255));
+    }
+    draw_list->AddRect(ImVec2(corner.x + view_min.x * scale, corner.y + view_min.y * scale),
+                       ImVec2(corner.x + view_max.x * scale, corner.y + view_max.y * scale), IM_COL32(255, 255, 255, 200));
+    draw_list->AddRect(corner, ImVec2(corner.x + size.x, corner.y + size.y), IM_COL32(150, 150, 150, 255), 3.0f);
+
+    ImGui::SetCursorScreenPos(corner);
+    ImGui::InvisibleButton("GraphMinimap", size);
+    if (ImGui::IsItemActive()) {
+        // Center the view on the clicked point.
+        ImVec2 mouse = ImGui::GetMousePos();
+        float target_x = (mouse.x - corner.x) / scale - (view_max.x - view_min.x) * 0.5f;
+        float target_y = (mouse.y - corner.y) / scale - (view_max.y - view_min.y) * 0.5f;
+        ImGui::SetScrollX(std::max(0.0f, target_x));
+        ImGui::SetScrollY(std::max(0.0f, target_y));
+    }
 }
 
 // Draws the panel showing the bot's internal state.
@@ -460,16 +738,18 @@ void GenomeAnalyzer::drawBotState() {
     ImGui::Text("Position: (%.0f, %.0f)", sim_bot->getPosition().x, sim_bot->getPosition().y);
     ImGui::Text("Direction: %d", sim_bot->getDirection());
     ImGui::Text("PC: %d", sim_bot->getPC());
+    if (sim_bot->isInert()) {
+        ImGui::TextColored(ImVec4(0.67f, 0.35f, 1.0f, 1.0f), "Inert: trapped in an action-free loop");
+    }
 
     ImGui::Separator();
     ImGui::Text("Memory Stack (top to bottom):");
-    std::stack<unsigned int> mem_copy = sim_bot->getMemory();
-    if (mem_copy.empty()) {
+    const std::vector<unsigned int>& memory = sim_bot->getMemory();
+    if (memory.empty()) {
         ImGui::Text("<empty>");
     } else {
-        while(!mem_copy.empty()) {
-            ImGui::Text("%u", mem_copy.top());
-            mem_copy.pop();
+        for (auto value = memory.rbegin(); value != memory.rend(); ++value) {
+            ImGui::Text("%u", *value);
         }
     }
 }
@@ -581,10 +861,7 @@ void GenomeAnalyzer::drawBotVisualization() {
                     Bot* new_bot = nullptr;
                     switch (current_placement_mode) {
                         case PLACE_EMPTY_BOT: {
-                            new_bot = new Bot();
-                            auto& genome = const_cast<std::vector<unsigned int>&>(new_bot->getGenome());
-                            genome.clear();
-                            genome.push_back(PHOTOSYNTHIZE);
+                            new_bot = new Bot(std::vector<uint8_t>{PHOTOSYNTHIZE});
                             break;
                         }
                         case PLACE_RELATIVE:
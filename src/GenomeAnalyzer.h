@@ -3,6 +3,14 @@
 #include "imgui.h"
 #include "bot.h"
 #include "world.h"
+#include "genome_graph.h"
+#include "genome_analysis.h"
+#include "survival_evaluator.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
 
 /**
  * @class GenomeAnalyzer
@@ -26,9 +34,10 @@ public:
 
     /**
      * @brief Opens the analyzer window for a specific bot.
-     * @param bot A pointer to the bot to be analyzed.
+     * @param bot The bot to be analyzed. The analyzer keeps its own copy, so the bot does not
+     * have to outlive the call (it is usually taken from a simulation snapshot).
      */
-    void analyze(Bot* bot);
+    void analyze(const Bot& bot);
     /**
      * @brief Draws the Genome Analyzer window and all its components.
      * This is the main entry point to be called in the UI loop.
@@ -43,6 +52,11 @@ public:
      * @brief Closes the analyzer window and cleans up the local simulation.
      */
     void close();
+    /**
+     * @brief Sets the bots the survival estimate draws its neighbors from (e.g. a genome bank's).
+     * @param pool The bots, or nullptr (or none) for random neighbors. Applies to the next estimate.
+     */
+    void setNeighborPool(std::shared_ptr<const std::vector<Bot>> pool);
 
 private:
     /**
@@ -53,12 +67,33 @@ private:
     /**
      * @brief Builds the layout for the genome graph.
      * Performs a reachability analysis to determine node positions for a clear flow.
+     * Layouts are cached by genome, so reopening the analyzer on a clone is instant.
      */
     void buildGraphLayout();
     /**
      * @brief Advances the local simulation by a single step.
      */
     void step();
+    /**
+     * @brief Starts fast-forwarding the local simulation on a background thread.
+     * The run stops after run_max_steps steps, when the chosen condition is met, when the
+     * analyzed bot dies, or when it is cancelled. The UI leaves the local world alone meanwhile.
+     */
+    void startRun();
+    /** @brief Asks a background run to stop and waits for it. Does nothing if none is active. */
+    void cancelRun();
+    /** @brief The body of the background thread. */
+    void runUntilCondition();
+    /** @brief Checks the chosen stop condition against the current state of the analyzed bot. */
+    bool isRunConditionMet(int reproductions_before, int attacks_before) const;
+    /** @brief Draws the fast-forward controls, or the progress of the active run. */
+    void drawRunControls();
+    /** @brief Starts a Monte Carlo survival estimate of the analyzed genome on a background thread. */
+    void startSurvivalEstimate();
+    /** @brief Stops the survival estimate and waits for it. Does nothing if none is active. */
+    void cancelSurvivalEstimate();
+    /** @brief Draws the window with the survival estimate's settings, progress and results. */
+    void drawSurvivalWindow();
 
     // --- Constants ---
     static const int LOCAL_WORLD_SIZE = 11; ///< The width and height of the local simulation grid.
@@ -67,10 +102,57 @@ private:
     bool is_open = false;       ///< Flag indicating if the analyzer window is visible.
     bool is_paused = true;      ///< Flag indicating if the local simulation is paused.
 
-    Bot* original_bot = nullptr; ///< A pointer to the bot in the main simulation being analyzed.
+    Bot* original_bot = nullptr; ///< A copy of the bot from the main simulation being analyzed.
     Bot* sim_bot = nullptr;      ///< A deep copy of the original bot, used for the local simulation.
     World* local_world = nullptr;///< A small, self-contained world for the local simulation.
 
+    /// Watches the local world for the events of the analyzed bot.
+    struct BotEvents : public WorldObserver {
+        const Bot* bot = nullptr; ///< The analyzed bot, while it lives in the local world.
+        int reproductions = 0;
+        int attacks = 0;          ///< Attacks that killed a living bot.
+        bool died = false;
+        std::unique_ptr<Bot> final_state; ///< Copy taken at death, the world frees the bot itself.
+        void onReproduce(const Bot& parent, const Bot& child) override;
+        void onAttack(const Bot& attacker, const Bot& victim) override;
+        void onDeath(const Bot& bot) override;
+    };
+    BotEvents events;
+
+    // --- Fast-Forward ---
+    enum RunCondition {
+        RUN_STEPS,            ///< Only the step limit
+        RUN_UNTIL_REPRODUCE,
+        RUN_UNTIL_ATTACK,
+        RUN_UNTIL_DEATH,
+        RUN_UNTIL_PC,         ///< The bot is about to execute run_pc
+        RUN_UNTIL_MEMORY      ///< Top of the memory stack or its size compares to run_memory_value
+    };
+    enum MemoryOperand { MEMORY_OPERAND_TOP, MEMORY_OPERAND_SIZE };
+    enum Comparison { COMPARE_EQUAL, COMPARE_NOT_EQUAL, COMPARE_LESS, COMPARE_GREATER };
+    int run_condition = RUN_STEPS;
+    int run_max_steps = 1000;
+    int run_pc = 0;
+    int run_memory_operand = MEMORY_OPERAND_TOP;
+    int run_comparison = COMPARE_EQUAL;
+    int run_memory_value = 0;
+
+    std::thread run_thread;
+    std::atomic<bool> run_active{false};     ///< Set while the background thread owns the local world.
+    std::atomic<bool> run_cancel{false};
+    std::atomic<long long> run_progress{0};  ///< Steps done by the active run.
+    std::string run_result;                  ///< How the last run ended, written by the run's thread.
+
+    // --- Survival Estimate ---
+    bool show_survival_window = false;
+    EvaluationSettings survival_settings;
+    std::thread survival_thread;
+    std::atomic<bool> survival_active{false};
+    std::atomic<bool> survival_cancel{false};
+    std::atomic<int> survival_progress{0}; ///< Finished scenarios.
+    EvaluationReport survival_report;      ///< Written by the estimate's thread, read after it ended.
+    bool has_survival_report = false;
+
     // --- UI and Visualization Data ---
     ImVec2 bot_vis_pos;  ///< Screen position of the top-left corner of the bot visualization panel.
     ImVec2 bot_vis_size; ///< Size of the bot visualization panel.
@@ -85,11 +167,44 @@ private:
     };
     PlacementMode current_placement_mode = PLACE_NONE;
 
-    std::vector<ImVec2> node_positions; ///< Stores the calculated screen positions for each node in the genome graph.
+    /// Where an edge leaves its source node.
+    enum EdgeStart {
+        EDGE_FROM_CENTER, ///< Plain instructions and LOOK
+        EDGE_FROM_LEFT,   ///< "Taken" branch of a conditional jump
+        EDGE_FROM_RIGHT   ///< "Not taken" branch of a conditional jump
+    };
+    /// A drawable edge of the graph. Long jumps are drawn as a "GOTO N" box under the source.
+    struct GraphEdge {
+        int target;
+        ImU32 color;
+        EdgeStart start;
+        bool is_long_jump;
+    };
+    /// The control-flow graph of a genome and everything needed to draw it, computed once per genome.
+    struct GraphLayout {
+        std::vector<uint8_t> genome;
+        GenomeGraph graph;
+        GenomeAnalysis analysis;
+        std::vector<ImVec2> node_positions; ///< Position of each node, x < 0 for unreachable nodes.
+        std::vector<std::vector<int>> rows; ///< Reachable nodes of each depth, by increasing column.
+        std::vector<std::string> labels;    ///< Text shown in each node.
+        std::vector<ImU32> node_colors;     ///< Background of each node.
+        std::vector<ImU32> node_borders;    ///< Outline of each node, marks action-free loops and traps.
+        std::vector<GraphEdge> edges;       ///< Edges of node i are edges[edge_start[i]..edge_start[i + 1]).
+        std::vector<int> edge_start;
+        ImVec2 extent;                      ///< Size of the whole graph.
+        std::vector<int> minimap_cells;     ///< Occupied cells of the minimap grid (y * cells + x).
+        explicit GraphLayout(const std::vector<uint8_t>& genome);
+    };
+    static const int LAYOUT_CACHE_SIZE = 32; ///< Cached layouts kept before the cache is emptied.
+    std::shared_ptr<const GraphLayout> layout; ///< Layout of the analyzed bot's genome.
+    std::unordered_map<uint64_t, std::shared_ptr<const GraphLayout>> layout_cache; ///< Keyed by genome hash.
 
     // --- Drawing Sub-routines ---
     /** @brief Draws the interactive control-flow graph of the bot's genome. */
     void drawGenomeGraph();
+    /** @brief Draws the overview of the whole graph; view_min/max is the visible area in graph coordinates. */
+    void drawGraphMinimap(ImVec2 origin, ImVec2 view_min, ImVec2 view_max);
     /** @brief Draws the current state of the simulated bot (energy, memory, etc.). */
     void drawBotState();
     /** @brief Draws the control buttons (Run, Pause, Step, Reset). */
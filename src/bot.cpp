@@ -2,30 +2,27 @@
 #include <world.h>
 #include <algorithm>
 #include "instructions.h"
+#include "genome_diff.h"
+#include "genome_graph.h"
 #include <stdexcept>
+#include <cstring>
+#include <climits>
 
 
 Bot::Bot() {
-    this->color = {
-        (unsigned char)GetRandomValue(50, 200),
-        (unsigned char)GetRandomValue(50, 200),
-        (unsigned char)GetRandomValue(50, 200),
-        255
-    };
-    this->genome.reserve(INITIAL_GENOME_SIZE);
-    _initRandomGenome();
+    Random random(((uint64_t)(unsigned int)GetRandomValue(0, INT_MAX) << 32) | (unsigned int)GetRandomValue(0, INT_MAX));
+    _initRandom(random);
 }
 
-Vector2 Bot::getPosition() {
-    return this->position;
+Bot::Bot(Random& random) {
+    _initRandom(random);
 }
 
-int Bot::getEnergy() const { return this->energy; }
-Color Bot::getColor() const { return this->color; }
+Bot::Bot(std::vector<uint8_t> genome) : genome(std::move(genome)) {}
 
 int Bot::getAge() const { return this->age; }
-const std::vector<unsigned int>& Bot::getGenome() const { return this->genome; }
-const std::stack<unsigned int>& Bot::getMemory() const { return this->memory; }
+const std::vector<uint8_t>& Bot::getGenome() const { return this->genome; }
+const std::vector<unsigned int>& Bot::getMemory() const { return this->memory; }
 unsigned int Bot::getPC() const { return this->pc; }
 unsigned int Bot::getDirection() const { return this->direction; }
 
@@ -33,12 +30,31 @@ void Bot::addEnergy(int amount) {
     this->energy = std::min(MAX_ENERGY, this->energy + amount);
 }
 
-void Bot::_initRandomGenome() {
+void Bot::_initRandom(Random& random) {
+    this->color = {
+        (unsigned char)random.next(50, 200),
+        (unsigned char)random.next(50, 200),
+        (unsigned char)random.next(50, 200),
+        255
+    };
+    this->genome.reserve(INITIAL_GENOME_SIZE);
     for(int i = 0; i < INITIAL_GENOME_SIZE; i++) {
-        this->genome.push_back(GetRandomValue(0, MAX_INSTRUCTION_VALUE)); // Instructions are 0..127 (128 total)
+        this->genome.push_back((uint8_t)random.next(0, MAX_INSTRUCTION_VALUE)); // Instructions are 0..127 (128 total)
     }
 }
 
+void Bot::resetLife() {
+    this->energy = INITIAL_ENERGY;
+    this->age = 0;
+    this->memory.clear();
+    this->pc = 0;
+    this->direction = 1;
+    this->nutrition_balance = 0;
+    this->scavenge_points = 0;
+    this->idle_steps = 0;
+    this->inert = false;
+}
+
 void Bot::_move(int relative_index, World& world) {
     // relative_index: number from 0 to 7, 0 being top-left, 7 being left, clockwise
     if ((relative_index < 0) || (relative_index > 7)) {
@@ -121,10 +137,10 @@ void Bot::_turn(int relative_index) {
     this->direction %= 8;
 }
 
-void Bot::_look(int relative_index, World& world) {
+int Bot::_look(int relative_index, World& world) {
     // relative_index: number from 0 to 7, 0 being top-left, 7 being left, clockwise
     if ((relative_index < 0) || (relative_index > 7)) {
-        return;
+        return LOOK_EMPTY_OFFSET;
     }
     int RELATIVE_INDEX_TO_OFFSET[] = {
         0,  // 0: Forward (0 degrees)
@@ -160,13 +176,11 @@ void Bot::_look(int relative_index, World& world) {
     Bot* target_bot_ptr = world.getBotAt(target_pos);
     if (target_bot_ptr != nullptr) {
         if (target_bot_ptr->isOrganic) {
-            this->pc += 3; // It's organic matter
-        } else {
-            this->pc += 2; // It's another living bot
+            return LOOK_ORGANIC_OFFSET; // It's organic matter
         }
-    } else {
-        this->pc += 1; // It's empty
+        return LOOK_BOT_OFFSET; // It's another living bot
     }
+    return LOOK_EMPTY_OFFSET; // It's empty
 }
 
 void Bot::_attack(int relative_index, World& world) {
@@ -213,22 +227,21 @@ void Bot::_attack(int relative_index, World& world) {
     if (target_bot_ptr != nullptr && target_bot_ptr != this && !target_bot_ptr->isOrganic) {
         this->nutrition_balance = std::max(-20, this->nutrition_balance - 10); // Become more carnivorous
         this->scavenge_points = std::max(0, this->scavenge_points - 2); // Attacking is not scavenging
+        if (world.getObserver()) world.getObserver()->onAttack(*this, *target_bot_ptr);
         target_bot_ptr->die(world); // The attacked bot becomes organic matter
     }
 }
 
-int Bot::_genomeDifference(const Bot& other) const {
-    int differences = 0;
-    size_t min_size = std::min(this->genome.size(), other.genome.size());
-    size_t max_size = std::max(this->genome.size(), other.genome.size());
+int Bot::genomeDifference(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+    return ::genomeDifference(a.data(), a.size(), b.data(), b.size());
+}
 
-    for (size_t i = 0; i < min_size; ++i) {
-        if (this->genome[i] != other.genome[i]) {
-            differences++;
-        }
-    }
+bool Bot::areRelatives(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+    return genomeDifferenceBounded(a.data(), a.size(), b.data(), b.size(), RELATIVE_GENOME_DIFFERENCE) < RELATIVE_GENOME_DIFFERENCE;
+}
 
-    return differences + (max_size - min_size);
+int Bot::_genomeDifference(const Bot& other) const {
+    return genomeDifference(this->genome, other.genome);
 }
 
 int Bot::genomeDifference(const Bot& other) const {
@@ -251,7 +264,7 @@ void Bot::_checkRelative(int relative_index, World& world) {
 
     Bot* target_bot = world.getBotAt(target_pos);
     if (target_bot != nullptr && target_bot != this) {
-        if (_genomeDifference(*target_bot) < 5) {
+        if (areRelatives(this->genome, target_bot->genome)) {
             _memoryPush(1);
             return;
         }
@@ -282,6 +295,7 @@ void Bot::_shareEnergy(int relative_index, World& world) {
     if (target_bot != nullptr && target_bot != this) {
         this->energy -= energy_to_share;
         target_bot->addEnergy(energy_to_share);
+        world.botEnergyChanged(target_bot);
     }
 }
 
@@ -325,10 +339,11 @@ Vector2 Bot::_findEmptyAdjacentCell(World &world) {
         {-1,  1}, { 0,  1}, { 1,  1}  // SW, S, SE
     };
 
-    // Fisher-Yates shuffle using raylib's pseudo-random number generator
+    // Fisher-Yates shuffle using the world's pseudo-random number generator
     // to ensure determinism with a given seed.
+    Random& random = world.getRandom();
     for (size_t i = directions.size() - 1; i > 0; --i) {
-        int j = GetRandomValue(0, (int)i);
+        int j = random.next(0, (int)i);
         std::swap(directions[i], directions[j]);
     }
 
@@ -359,48 +374,72 @@ void Bot::_reproduce(World& world) {
     int childEnergy = this->energy / 2;
     this->energy = childEnergy;
 
-    Bot* child = new Bot();
+    Random& random = world.getRandom();
+    Bot* child = new Bot(this->genome); // A deep copy of the parent's genome
     child->position = spawnPosition;
     child->energy = childEnergy;
     child->color = this->color;
     child->nutrition_balance = 0; // Child starts with a neutral dietary balance
-    child->genome = this->genome; // This performs a deep copy of the parent's genome
+    child->parent_id = this->lineage_id;
+    child->founder_id = this->founder_id;
 
     // --- Genome Size Mutation ---
     // Insertion
-    if (GetRandomValue(1, 10000) <= (int)(GENOME_INSERTION_RATE * 10000.0f) && child->genome.size() < MAX_GENOME_SIZE) {
-        int insertion_point = GetRandomValue(0, (int)child->genome.size());
-        child->genome.insert(child->genome.begin() + insertion_point, GetRandomValue(0, MAX_INSTRUCTION_VALUE));
+    if (random.next(1, 10000) <= (int)(GENOME_INSERTION_RATE * 10000.0f) && child->genome.size() < MAX_GENOME_SIZE) {
+        int insertion_point = random.next(0, (int)child->genome.size());
+        child->genome.insert(child->genome.begin() + insertion_point, (uint8_t)random.next(0, MAX_INSTRUCTION_VALUE));
+        child->mutation_count++;
     }
 
     // Deletion
-    if (GetRandomValue(1, 10000) <= (int)(GENOME_DELETION_RATE * 10000.0f) && child->genome.size() > MIN_GENOME_SIZE) {
-        int deletion_point = GetRandomValue(0, child->genome.size() - 1);
+    if (random.next(1, 10000) <= (int)(GENOME_DELETION_RATE * 10000.0f) && child->genome.size() > MIN_GENOME_SIZE) {
+        int deletion_point = random.next(0, child->genome.size() - 1);
         child->genome.erase(child->genome.begin() + deletion_point);
+        child->mutation_count++;
     }
 
     // --- Gene Value Mutation ---
     for (int i = 0; i < child->genome.size(); i++) {
         // Check for genome mutation.
-        if (GetRandomValue(1, 10000) <= (int)(MUTATION_RATE * 10000.0f)) {
-            child->genome[i] = GetRandomValue(0, MAX_INSTRUCTION_VALUE);
+        if (random.next(1, 10000) <= (int)(MUTATION_RATE * 10000.0f)) {
+            child->genome[i] = (uint8_t)random.next(0, MAX_INSTRUCTION_VALUE);
+            child->mutation_count++;
 
             // If a gene mutates, also mutate the color slightly.
-            child->color.r = std::clamp(child->color.r + GetRandomValue(-COLOR_MUTATION_AMOUNT, COLOR_MUTATION_AMOUNT), 0, 255);
-            child->color.g = std::clamp(child->color.g + GetRandomValue(-COLOR_MUTATION_AMOUNT, COLOR_MUTATION_AMOUNT), 0, 255);
-            child->color.b = std::clamp(child->color.b + GetRandomValue(-COLOR_MUTATION_AMOUNT, COLOR_MUTATION_AMOUNT), 0, 255);
+            child->color.r = std::clamp(child->color.r + random.next(-COLOR_MUTATION_AMOUNT, COLOR_MUTATION_AMOUNT), 0, 255);
+            child->color.g = std::clamp(child->color.g + random.next(-COLOR_MUTATION_AMOUNT, COLOR_MUTATION_AMOUNT), 0, 255);
+            child->color.b = std::clamp(child->color.b + random.next(-COLOR_MUTATION_AMOUNT, COLOR_MUTATION_AMOUNT), 0, 255);
         }
     }
 
+    // An unmutated child runs the same program, so it shares the analysis.
+    if (child->mutation_count == 0) child->control_flow = this->control_flow;
+
     world.addBot(child);
+    if (world.getObserver()) world.getObserver()->onReproduce(*this, *child);
+}
+
+const ControlFlowSummary& Bot::getControlFlow() const {
+    if (!this->control_flow) {
+        this->control_flow = std::make_shared<const ControlFlowSummary>(summarizeControlFlow(this->genome));
+    }
+    return *this->control_flow;
+}
+
+int Bot::getDiet() const {
+    // Same classification as the nutrition view mode.
+    if (this->nutrition_balance > 0) return DIET_PHOTOSYNTHESIS;
+    if (this->nutrition_balance == 0 && this->scavenge_points == 0) return DIET_NEUTRAL;
+    if (this->scavenge_points > -this->nutrition_balance) return DIET_SCAVENGING;
+    return DIET_HUNTING;
 }
 
 void Bot::setPosition(Vector2 pos) {
     this->position = pos;
 }
 
-void Bot::render(int view_mode) {
-    this->render(view_mode, 255); // Call the main render function with full opacity
+Color Bot::getRenderColor(int view_mode) const {
+    return this->getRenderColor(view_mode, 255); // Call the main function with full opacity
 }
 
 int Bot::getGenomeSize() const {
@@ -411,13 +450,13 @@ int Bot::getMemorySize() const {
     return this->memory.size();
 }
 
-void Bot::render(int view_mode, unsigned char alpha_override) {
+// Returns the color of this bot's cell for the given view mode. The alpha channel carries
+// the energy level (and the dimming override), the renderer blends it over the background.
+Color Bot::getRenderColor(int view_mode, unsigned char alpha_override) const {
     Color render_color = this->color;
 
     if (this->isOrganic) {
-        float margin = CELL_SIZE / 4.0f;
-        DrawRectangle(this->position.x * CELL_SIZE + margin, this->position.y * CELL_SIZE + margin, CELL_SIZE - margin * 2, CELL_SIZE - margin * 2, {GRAY.r, GRAY.g, GRAY.b, alpha_override});
-        return;
+        return {GRAY.r, GRAY.g, GRAY.b, alpha_override};
     }
 
     switch (view_mode) {
@@ -444,131 +483,79 @@ void Bot::render(int view_mode, unsigned char alpha_override) {
             break;
     }
 
-    DrawRectangle(this->position.x * CELL_SIZE, this->position.y * CELL_SIZE, CELL_SIZE, CELL_SIZE, render_color);
+    return render_color;
 }
 
 void Bot::_processGenome(World &world) {
     this->pc %= this->genome.size();
     unsigned int instruction = this->genome[this->pc];
+    const InstructionInfo& info = getInstructionInfo(instruction);
+    this->idle_steps = info.action ? 0 : this->idle_steps + 1;
+
+    // Operands come off the memory stack, the most recently pushed first.
+    unsigned int operands[2] = {0, 0};
+    for (int i = 0; i < info.operands; i++) {
+        operands[i] = _memoryPop();
+    }
+
+    int look_offset = LOOK_EMPTY_OFFSET;
+    bool jump_taken = false;
+    switch (getOpcode(instruction)) {
+        case MOVE: this->_move(operands[0] % 8, world); break;
+        case TURN: this->_turn(operands[0] % 8); break;
+        case LOOK: look_offset = this->_look(operands[0] % 8, world); break;
+        case ATTACK: this->_attack(operands[0] % 8, world); break;
+        case PHOTOSYNTHIZE: this->_photosynthize(world); break;
+        case CHECK_RELATIVE: this->_checkRelative(operands[0] % 8, world); break;
+        case SHARE_ENERGY: this->_shareEnergy(operands[0] % 8, world); break;
+        case CONSUME_ORGANIC: this->_consumeOrganic(operands[0] % 8, world); break;
+        case REPRODUCE: this->_reproduce(world); break;
+        case CHECK_BIOME: this->_checkBiome(world); break;
+        case CHECK_X: this->_checkX(); break;
+        case CHECK_Y: this->_checkY(); break;
+        case CHECK_ENERGY: this->_checkEnergy(); break;
+        case CHECK_AGE: this->_checkAge(); break;
+        case JUMP_IF_EQUAL: jump_taken = operands[0] == operands[1]; break;
+        case JUMP_IF_NOT_EQUAL: jump_taken = operands[0] != operands[1]; break;
+        case JUMP_IF_GREATER: jump_taken = operands[1] > operands[0]; break; // Second from top > top
+        case JUMP: break;
+    }
+
+    switch (info.flow) {
+        case FLOW_NEXT:
+            this->pc++;
+            break;
+        case FLOW_LOOK:
+            this->pc += look_offset;
+            break;
+        case FLOW_CONDITIONAL:
+            // A jump that is not taken skips its parameter gene.
+            this->pc += jump_taken ? conditionalJumpOffset(this->genome, this->pc) : CONDITIONAL_FALLTHROUGH_OFFSET;
+            break;
+        case FLOW_JUMP:
+            this->pc += instruction;
+            this->pc %= this->genome.size();
+            break;
+    }
+}
 
-    // 0 Move Relative
-    if (instruction == MOVE) {
-        this->_move(_memoryPop() % 8, world);
-        this->pc++;
-    }
-    // 1 Turn Relatively
-    else if (instruction == TURN) {
-        this->_turn(_memoryPop() % 8);
-        this->pc++;
-    }
-    // 2 Look Relatively
-    else if (instruction == LOOK) {
-        this->_look(_memoryPop() % 8, world);
-        // pc is incremented inside _look
-    }
-    // 3 Attack relatively
-    else if (instruction == ATTACK) {
-        this->_attack(_memoryPop() % 8, world);
-        this->pc++;
-    }
-    // 4 Photosynthize (free energy)
-    else if (instruction == PHOTOSYNTHIZE) {
-        int energy_gain = PHOTOSYNTHIZE_ENERGY_GAIN; // Balanced biome (center)
-        float bot_x = this->position.x;
-
-        if (bot_x < WORLD_WIDTH / 3.0f) {
-            energy_gain = HIGH_PHOTOSYNTHIZE_ENERGY_GAIN; // Sunny biome (left)
-        } else if (bot_x >= 2.0f * WORLD_WIDTH / 3.0f) {
-            energy_gain = LOW_PHOTOSYNTHIZE_ENERGY_GAIN; // Dark biome (right)
-        }
+void Bot::_photosynthize(World& world) {
+    int energy_gain = PHOTOSYNTHIZE_ENERGY_GAIN; // Balanced biome (center)
+    int biome = world.getBiome(this->position.x);
 
-        this->energy = std::min(MAX_ENERGY, this->energy + energy_gain);
-        this->nutrition_balance = std::min(20, this->nutrition_balance + 1); // Become more vegetarian
-        this->scavenge_points = std::max(0, this->scavenge_points - 1); // Photosynthesis is not scavenging
-        this->pc++;
-    }
-    // 5 Check if neighbor is a relative
-    else if (instruction == CHECK_RELATIVE) {
-        this->_checkRelative(_memoryPop() % 8, world);
-        this->pc++;
-    }
-    // 6 Share energy with neighbor
-    else if (instruction == SHARE_ENERGY) {
-        this->_shareEnergy(_memoryPop() % 8, world);
-        this->pc++;
-    }
-    // 7 Consume Organic
-    else if (instruction == CONSUME_ORGANIC) {
-        this->_consumeOrganic(_memoryPop() % 8, world);
-        this->pc++;
-    }
-    // 8 Reproduce
-    else if (instruction == REPRODUCE) {
-        this->_reproduce(world);
-        this->pc++;
-    }
-    // 17+: Unconditional Jump (using instruction value as offset)
-    else if (instruction >= JUMP) {
-        this->pc += instruction;
-        this->pc %= this->genome.size();
-    }
-    // Check biome
-    else if (instruction == CHECK_BIOME) {
-        this->_checkBiome();
-        this->pc++;
-    }
-    // Check X coordinate
-    else if (instruction == CHECK_X) {
-        this->_checkX();
-        this->pc++;
-    }
-    // Check Y coordinate
-    else if (instruction == CHECK_Y) {
-        this->_checkY();
-        this->pc++;
-    }
-    // Check Energy Level
-    else if (instruction == CHECK_ENERGY) {
-        this->_checkEnergy();
-        this->pc++;
-    }
-    // Check Age
-    else if (instruction == CHECK_AGE) {
-        this->_checkAge();
-        this->pc++;
-    }
-    // Jump If Equal (JE)
-    else if (instruction == JUMP_IF_EQUAL) {
-        if (_memoryPop() == _memoryPop()) {
-            this->pc += this->genome[(this->pc + 1) % this->genome.size()] % 10;
-        } else {
-            this->pc += 2; // Skip the jump parameter
-        }
-    }
-    // Jump If Not Equal (JNE)
-    else if (instruction == JUMP_IF_NOT_EQUAL) {
-        if (_memoryPop() != _memoryPop()) {
-            this->pc += this->genome[(this->pc + 1) % this->genome.size()] % 10;
-        } else {
-            this->pc += 2; // Skip the jump parameter
-        }
-    }
-    // Jump If Greater Than (JG)
-    else if (instruction == JUMP_IF_GREATER) {
-        unsigned int val2 = _memoryPop();
-        unsigned int val1 = _memoryPop();
-        if (val1 > val2) {
-            this->pc += this->genome[(this->pc + 1) % this->genome.size()] % 10;
-        } else {
-            this->pc += 2; // Skip the jump parameter
-        }
+    if (biome == BIOME_SUNNY) {
+        energy_gain = HIGH_PHOTOSYNTHIZE_ENERGY_GAIN; // Sunny biome (left)
+    } else if (biome == BIOME_DARK) {
+        energy_gain = LOW_PHOTOSYNTHIZE_ENERGY_GAIN; // Dark biome (right)
     }
+
+    this->energy = std::min(MAX_ENERGY, this->energy + energy_gain);
+    this->nutrition_balance = std::min(20, this->nutrition_balance + 1); // Become more vegetarian
+    this->scavenge_points = std::max(0, this->scavenge_points - 1); // Photosynthesis is not scavenging
 }
 
-void Bot::_checkBiome() {
-    if (this->position.x < WORLD_WIDTH / 3.0f) _memoryPush(1); // Sunny biome
-    else if (this->position.x < 2.0f * WORLD_WIDTH / 3.0f) _memoryPush(2); // Balanced biome
-    else _memoryPush(3); // Dark biome
+void Bot::_checkBiome(World& world) {
+    _memoryPush(world.getBiome(this->position.x) + 1); // 1 sunny, 2 balanced, 3 dark
 }
 
 void Bot::_checkX() {
@@ -619,65 +606,148 @@ void Bot::process(World& world) {
         return;
     }
 
+    // A bot stuck in an action-free loop would only shuffle its pc and memory until it starves.
+    // Bots that act now and then never need the analysis; an action reachable from the pc is
+    // at most a genome length away, so only bots idle for longer are checked.
+    if (this->inert) return;
+    if (this->idle_steps >= (int)this->genome.size() &&
+        getControlFlow().trapped[this->pc % this->genome.size()]) {
+        this->inert = true;
+        return;
+    }
+
     this->_processGenome(world);
 }
 
 void Bot::die(World& world) {
     this->isOrganic = true;
+    world.botBecameOrganic(this);
     // The corpse retains the energy the bot had at the moment of death.
 }
 
 void Bot::_memoryPush(unsigned int value) {
     if (this->memory.size() < MEMORY_SIZE) {
-        this->memory.push(value);
+        this->memory.push_back(value);
     }
 }
 
 unsigned int Bot::_memoryPop() {
     if (!this->memory.empty()) {
-        unsigned int temp = this->memory.top();
-        this->memory.pop();
+        unsigned int temp = this->memory.back();
+        this->memory.pop_back();
         return temp;
     } else {
         return 0;
     }
 }
 
-void Bot::serialize(std::ofstream& out) {
-    out.write(reinterpret_cast<char*>(&position), sizeof(position));
-    out.write(reinterpret_cast<char*>(&energy), sizeof(energy));
-    out.write(reinterpret_cast<char*>(&age), sizeof(age));
-    
-    size_t genome_size = genome.size();
-    out.write(reinterpret_cast<char*>(&genome_size), sizeof(genome_size));
-    out.write(reinterpret_cast<char*>(genome.data()), genome_size * sizeof(unsigned int));
-
-    out.write(reinterpret_cast<char*>(&pc), sizeof(pc));
-    out.write(reinterpret_cast<char*>(&color), sizeof(color));
-    out.write(reinterpret_cast<char*>(&direction), sizeof(direction));
-    out.write(reinterpret_cast<char*>(&is_dead), sizeof(is_dead));
-    out.write(reinterpret_cast<char*>(&isOrganic), sizeof(isOrganic));
-    out.write(reinterpret_cast<char*>(&nutrition_balance), sizeof(nutrition_balance));
-    out.write(reinterpret_cast<char*>(&scavenge_points), sizeof(scavenge_points));
-}
-
-void Bot::deserialize(std::ifstream& in) {
-    in.read(reinterpret_cast<char*>(&position), sizeof(position));
-    in.read(reinterpret_cast<char*>(&energy), sizeof(energy));
-    in.read(reinterpret_cast<char*>(&age), sizeof(age));
-
-    size_t genome_size;
-    in.read(reinterpret_cast<char*>(&genome_size), sizeof(genome_size));
-    genome.resize(genome_size);
-    in.read(reinterpret_cast<char*>(genome.data()), genome_size * sizeof(unsigned int));
-
-    in.read(reinterpret_cast<char*>(&pc), sizeof(pc));
-    in.read(reinterpret_cast<char*>(&color), sizeof(color));
-    in.read(reinterpret_cast<char*>(&direction), sizeof(direction));
-    in.read(reinterpret_cast<char*>(&is_dead), sizeof(is_dead));
-    in.read(reinterpret_cast<char*>(&isOrganic), sizeof(isOrganic));
-    in.read(reinterpret_cast<char*>(&nutrition_balance), sizeof(nutrition_balance));
-    in.read(reinterpret_cast<char*>(&scavenge_points), sizeof(scavenge_points));
+void Bot::serialize(ByteWriter& out) const {
+    out.putVarint((uint64_t)this->position.x);
+    out.putVarint((uint64_t)this->position.y);
+    out.putSignedVarint(this->energy);
+    out.putVarint((uint64_t)this->age);
+    out.putVarint(this->pc);
+    out.putBytes(&this->color, 4);
+    out.putU8((uint8_t)this->direction);
+    out.putU8((uint8_t)(this->is_dead | (this->isOrganic << 1) | (this->inert << 2)));
+    out.putSignedVarint(this->nutrition_balance);
+    out.putSignedVarint(this->scavenge_points);
+    // Version 2: the rest of the state, so a loaded world goes on exactly as the saved one
+    out.putVarint((uint64_t)this->idle_steps);
+    out.putVarint(this->memory.size()); // Bottom first
+    for (unsigned int value : this->memory) out.putVarint(value);
+    out.putVarint(this->lineage_id);
+    out.putVarint(this->parent_id);
+    out.putVarint(this->founder_id);
+    out.putVarint((uint64_t)this->mutation_count);
+}
+
+bool Bot::deserialize(ByteReader& in, int version) {
+    this->position.x = (float)in.getVarint();
+    this->position.y = (float)in.getVarint();
+    this->energy = (int)in.getSignedVarint();
+    this->age = (int)in.getVarint();
+    this->pc = (unsigned int)in.getVarint();
+    const uint8_t* color = in.getBytes(4);
+    if (color) this->color = {color[0], color[1], color[2], color[3]};
+    this->direction = in.getU8() % 8;
+    uint8_t flags = in.getU8();
+    this->is_dead = flags & 1;
+    this->isOrganic = (flags >> 1) & 1;
+    this->nutrition_balance = (int)in.getSignedVarint();
+    this->scavenge_points = (int)in.getSignedVarint();
+    if (version < 2) return !in.failed(); // The rest starts out as in a newborn
+
+    this->inert = (flags >> 2) & 1;
+    this->idle_steps = (int)std::min(in.getVarint(), (uint64_t)INT_MAX);
+    uint64_t memory_size = in.getVarint();
+    if (memory_size > MEMORY_SIZE) return false;
+    this->memory.resize((size_t)memory_size);
+    for (unsigned int& value : this->memory) value = (unsigned int)in.getVarint();
+    this->lineage_id = in.getVarint();
+    this->parent_id = in.getVarint();
+    this->founder_id = in.getVarint();
+    this->mutation_count = (int)std::min(in.getVarint(), (uint64_t)INT_MAX);
+    return !in.failed();
+}
+
+bool Bot::deserializeLegacy(ByteReader& in) {
+    // Raw little-endian fields: Vector2 position, int energy, int age, size_t genome size,
+    // 4 bytes per gene, unsigned pc, Color, unsigned direction, bool is_dead, bool isOrganic,
+    // int nutrition_balance, int scavenge_points.
+    uint32_t x = in.getU32();
+    uint32_t y = in.getU32();
+    memcpy(&this->position.x, &x, sizeof(float));
+    memcpy(&this->position.y, &y, sizeof(float));
+    this->energy = (int)in.getU32();
+    this->age = (int)in.getU32();
+    uint64_t genome_size = in.getU32();
+    genome_size |= (uint64_t)in.getU32() << 32;
+    if (genome_size < MIN_GENOME_SIZE || genome_size > MAX_GENOME_SIZE) return false;
+    this->genome.resize((size_t)genome_size);
+    for (uint8_t& gene : this->genome) gene = (uint8_t)(in.getU32() % (MAX_INSTRUCTION_VALUE + 1));
+    this->pc = in.getU32();
+    const uint8_t* color = in.getBytes(4);
+    if (color) this->color = {color[0], color[1], color[2], color[3]};
+    this->direction = in.getU32() % 8;
+    this->is_dead = in.getU8() != 0;
+    this->isOrganic = in.getU8() != 0;
+    this->nutrition_balance = (int)in.getU32();
+    this->scavenge_points = (int)in.getU32();
+    return !in.failed();
+}
+
+bool Bot::saveToFile(const std::string& filename) const {
+    ByteWriter out;
+    beginSaveFile(out, SAVE_MAGIC_BOT);
+    writeGenome(out, this->genome);
+    serialize(out);
+    finishSaveFile(out);
+    return writeFile(filename, out.getBytes());
+}
+
+Bot* Bot::loadFromFile(const std::string& filename) {
+    MappedFile file(filename);
+    if (!file.isOpen()) return nullptr;
+
+    int version = 0;
+    bool is_legacy = false;
+    std::vector<uint8_t> decompressed;
+    ByteReader in = openSaveFile(file.data(), file.size(), SAVE_MAGIC_BOT, version, is_legacy, decompressed);
+    Bot* bot = new Bot(std::vector<uint8_t>());
+    if (is_legacy) {
+        ByteReader legacy(file.data(), file.size());
+        if (bot->deserializeLegacy(legacy)) return bot;
+        delete bot;
+        return nullptr;
+    }
+
+    if (!readGenome(in, bot->genome) || !bot->deserialize(in, version)) {
+        delete bot;
+        return nullptr;
+    }
+    bot->clearLineage(); // It belongs to the world the bot was saved from
+    return bot;
 }
 
 void Bot::_constrainPosition() {
@@ -1,8 +1,13 @@
 #include <raylib.h>
 #include <vector>
 #include <config.h>
-#include <fstream>
-#include <stack>
+#include <string>
+#include <cstdint>
+#include "census.h"
+#include "random.h"
+#include "genome_analysis.h"
+#include "save_format.h"
+#include <memory>
 #pragma once
 
 class World; // Forward declaration
@@ -10,33 +15,65 @@ class World; // Forward declaration
 class Bot {
 public:
     Bot(const Bot& other) = default; // Add default copy constructor
-    Bot();
-    void render(int view_mode);
-    void render(int view_mode, unsigned char alpha_override);
+    Bot(); // A random bot drawn from raylib's generator, for bots made outside of a world
+    explicit Bot(Random& random); // A random bot drawn from the given generator
+    explicit Bot(std::vector<uint8_t> genome); // A newborn running genome, without consuming random values
+    Color getRenderColor(int view_mode) const;
+    Color getRenderColor(int view_mode, unsigned char alpha_override) const;
     void process(World& world);
-    Vector2 getPosition();
-    int getEnergy() const;
-    Color getColor() const;
+    Vector2 getPosition() const { return this->position; }
+    int getEnergy() const { return this->energy; }
+    Color getColor() const { return this->color; }
     int getAge() const;
-    const std::vector<unsigned int>& getGenome() const;
-    const std::stack<unsigned int>& getMemory() const;
+    const std::vector<uint8_t>& getGenome() const;
+    const std::vector<unsigned int>& getMemory() const; // The memory stack, bottom first
     int genomeDifference(const Bot& other) const;
+    static int genomeDifference(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b);
+    static bool areRelatives(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b); // Difference < RELATIVE_GENOME_DIFFERENCE
     unsigned int getPC() const;
     int getGenomeSize() const;
     int getMemorySize() const;
     unsigned int getDirection() const;
+    // Lineage: the id is assigned by World::addBot, the parent id and mutation count by whoever
+    // creates the bot (see _reproduce). Founders have parent id 0.
+    uint64_t getLineageId() const { return this->lineage_id; }
+    uint64_t getParentId() const { return this->parent_id; }
+    uint64_t getFounderId() const { return this->founder_id; } // Lineage id of the first ancestor, identifies the clade
+    int getMutationCount() const { return this->mutation_count; }
+    void setLineageId(uint64_t id) { this->lineage_id = id; if (this->founder_id == 0) this->founder_id = id; }
+    void setParent(uint64_t parent_id) { this->parent_id = parent_id; this->mutation_count = 0; } // An unmutated copy
+    // Forgets the lineage of the world the bot came from; World::addBot then makes it a founder.
+    void clearLineage() { this->lineage_id = this->parent_id = this->founder_id = 0; this->mutation_count = 0; }
+    int getDiet() const; // One of Diet, from nutrition_balance and scavenge_points
+    // Static analysis of the genome, computed on first use and shared with unmutated offspring.
+    const ControlFlowSummary& getControlFlow() const;
+    // The program counter got trapped in an action-free loop: the bot can never act again, so
+    // its program is no longer interpreted (pc, memory and direction stay as they were).
+    // Only checked once the bot has gone a whole genome length without acting.
+    bool isInert() const { return this->inert; }
+    // Restores the state of a newborn (energy, age, memory, pc, direction, diet), keeping
+    // the genome, color, position and lineage.
+    void resetLife();
     void addEnergy(int amount);
     void setPosition(Vector2 pos);
-    void serialize(std::ofstream& out);
-    void deserialize(std::ifstream& in);
+    // The bot's state without its genome, which the caller stores (see save_format.h). It
+    // includes the memory stack and lineage, so a restored bot goes on exactly as the saved one.
+    void serialize(ByteWriter& out) const;
+    bool deserialize(ByteReader& in, int version); // False if the record is malformed
+    bool deserializeLegacy(ByteReader& in);        // A raw record of the unversioned format, with genome
+    // Single-bot files, in either format. loadFromFile returns nullptr if the file cannot be read.
+    bool saveToFile(const std::string& filename) const;
+    static Bot* loadFromFile(const std::string& filename);
     bool is_dead = false;
     bool isOrganic = false;
+    bool is_relative = false; // Highlighted as a relative of the scanned genome (maintained by World)
+    CensusRecord census_record; // What this bot contributes to the world's census (maintained by Census)
 private:
     Vector2 position;
     int energy = INITIAL_ENERGY;
     int age = 0;
-    std::vector<unsigned int> genome;
-    std::stack<unsigned int> memory;
+    std::vector<uint8_t> genome;
+    std::vector<unsigned int> memory; // A stack, the top at the back
     unsigned int pc = 0; // program counter, the index of current action in genome
     Color color = {0, 0, 255, 255}; // Default color is blue
     unsigned int direction = 1; // 0..7
@@ -48,20 +85,28 @@ private:
     Vector2 _findEmptyAdjacentCell(World& world);
     void _processGenome(World& world);
     void _attack(int relative_index, World& world);
-    void _look(int relative_index, World& world);
+    int _look(int relative_index, World& world); // Returns the pc offset, see LOOK_*_OFFSET
     void _turn(int relative_index);
     void _move(int relative_index, World& world);
-    void _initRandomGenome();
+    void _initRandom(Random& random);
     void _checkRelative(int relative_index, World& world);
     void _shareEnergy(int relative_index, World& world);
-    void _checkBiome();
+    void _checkBiome(World& world);
     void _checkY();
     void _checkX();
     void _checkEnergy();
     void _checkAge();
     void _consumeOrganic(int relative_index, World& world);
+    void _photosynthize(World& world);
     int _genomeDifference(const Bot& other) const;
     void _constrainPosition(Vector2 &pos, const World& world);
     int nutrition_balance = 0; // Negative for carnivore, positive for vegetarian
     int scavenge_points = 0; // Tracks how much a bot has scavenged (modified by eating corpses)
+    uint64_t lineage_id = 0;
+    uint64_t parent_id = 0;
+    uint64_t founder_id = 0;
+    int mutation_count = 0; // Mutations this bot was born with
+    mutable std::shared_ptr<const ControlFlowSummary> control_flow; // See getControlFlow()
+    int idle_steps = 0; // Instructions executed since the last action
+    bool inert = false;
 };
\ No newline at end of file
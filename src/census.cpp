@@ -0,0 +1,126 @@
+#include "census.h"
+#include "bot.h"
+#include <fstream>
+
+int Census::_biomeOf(const Bot& bot) {
+    // Same split as photosynthesis and the check-biome instruction use in the main world.
+    return biomeAt(bot.getPosition().x);
+}
+
+void Census::_add(const CensusRecord& record, uint64_t clade, int sign) {
+    this->current.bots += sign;
+    this->current.diet[record.diet] += sign;
+    this->current.biome[record.biome] += sign;
+    this->total_energy += sign * record.energy;
+    this->current.inert += sign * record.inert;
+
+    int& size = this->clade_sizes[clade];
+    if (size > 0) this->clades_by_size[size]--;
+    size += sign;
+    if (size > 0) {
+        if (size >= (int)this->clades_by_size.size()) this->clades_by_size.resize(size + 1, 0);
+        this->clades_by_size[size]++;
+        if (size > this->largest_clade) this->largest_clade = size;
+    } else {
+        this->clade_sizes.erase(clade);
+    }
+    // The largest clade can only have shrunk by one.
+    while (this->largest_clade > 0 && this->clades_by_size[this->largest_clade] == 0) {
+        this->largest_clade--;
+    }
+}
+
+void Census::addBot(Bot& bot) {
+    if (bot.census_record.counted) return;
+    bot.census_record = {true, (signed char)bot.getDiet(), (signed char)_biomeOf(bot), bot.getEnergy(), bot.isInert()};
+    _add(bot.census_record, bot.getFounderId(), 1);
+}
+
+void Census::updateBot(Bot& bot) {
+    CensusRecord& record = bot.census_record;
+    if (!record.counted) return;
+    int diet = bot.getDiet();
+    int biome = _biomeOf(bot);
+    int energy = bot.getEnergy();
+    if (diet != record.diet) {
+        this->current.diet[record.diet]--;
+        this->current.diet[diet]++;
+        record.diet = (signed char)diet;
+    }
+    if (biome != record.biome) {
+        this->current.biome[record.biome]--;
+        this->current.biome[biome]++;
+        record.biome = (signed char)biome;
+    }
+    this->total_energy += energy - record.energy;
+    record.energy = energy;
+    bool inert = bot.isInert();
+    if (inert != record.inert) {
+        this->current.inert += inert ? 1 : -1;
+        record.inert = inert;
+    }
+}
+
+void Census::removeBot(Bot& bot) {
+    if (!bot.census_record.counted) return;
+    _add(bot.census_record, bot.getFounderId(), -1);
+    bot.census_record.counted = false;
+}
+
+CensusSample Census::getCurrent() const {
+    CensusSample sample = this->current;
+    sample.mean_energy = sample.bots > 0 ? (float)((double)this->total_energy / sample.bots) : 0.0f;
+    sample.clades = (int)this->clade_sizes.size();
+    sample.largest_clade = this->largest_clade;
+    return sample;
+}
+
+void Census::record(long long step, int genome_count) {
+    CensusSample sample = getCurrent();
+    sample.step = step;
+    sample.genomes = genome_count;
+
+    if ((int)this->recent.size() < RECENT_CAPACITY) {
+        this->recent.push_back(sample);
+    } else {
+        this->recent[this->recent_head] = sample;
+        this->recent_head = (this->recent_head + 1) % RECENT_CAPACITY;
+    }
+
+    if (step % this->history_interval != 0) return;
+    if ((int)this->history.size() == HISTORY_CAPACITY) {
+        // Downsample: keep the samples on multiples of the doubled interval.
+        this->history_interval *= 2;
+        size_t kept = 0;
+        for (const CensusSample& old : this->history) {
+            if (old.step % this->history_interval == 0) this->history[kept++] = old;
+        }
+        this->history.resize(kept);
+        if (step % this->history_interval != 0) return;
+    }
+    this->history.push_back(sample);
+}
+
+void Census::clear() {
+    *this = Census();
+}
+
+void Census::copyRecent(std::vector<CensusSample>& out) const {
+    out.clear();
+    out.insert(out.end(), this->recent.begin() + this->recent_head, this->recent.end());
+    out.insert(out.end(), this->recent.begin(), this->recent.begin() + this->recent_head);
+}
+
+bool Census::exportCsv(const std::string& filename) const {
+    std::ofstream out(filename);
+    if (!out.is_open()) return false;
+
+    out << "step,bots,organic,neutral,photosynthesis,hunting,scavenging,sunny,balanced,dark,mean_energy,clades,largest_clade,genomes,inert\n";
+    for (const CensusSample& s : this->history) {
+        out << s.step << "," << s.bots << "," << s.organic;
+        for (int d = 0; d < DIET_COUNT; d++) out << "," << s.diet[d];
+        for (int b = 0; b < BIOME_COUNT; b++) out << "," << s.biome[b];
+        out << "," << s.mean_energy << "," << s.clades << "," << s.largest_clade << "," << s.genomes << "," << s.inert << "\n";
+    }
+    return out.good();
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "config.h"
+#include <unordered_map>
+#include <vector>
+
+class Bot;
+
+enum Diet {
+    DIET_NEUTRAL = 0,     // No dietary history yet (newborns)
+    DIET_PHOTOSYNTHESIS,
+    DIET_HUNTING,
+    DIET_SCAVENGING,
+    DIET_COUNT
+};
+
+// The biomes are thirds of the main world, left to right.
+enum Biome {
+    BIOME_SUNNY = 0,
+    BIOME_BALANCED,
+    BIOME_DARK,
+    BIOME_COUNT
+};
+
+// The biome of column x in main world coordinates. Worlds may override it, see World::getBiome().
+inline int biomeAt(float x) {
+    if (x < WORLD_WIDTH / 3.0f) return BIOME_SUNNY;
+    if (x < 2.0f * WORLD_WIDTH / 3.0f) return BIOME_BALANCED;
+    return BIOME_DARK;
+}
+
+// One row of the population time series.
+struct CensusSample {
+    long long step = 0;
+    int bots = 0;                // Living, non-organic bots
+    int organic = 0;             // Corpses
+    int diet[DIET_COUNT] = {};
+    int biome[BIOME_COUNT] = {};
+    float mean_energy = 0.0f;
+    int clades = 0;              // Distinct founders with living descendants
+    int largest_clade = 0;
+    int genomes = 0;             // Distinct living genomes
+    int inert = 0;               // Bots stuck in an action-free loop (see Bot::isInert())
+};
+
+// What a bot currently contributes to the census, so it can be taken back exactly.
+// Maintained by Census, stored on the bot (see Bot::census_record).
+struct CensusRecord {
+    bool counted = false;
+    signed char diet = DIET_NEUTRAL;
+    signed char biome = 0;
+    int energy = 0;
+    bool inert = false;
+};
+
+// Population aggregates kept up to date as bots are born, change and die, instead of being
+// recounted by scanning the world. A bot's energy, diet and biome are folded in right after
+// its own turn (World::process), births and deaths as they happen.
+//
+// Every step is recorded into a ring of the most recent samples, and into a long-term history
+// that halves its resolution (dropping every other sample) whenever it fills up, so it covers
+// the whole run in bounded memory.
+class Census {
+public:
+    static const int RECENT_CAPACITY = 600;
+    static const int HISTORY_CAPACITY = 1024;
+
+    void addBot(Bot& bot);
+    void updateBot(Bot& bot);
+    void removeBot(Bot& bot);
+    void addOrganic() { this->current.organic++; }
+    void removeOrganic() { this->current.organic--; }
+    void record(long long step, int genome_count); // Called once at the end of every step
+    void clear();
+
+    CensusSample getCurrent() const;
+    void copyRecent(std::vector<CensusSample>& out) const; // Oldest first
+    const std::vector<CensusSample>& getHistory() const { return this->history; }
+    int getHistoryInterval() const { return this->history_interval; }
+    bool exportCsv(const std::string& filename) const; // The long-term history
+private:
+    void _add(const CensusRecord& record, uint64_t clade, int sign);
+    static int _biomeOf(const Bot& bot);
+
+    CensusSample current;      // Counts only; mean energy and clades are filled in on demand
+    long long total_energy = 0;
+    std::unordered_map<uint64_t, int> clade_sizes;
+    std::vector<int> clades_by_size; // clades_by_size[n]: number of clades with n living bots
+    int largest_clade = 0;
+
+    std::vector<CensusSample> recent; // Ring buffer
+    int recent_head = 0;
+    std::vector<CensusSample> history;
+    int history_interval = 1; // Steps between history samples
+};
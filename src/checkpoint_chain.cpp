@@ -0,0 +1,245 @@
+#include "checkpoint_chain.h"
+#include <cstring>
+#include <memory>
+
+const size_t MAX_CHAIN_LENGTH = 100000; // Guards against a chain that links back to itself
+
+static uint32_t payloadCrc(const uint8_t* file) {
+    return (uint32_t)file[12] | (uint32_t)file[13] << 8 | (uint32_t)file[14] << 16 | (uint32_t)file[15] << 24;
+}
+
+static std::string baseName(const std::string& filename) {
+    size_t separator = filename.find_last_of("/\\");
+    return separator == std::string::npos ? filename : filename.substr(separator + 1);
+}
+
+static std::string siblingPath(const std::string& filename, const std::string& name) {
+    size_t separator = filename.find_last_of("/\\");
+    return separator == std::string::npos ? name : filename.substr(0, separator + 1) + name;
+}
+
+static const uint8_t* spanOf(const std::vector<uint8_t>& bytes, const std::vector<uint32_t>& ends, size_t i, size_t& size) {
+    size_t begin = i > 0 ? ends[i - 1] : 0;
+    size = ends[i] - begin;
+    return bytes.data() + begin;
+}
+
+bool DeltaEncoder::canEncodeDelta(const WorldImage& image) const {
+    return this->has_previous && image.epoch == this->epoch && image.width == this->width &&
+           image.height == this->height && image.step_count > this->step_count;
+}
+
+void DeltaEncoder::encodeKeyframe(const WorldImage& image, ByteWriter& out) {
+    this->genomes.clear();
+    encodeWorldImage(image, out, this->genomes, this->genome_ids);
+    _remember(image, out);
+}
+
+void DeltaEncoder::encodeDelta(const WorldImage& image, const std::string& previous_filename, ByteWriter& out) {
+    beginSaveFile(out, SAVE_MAGIC_DELTA);
+    out.putVarint((uint64_t)image.width);
+    out.putVarint((uint64_t)image.height);
+    out.putVarint(image.seed);
+    out.putVarint((uint64_t)image.step_count);
+    writeResumeState(out, image.resume);
+    out.putVarint((uint64_t)this->step_count);
+    out.putU32(this->crc);
+    std::string previous_name = baseName(previous_filename);
+    out.putVarint(previous_name.size());
+    out.putBytes(previous_name.data(), previous_name.size());
+
+    // Carried-over bots keep their genome id, newborns are interned.
+    const size_t bot_count = image.getBotCount();
+    const uint32_t first_new = (uint32_t)this->genomes.size();
+    std::vector<int64_t> previous_index(bot_count, -1);
+    std::vector<uint32_t> ids(bot_count);
+    for (size_t i = 0; i < bot_count; i++) {
+        auto found = this->index_by_id.find(image.ids[i]);
+        if (found != this->index_by_id.end()) {
+            previous_index[i] = found->second;
+            ids[i] = this->genome_ids[found->second];
+        } else {
+            size_t size = 0;
+            const uint8_t* genes = spanOf(image.genes, image.genome_ends, i, size);
+            ids[i] = this->genomes.intern(genes, size);
+        }
+    }
+    out.putVarint(first_new);
+    out.putVarint(this->genomes.size() - first_new);
+    for (uint32_t id = first_new; id < this->genomes.size(); id++) {
+        out.putVarint(this->genomes.getSize(id));
+        out.putBytes(this->genomes.getGenes(id), this->genomes.getSize(id));
+    }
+
+    out.putVarint(bot_count);
+    for (size_t i = 0; i < bot_count; i++) {
+        size_t size = 0;
+        const uint8_t* record = spanOf(image.records, image.record_ends, i, size);
+        if (previous_index[i] < 0) {
+            out.putVarint(0);
+            out.putVarint(ids[i]);
+            out.putBytes(record, size);
+            continue;
+        }
+        size_t previous_size = 0;
+        const uint8_t* previous = spanOf(this->records, this->record_ends, (size_t)previous_index[i], previous_size);
+        bool unchanged = previous_size == size && memcmp(previous, record, size) == 0;
+        out.putVarint(1 + 2 * (uint64_t)previous_index[i] + unchanged);
+        if (!unchanged) out.putBytes(record, size);
+    }
+    finishSaveFile(out);
+    this->genome_ids.swap(ids);
+    _remember(image, out);
+}
+
+void DeltaEncoder::_remember(const WorldImage& image, const ByteWriter& out) {
+    this->has_previous = true;
+    this->epoch = image.epoch;
+    this->width = image.width;
+    this->height = image.height;
+    this->step_count = image.step_count;
+    this->crc = payloadCrc(out.getBytes().data());
+    this->index_by_id.clear();
+    for (size_t i = 0; i < image.ids.size(); i++) this->index_by_id[image.ids[i]] = (uint32_t)i;
+    this->records = image.records;
+    this->record_ends = image.record_ends;
+}
+
+bool loadCheckpoint(World& world, const std::string& filename) {
+    // Follow the links back to the keyframe; chain[0] is the requested checkpoint.
+    struct Link {
+        std::unique_ptr<MappedFile> file;
+        std::unique_ptr<std::vector<uint8_t>> decompressed;
+        ByteReader payload;
+        int version;
+    };
+    std::vector<Link> chain;
+    std::string name = filename;
+    bool has_expected = false;
+    uint32_t expected_crc = 0;
+    long long expected_step = 0;
+    while (true) {
+        if (chain.size() > MAX_CHAIN_LENGTH) return false;
+        std::unique_ptr<MappedFile> file(new MappedFile(name));
+        if (!file->isOpen()) return false;
+        bool is_delta = file->size() >= 4 && memcmp(file->data(), SAVE_MAGIC_DELTA, 4) == 0;
+        if (!is_delta && chain.empty()) return world.loadWorld(filename); // Not part of a chain (or legacy)
+
+        int version = 0;
+        bool is_legacy = false;
+        std::unique_ptr<std::vector<uint8_t>> decompressed(new std::vector<uint8_t>());
+        ByteReader payload = openSaveFile(file->data(), file->size(), is_delta ? SAVE_MAGIC_DELTA : SAVE_MAGIC_WORLD,
+                                          version, is_legacy, *decompressed);
+        if (payload.failed() || (has_expected && payloadCrc(file->data()) != expected_crc)) return false;
+
+        ByteReader in = payload;
+        in.getVarint(); // Width and height
+        in.getVarint();
+        in.getVarint(); // Seed
+        long long step = (long long)in.getVarint();
+        ResumeState resume;
+        if (version >= 2) readResumeState(in, resume);
+        if (in.failed() || (has_expected && step != expected_step)) return false;
+        chain.push_back({std::move(file), std::move(decompressed), payload, version});
+        if (!is_delta) break;
+
+        expected_step = (long long)in.getVarint();
+        expected_crc = in.getU32();
+        uint64_t name_size = in.getVarint();
+        if (in.failed() || name_size > in.remaining()) return false;
+        const uint8_t* previous_name = in.getBytes((size_t)name_size);
+        name = siblingPath(name, std::string((const char*)previous_name, (size_t)name_size));
+        has_expected = true;
+    }
+
+    // Apply it forward. Genomes and records stay where they are in the mapped (or decompressed) files.
+    struct Span { const uint8_t* data; size_t size; };
+    struct BotState { uint32_t genome; Span record; int version; };
+    std::vector<Span> genomes;
+    std::vector<BotState> bots;
+    std::vector<BotState> next;
+    Bot scratch(std::vector<uint8_t>{});
+    auto readRecord = [&scratch](ByteReader& in, int version, Span& record) {
+        record.data = in.position();
+        if (!scratch.deserialize(in, version)) return false;
+        record.size = (size_t)(in.position() - record.data);
+        return true;
+    };
+    auto readGenomes = [&genomes](ByteReader& in, uint64_t count) {
+        if (count > in.remaining()) return false;
+        for (uint64_t i = 0; i < count; i++) {
+            Span genome;
+            genome.data = readGenomeInPlace(in, genome.size);
+            if (!genome.data) return false;
+            genomes.push_back(genome);
+        }
+        return true;
+    };
+    const uint64_t max_bots = (uint64_t)world.getWidth() * world.getHeight();
+    unsigned int seed = 0;
+    long long step_count = 0;
+    ResumeState resume;
+    bool has_resume = false;
+    for (size_t k = chain.size(); k-- > 0;) {
+        ByteReader& in = chain[k].payload;
+        const int version = chain[k].version;
+        bool ok = in.getVarint() == (uint64_t)world.getWidth() && in.getVarint() == (uint64_t)world.getHeight();
+        seed = (unsigned int)in.getVarint();
+        step_count = (long long)in.getVarint();
+        has_resume = version >= 2;
+        if (has_resume) readResumeState(in, resume); // Checked above
+        if (k == chain.size() - 1) {
+            // The keyframe
+            ok = ok && readGenomes(in, in.getVarint());
+            uint64_t bot_count = in.getVarint();
+            ok = ok && !in.failed() && bot_count <= max_bots;
+            bots.resize(ok ? (size_t)bot_count : 0);
+            for (size_t i = 0; ok && i < bots.size(); i++) {
+                bots[i].genome = (uint32_t)in.getVarint();
+                bots[i].version = version;
+                ok = bots[i].genome < genomes.size() && readRecord(in, version, bots[i].record);
+            }
+            if (!ok) return false;
+            continue;
+        }
+
+        in.getVarint(); // The link, checked above
+        in.getU32();
+        in.getBytes((size_t)in.getVarint());
+        ok = ok && in.getVarint() == genomes.size();
+        ok = ok && readGenomes(in, in.getVarint());
+        uint64_t bot_count = in.getVarint();
+        ok = ok && !in.failed() && bot_count <= max_bots;
+        next.resize(ok ? (size_t)bot_count : 0);
+        for (size_t i = 0; ok && i < next.size(); i++) {
+            uint64_t key = in.getVarint();
+            if (key == 0) {
+                next[i].genome = (uint32_t)in.getVarint();
+                next[i].version = version;
+                ok = next[i].genome < genomes.size() && readRecord(in, version, next[i].record);
+                continue;
+            }
+            uint64_t previous = (key - 1) / 2;
+            ok = previous < bots.size();
+            if (!ok) break;
+            next[i] = bots[(size_t)previous];
+            if ((key - 1) % 2 == 0) {
+                next[i].version = version;
+                ok = readRecord(in, version, next[i].record);
+            }
+        }
+        if (!ok || in.failed()) return false;
+        bots.swap(next);
+    }
+
+    std::vector<Bot*> loaded;
+    loaded.reserve(bots.size());
+    for (const BotState& state : bots) {
+        const Span& genome = genomes[state.genome];
+        Bot* bot = new Bot(std::vector<uint8_t>(genome.data, genome.data + genome.size));
+        ByteReader record(state.record.data, state.record.size);
+        bot->deserialize(record, state.version); // Checked while reading
+        loaded.push_back(bot);
+    }
+    return world.restoreState(seed, step_count, loaded, has_resume ? &resume : nullptr);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "world.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Incremental checkpoints. A chain starts with a keyframe, an ordinary world save, and goes on
+// with deltas ("EVOD" save files) that store only what changed since the checkpoint before.
+// A delta's payload:
+//   width, height, seed, step count   varints, as in a world save
+//   resume state                      as in a world save (version 2, see ResumeState)
+//   previous checkpoint               its step count (varint), payload CRC-32 (uint32) and file
+//                                     name (varint length + bytes, in the same directory)
+//   new genomes                       the first new genome id and the count (varints), then
+//                                     every genome as in a world save
+//   bots                              varint count, then per bot a varint key:
+//                                       0       born since: varint genome id, Bot record
+//                                       1 + 2i  bot i of the previous checkpoint, Bot record
+//                                       2 + 2i  bot i of the previous checkpoint, unchanged
+// Genome ids refer to the chain's intern table: the keyframe's genome table, extended by the
+// new genomes of every delta in turn. Bots that died since are not mentioned. A bot keeps its
+// genome for life, so the ones carried over need no genome id, and corpses lying still cost
+// one varint.
+
+// Encodes successive images of one world, each as a keyframe or as a delta of the one before.
+// Bots are matched by their lineage ids, so a delta is only possible within one epoch.
+class DeltaEncoder {
+public:
+    bool canEncodeDelta(const WorldImage& image) const;
+    void encodeKeyframe(const WorldImage& image, ByteWriter& out);
+    // previous_filename is where the last encoded checkpoint is stored.
+    void encodeDelta(const WorldImage& image, const std::string& previous_filename, ByteWriter& out);
+    void reset() { this->has_previous = false; } // The next checkpoint has to be a keyframe
+private:
+    void _remember(const WorldImage& image, const ByteWriter& out);
+
+    GenomeTable genomes; // The chain's intern table
+    bool has_previous = false;
+    uint64_t epoch = 0;
+    int width = 0;
+    int height = 0;
+    long long step_count = 0;
+    uint32_t crc = 0;
+    // The bots of the previous checkpoint
+    std::unordered_map<uint64_t, uint32_t> index_by_id;
+    std::vector<uint32_t> genome_ids;
+    std::vector<uint8_t> records;
+    std::vector<uint32_t> record_ends;
+};
+
+// Loads any checkpoint into the world: a world save directly, a delta by following its chain
+// back to the keyframe and applying the deltas in order. Fails if a link is missing or does
+// not match (the CRC of every predecessor is checked); the world is then left untouched.
+bool loadCheckpoint(World& world, const std::string& filename);
@@ -0,0 +1,121 @@
+#include "checkpointer.h"
+#include <algorithm>
+#include <cstdio>
+
+Checkpointer::Checkpointer()
+    : compression_threads(std::clamp((int)std::thread::hardware_concurrency() - 1, 1, MAX_COMPRESSION_THREADS)),
+      thread(&Checkpointer::_run, this) {}
+
+Checkpointer::~Checkpointer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    thread.join();
+}
+
+void Checkpointer::submit(WorldImage image, const std::string& filename, int keep) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back({std::move(image), filename, keep, 0});
+    }
+    wake.notify_all();
+}
+
+void Checkpointer::submitIncremental(WorldImage image, const std::string& filename, int keyframe_interval, int keep_chains) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back({std::move(image), filename, keep_chains, keyframe_interval});
+    }
+    wake.notify_all();
+}
+
+bool Checkpointer::isBusy() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return writing || !jobs.empty();
+}
+
+void Checkpointer::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return !writing && jobs.empty(); });
+}
+
+void Checkpointer::_run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (jobs.empty()) return; // Stopping, and everything is written
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        writing = true;
+        lock.unlock();
+        if (job.keyframe_interval > 0 ? _writeIncremental(job) : _write(job)) {
+            last_saved_step = job.image.step_count;
+        } else {
+            failures++;
+        }
+        lock.lock();
+        writing = false;
+        if (jobs.empty()) finished.notify_all();
+    }
+}
+
+bool Checkpointer::_write(const Job& job) {
+    ByteWriter out;
+    encodeWorldImage(job.image, out);
+    compressSaveFile(out, this->compression_level, this->compression_threads);
+    std::string temporary = job.filename + ".tmp";
+    if (!writeFile(temporary, out.getBytes())) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    for (int index = job.keep - 1; index >= 1; index--) {
+        std::string newer = index > 1 ? numberedFilename(job.filename, index - 1) : job.filename;
+        replaceFile(newer, numberedFilename(job.filename, index)); // Fails harmlessly if missing
+    }
+    return replaceFile(temporary, job.filename);
+}
+
+bool Checkpointer::_writeIncremental(const Job& job) {
+    bool is_keyframe = job.filename != this->chain_filename || this->chain_length >= job.keyframe_interval ||
+                       !this->delta_encoder.canEncodeDelta(job.image);
+    ByteWriter out;
+    std::string filename = numberedFilename(job.filename, job.image.step_count, is_keyframe ? nullptr : ".delta");
+    if (is_keyframe) {
+        this->delta_encoder.encodeKeyframe(job.image, out);
+    } else {
+        this->delta_encoder.encodeDelta(job.image, this->last_checkpoint, out);
+    }
+    compressSaveFile(out, this->compression_level, this->compression_threads);
+    std::string temporary = filename + ".tmp";
+    if (!writeFile(temporary, out.getBytes()) || !replaceFile(temporary, filename)) {
+        std::remove(temporary.c_str());
+        this->delta_encoder.reset(); // The chain is broken, start over
+        this->chain_filename.clear();
+        return false;
+    }
+
+    if (is_keyframe) {
+        this->chain_filename = job.filename;
+        this->chain_length = 0;
+        this->chains.emplace_back();
+    }
+    this->chain_length++;
+    this->last_checkpoint = filename;
+    this->chains.back().push_back(filename);
+    while ((int)this->chains.size() > std::max(1, job.keep)) {
+        for (const std::string& old_file : this->chains.front()) std::remove(old_file.c_str());
+        this->chains.pop_front();
+    }
+    return true;
+}
+
+std::string numberedFilename(const std::string& filename, long long number, const char* extension) {
+    size_t separator = filename.find_last_of("/\\");
+    size_t dot = filename.rfind('.');
+    if (dot == std::string::npos || (separator != std::string::npos && dot < separator) || dot == separator + 1) {
+        dot = filename.size(); // No extension
+    }
+    return filename.substr(0, dot) + "." + std::to_string(number) + (extension ? extension : filename.substr(dot).c_str());
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "checkpoint_chain.h"
+#include "world.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Writes world save files on a background thread. The simulation thread only takes a
+// WorldImage (World::captureImage()); building the genome table, the checksum and the disk
+// I/O happen here, so saving a large world costs the simulation a few copies, not a stall.
+//
+// Every file is written under a temporary name and then renamed into place, so an
+// interrupted save never replaces a good file with a truncated one.
+class Checkpointer {
+public:
+    Checkpointer();
+    ~Checkpointer(); // Finishes all queued saves first
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+
+    // Queues an image to be written to filename. With keep > 1 the earlier versions are
+    // rotated first: "autosave.save" becomes "autosave.1.save", that one "autosave.2.save",
+    // and so on up to keep - 1, so the newest save always has the plain name.
+    void submit(WorldImage image, const std::string& filename, int keep = 1);
+    // Queues an incremental checkpoint (see checkpoint_chain.h). Every keyframe_interval-th
+    // checkpoint is a keyframe, written as "autosave.<step>.save", the others are deltas of
+    // the one before, "autosave.<step>.delta". Only the last keep_chains chains are kept, the
+    // files of older ones are deleted. A checkpoint that cannot follow the last one (another
+    // world, or the last write failed) starts a new chain.
+    void submitIncremental(WorldImage image, const std::string& filename, int keyframe_interval, int keep_chains);
+    bool isBusy() const;        // Saves queued or being written
+    // Applies to the saves written from now on, see compressSaveFile().
+    void setCompressionLevel(int level) { this->compression_level = level; }
+    int getCompressionLevel() const { return this->compression_level; }
+    void wait();                // Blocks until all queued saves are written
+    int getFailureCount() const { return this->failures; }
+    long long getLastSavedStep() const { return this->last_saved_step; } // -1 before the first save
+
+private:
+    struct Job {
+        WorldImage image;
+        std::string filename;
+        int keep;
+        int keyframe_interval; // 0 for a full save
+    };
+    void _run();
+    bool _write(const Job& job);
+    bool _writeIncremental(const Job& job);
+
+    // Compression threads: all cores but one, and at most MAX_COMPRESSION_THREADS, so an
+    // autosave never competes with the simulation thread for its core.
+    static constexpr int MAX_COMPRESSION_THREADS = 4;
+    int compression_threads = 1;
+    mutable std::mutex mutex;
+    std::condition_variable wake;     // Signals new jobs or stopping
+    std::condition_variable finished; // Signals that the queue ran empty
+    std::deque<Job> jobs;
+    bool writing = false;
+    bool stopping = false;
+    std::atomic<int> failures{0};
+    std::atomic<int> compression_level{SAVE_COMPRESSION_LEVEL};
+    std::atomic<long long> last_saved_step{-1};
+
+    // Incremental checkpoints, owned by the writer thread
+    DeltaEncoder delta_encoder;
+    std::string chain_filename;    // The filename the current chain was submitted with
+    std::string last_checkpoint;   // Where the chain's last checkpoint is stored
+    int chain_length = 0;
+    std::deque<std::vector<std::string>> chains; // Files of the kept chains, oldest first
+
+    std::thread thread; // Last, so it starts once all the members above are constructed
+};
+
+// Inserts a number before the extension: ("autosave.save", 2) -> "autosave.2.save". With an
+// extension given, it replaces the original one.
+std::string numberedFilename(const std::string& filename, long long number, const char* extension = nullptr);
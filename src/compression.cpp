@@ -0,0 +1,254 @@
+#include "compression.h"
+#include "save_format.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+const size_t MIN_MATCH = 4;
+const int HASH_BITS = 16;
+const int MIN_HASH_BITS = 10;
+const size_t WINDOW_SIZE = 65536; // Offsets are 16 bits
+const size_t MAX_OFFSET = WINDOW_SIZE - 1;
+
+static uint32_t read32(const uint8_t* p) {
+    uint32_t value;
+    memcpy(&value, p, 4);
+    return value;
+}
+
+static uint32_t hash4(const uint8_t* p, int bits) {
+    return (read32(p) * 2654435761u) >> (32 - bits);
+}
+
+// How many bytes at b equal those at a (a < b, the first MIN_MATCH known to), up to end.
+static size_t matchLength(const uint8_t* a, const uint8_t* b, const uint8_t* end) {
+    const uint8_t* start = b;
+    a += MIN_MATCH;
+    b += MIN_MATCH;
+    while (end - b >= 8) {
+        uint64_t x, y;
+        memcpy(&x, a, 8);
+        memcpy(&y, b, 8);
+        if (x != y) {
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            return (size_t)(b - start) + (size_t)(__builtin_ctzll(x ^ y) >> 3);
+#else
+            break;
+#endif
+        }
+        a += 8;
+        b += 8;
+    }
+    while (b < end && *a == *b) {
+        a++;
+        b++;
+    }
+    return (size_t)(b - start);
+}
+
+// Writes the part of a length beyond its nibble.
+static uint8_t* putLength(uint8_t* out, size_t length) {
+    for (; length >= 255; length -= 255) *out++ = 255;
+    *out++ = (uint8_t)length;
+    return out;
+}
+
+// A match length of 0 ends the block with literals only.
+static uint8_t* putSequence(uint8_t* out, const uint8_t* literals, size_t literal_count, size_t offset, size_t match_length) {
+    uint8_t* token = out++;
+    *token = (uint8_t)(std::min<size_t>(literal_count, 15) << 4);
+    if (literal_count >= 15) out = putLength(out, literal_count - 15);
+    memcpy(out, literals, literal_count);
+    out += literal_count;
+    if (match_length == 0) return out;
+    *out++ = (uint8_t)offset;
+    *out++ = (uint8_t)(offset >> 8);
+    size_t length = match_length - MIN_MATCH;
+    *token |= (uint8_t)std::min<size_t>(length, 15);
+    if (length >= 15) out = putLength(out, length - 15);
+    return out;
+}
+
+size_t lzCompressBound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+size_t lzCompress(const uint8_t* data, size_t size, uint8_t* out, int level) {
+    level = std::clamp(level, 1, MAX_COMPRESSION_LEVEL);
+    const int max_attempts = 1 << (level - 1);
+    uint8_t* start = out;
+    size_t anchor = 0;
+    if (size > MIN_MATCH) {
+        // head: the last position of every hash; previous: the position before it with the
+        // same hash, for the last WINDOW_SIZE positions (older ones are out of reach anyway).
+        // head has about one entry per four bytes, so small inputs (trajectory frames) don't
+        // clear and sweep a table sized for a whole block.
+        int bits = MIN_HASH_BITS;
+        while (bits < HASH_BITS && ((size_t)4 << bits) < size) bits++;
+        std::vector<int32_t> head((size_t)1 << bits, -1);
+        std::vector<int32_t> previous(max_attempts > 1 ? std::min(size, WINDOW_SIZE) : 0);
+        const bool chained = max_attempts > 1; // Level 1 only looks at the last position of a hash
+        auto insert = [&](size_t position) {
+            uint32_t hash = hash4(data + position, bits);
+            if (chained) previous[position & (WINDOW_SIZE - 1)] = head[hash];
+            head[hash] = (int32_t)position;
+        };
+        const size_t last_start = size - MIN_MATCH;
+        size_t misses = 0;
+        size_t i = 0;
+        while (i <= last_start) {
+            const uint32_t current = read32(data + i);
+            int32_t candidate = head[hash4(data + i, bits)];
+            size_t best_length = 0;
+            size_t best_offset = 0;
+            for (int attempt = 0; candidate >= 0 && attempt < max_attempts; attempt++) {
+                if (i - (size_t)candidate > MAX_OFFSET) break;
+                if (read32(data + candidate) == current) {
+                    size_t length = matchLength(data + candidate, data + i, data + size);
+                    if (length > best_length) {
+                        best_length = length;
+                        best_offset = i - (size_t)candidate;
+                    }
+                }
+                if (!chained) break;
+                int32_t next = previous[candidate & (WINDOW_SIZE - 1)];
+                if (next >= candidate) break; // The slot was reused by a newer position
+                candidate = next;
+            }
+            insert(i);
+            if (best_length == 0) {
+                i += 1 + (level == 1 ? misses++ >> 6 : 0); // Level 1 speeds through incompressible data
+                continue;
+            }
+            misses = 0;
+            out = putSequence(out, data + anchor, i - anchor, best_offset, best_length);
+            size_t end = i + best_length;
+            // Positions inside the match can start later matches. Level 1 only adds the last two.
+            for (size_t p = level == 1 ? std::max(i + 1, end - 2) : i + 1; p < end && p <= last_start; p++) insert(p);
+            i = anchor = end;
+        }
+    }
+    out = putSequence(out, data + anchor, size - anchor, 0, 0);
+    return (size_t)(out - start);
+}
+
+bool lzDecompress(const uint8_t* data, size_t size, uint8_t* out, size_t out_size) {
+    const uint8_t* in = data;
+    const uint8_t* in_end = data + size;
+    size_t produced = 0;
+    auto getLength = [&](size_t& length) {
+        uint8_t byte;
+        do {
+            if (in == in_end) return false;
+            byte = *in++;
+            length += byte;
+        } while (byte == 255);
+        return true;
+    };
+    while (in < in_end) {
+        uint8_t token = *in++;
+        size_t literal_count = token >> 4;
+        if (literal_count == 15 && !getLength(literal_count)) return false;
+        if (literal_count > (size_t)(in_end - in) || literal_count > out_size - produced) return false;
+        memcpy(out + produced, in, literal_count);
+        in += literal_count;
+        produced += literal_count;
+        if (in == in_end) {
+            if (token & 15) return false; // The last sequence has no match
+            break;
+        }
+
+        if (in_end - in < 2) return false;
+        size_t offset = (size_t)in[0] | (size_t)in[1] << 8;
+        in += 2;
+        size_t length = token & 15;
+        if (length == 15 && !getLength(length)) return false;
+        length += MIN_MATCH;
+        if (offset == 0 || offset > produced || length > out_size - produced) return false;
+        uint8_t* target = out + produced;
+        const uint8_t* source = target - offset;
+        if (offset >= length) {
+            memcpy(target, source, length);
+        } else {
+            for (size_t k = 0; k < length; k++) target[k] = source[k]; // Overlapping: repeats the last offset bytes
+        }
+        produced += length;
+    }
+    return produced == out_size;
+}
+
+// Runs work(block) for every block, on up to 'threads' threads taking the next block in turn.
+static void forEachBlock(size_t block_count, int threads, const std::function<void(size_t)>& work) {
+    int thread_count = threads > 0 ? threads : (int)std::thread::hardware_concurrency();
+    thread_count = (int)std::clamp<size_t>((size_t)std::max(thread_count, 1), 1, std::max<size_t>(block_count, 1));
+    std::atomic<size_t> next_block{0};
+    auto run = [&]() {
+        for (size_t block = next_block++; block < block_count; block = next_block++) work(block);
+    };
+    std::vector<std::thread> pool;
+    for (int i = 1; i < thread_count; i++) pool.emplace_back(run);
+    run();
+    for (std::thread& thread : pool) thread.join();
+}
+
+void compressBlocks(const uint8_t* data, size_t size, int level, int threads, std::vector<uint8_t>& out) {
+    const size_t block_count = (size + COMPRESSION_BLOCK_SIZE - 1) / COMPRESSION_BLOCK_SIZE;
+    std::vector<std::vector<uint8_t>> blocks(block_count);
+    forEachBlock(block_count, threads, [&](size_t block) {
+        const uint8_t* raw = data + block * COMPRESSION_BLOCK_SIZE;
+        size_t raw_size = std::min(COMPRESSION_BLOCK_SIZE, size - block * COMPRESSION_BLOCK_SIZE);
+        std::vector<uint8_t>& stored = blocks[block];
+        stored.resize(lzCompressBound(raw_size));
+        size_t stored_size = lzCompress(raw, raw_size, stored.data(), level);
+        if (stored_size < raw_size) {
+            stored.resize(stored_size);
+        } else {
+            stored.assign(raw, raw + raw_size);
+        }
+    });
+
+    ByteWriter writer;
+    writer.putVarint(size);
+    writer.putVarint(block_count);
+    for (const std::vector<uint8_t>& stored : blocks) {
+        writer.putVarint(stored.size());
+        writer.putBytes(stored.data(), stored.size());
+    }
+    out.swap(writer.getBytes());
+}
+
+bool decompressBlocks(const uint8_t* data, size_t size, int threads, std::vector<uint8_t>& out) {
+    ByteReader in(data, size);
+    uint64_t raw_size = in.getVarint();
+    uint64_t block_count = in.getVarint();
+    // A sequence expands to at most about 255 times its size, so a larger claim is damage.
+    if (in.failed() || raw_size / 256 > size || block_count > in.remaining() ||
+        block_count != (raw_size + COMPRESSION_BLOCK_SIZE - 1) / COMPRESSION_BLOCK_SIZE) {
+        return false;
+    }
+    struct Block { const uint8_t* stored; size_t stored_size; };
+    std::vector<Block> blocks((size_t)block_count);
+    for (Block& block : blocks) {
+        uint64_t stored_size = in.getVarint();
+        if (in.failed() || stored_size > in.remaining()) return false;
+        block.stored_size = (size_t)stored_size;
+        block.stored = in.getBytes(block.stored_size);
+    }
+    if (in.remaining() != 0) return false;
+
+    out.resize((size_t)raw_size);
+    std::atomic<bool> ok{true};
+    forEachBlock(blocks.size(), threads, [&](size_t index) {
+        const Block& block = blocks[index];
+        uint8_t* raw = out.data() + index * COMPRESSION_BLOCK_SIZE;
+        size_t raw_size = std::min(COMPRESSION_BLOCK_SIZE, out.size() - index * COMPRESSION_BLOCK_SIZE);
+        if (block.stored_size == raw_size) {
+            memcpy(raw, block.stored, raw_size);
+        } else if (!lzDecompress(block.stored, block.stored_size, raw, raw_size)) {
+            ok = false;
+        }
+    });
+    return ok;
+}
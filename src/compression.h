@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Block compression for save files (see compressSaveFile() in save_format.h).
+//
+// The codec is LZ77 in the sequence layout of LZ4: a token byte with the literal count and the
+// match length in its two nibbles (15 means more length bytes follow, each adding up to 255),
+// the literals, a 16-bit little-endian offset back into the output and the match length minus
+// 4. The last sequence of a block has literals only. Levels 1 to MAX_COMPRESSION_LEVEL trade
+// speed for ratio: level n follows the hash chain of earlier matches up to 2^(n-1) deep.
+//
+// The data is cut into COMPRESSION_BLOCK_SIZE blocks that are compressed independently, so
+// both directions run on several threads. The blocks are stored as:
+//   varint raw size, varint block count, then per block a varint stored size and the bytes
+// A block whose stored size equals its raw size was incompressible and is stored as it is.
+
+const int MAX_COMPRESSION_LEVEL = 9;
+const size_t COMPRESSION_BLOCK_SIZE = 256 * 1024;
+
+// Compresses a block into out, which needs lzCompressBound(size) bytes. Returns the size.
+size_t lzCompress(const uint8_t* data, size_t size, uint8_t* out, int level);
+size_t lzCompressBound(size_t size);
+// Decompresses exactly out_size bytes. False if the input is malformed or has another size.
+bool lzDecompress(const uint8_t* data, size_t size, uint8_t* out, size_t out_size);
+
+// threads = 0 uses all cores.
+void compressBlocks(const uint8_t* data, size_t size, int level, int threads, std::vector<uint8_t>& out);
+bool decompressBlocks(const uint8_t* data, size_t size, int threads, std::vector<uint8_t>& out);
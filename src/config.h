@@ -13,8 +13,13 @@
 #define GENOME_INSERTION_RATE 0.01f // Chance to add a gene
 #define GENOME_DELETION_RATE 0.01f // Chance to remove a gene
 
+#define TARGET_FPS 60 // GUI frame rate, also the rate at which render snapshots are published
+#define SIM_FRAME_BUDGET 0.8f // Fraction of each frame the simulation thread may spend stepping
+
 #define BOTTOM_PANEL_HEIGHT 50
 #define SIDE_PANEL_WIDTH 400
+#define MAX_INITIAL_VIEWPORT_WIDTH 1600 // Larger worlds start zoomed out to fit
+#define MAX_INITIAL_VIEWPORT_HEIGHT 900
 
 #define INITIAL_GENOME_SIZE 64
 #define MIN_GENOME_SIZE 1
@@ -30,5 +35,8 @@
 #define LOW_PHOTOSYNTHIZE_ENERGY_GAIN 4 // Used in right biome
 
 #define COLOR_MUTATION_AMOUNT 10
+#define RELATIVE_GENOME_DIFFERENCE 5 // Bots whose genomes differ in fewer genes are relatives
+
+#define MAXIMUM_BOT_AGE 3000
 
-#define MAXIMUM_BOT_AGE 3000
\ No newline at end of file
+#define SAVE_COMPRESSION_LEVEL 1 // World saves and checkpoints: 0 = uncompressed, 1 (fastest) to 9 (smallest)
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "genome_analysis.h"
+#include <algorithm>
+
+ControlFlowSummary summarizeControlFlow(const std::vector<uint8_t>& genome) {
+    ControlFlowSummary summary;
+    const int size = (int)genome.size();
+    summary.trapped.assign(size, true);
+    if (size == 0) return summary;
+
+    // Successors of every instruction, and the same edges reversed (as flat arrays).
+    std::vector<unsigned int> successors(size * 3);
+    std::vector<unsigned char> successor_count(size);
+    std::vector<int> predecessor_start(size + 1, 0);
+    for (int pc = 0; pc < size; pc++) {
+        successor_count[pc] = (unsigned char)getSuccessors(genome, (unsigned int)pc, &successors[pc * 3]);
+        for (int k = 0; k < successor_count[pc]; k++) predecessor_start[successors[pc * 3 + k] + 1]++;
+    }
+    for (int pc = 0; pc < size; pc++) predecessor_start[pc + 1] += predecessor_start[pc];
+    std::vector<int> predecessors(predecessor_start[size]);
+    std::vector<int> fill(predecessor_start.begin(), predecessor_start.end() - 1);
+    for (int pc = 0; pc < size; pc++) {
+        for (int k = 0; k < successor_count[pc]; k++) predecessors[fill[successors[pc * 3 + k]]++] = pc;
+    }
+
+    // Everything that can reach an action is not trapped: walk backwards from the actions.
+    std::vector<int> queue;
+    queue.reserve(size);
+    for (int pc = 0; pc < size; pc++) {
+        if (isActionInstruction(genome[pc])) {
+            summary.trapped[pc] = false;
+            queue.push_back(pc);
+        }
+    }
+    for (size_t head = 0; head < queue.size(); head++) {
+        int pc = queue[head];
+        for (int i = predecessor_start[pc]; i < predecessor_start[pc + 1]; i++) {
+            int predecessor = predecessors[i];
+            if (summary.trapped[predecessor]) {
+                summary.trapped[predecessor] = false;
+                queue.push_back(predecessor);
+            }
+        }
+    }
+
+    // Forward reachability from pc 0.
+    std::vector<bool> reached(size, false);
+    queue.clear();
+    queue.push_back(0);
+    reached[0] = true;
+    for (size_t head = 0; head < queue.size(); head++) {
+        int pc = queue[head];
+        for (int k = 0; k < successor_count[pc]; k++) {
+            unsigned int next = successors[pc * 3 + k];
+            if (!reached[next]) {
+                reached[next] = true;
+                queue.push_back((int)next);
+            }
+        }
+    }
+    summary.reachable = (int)queue.size();
+    return summary;
+}
+
+GenomeAnalysis::GenomeAnalysis(const std::vector<uint8_t>& genome, const GenomeGraph& graph)
+    : flow(summarizeControlFlow(genome)) {
+    const int size = graph.getNodeCount();
+    this->component.assign(size, -1);
+    if (size == 0) return;
+
+    // Tarjan's algorithm over the reachable nodes, with an explicit stack so that long
+    // chains (up to MAX_GENOME_SIZE instructions) cannot overflow the call stack.
+    std::vector<int> index(size, -1);
+    std::vector<int> low_link(size, 0);
+    std::vector<bool> on_stack(size, false);
+    std::vector<int> stack;
+    struct Frame { int node; const unsigned int* next; };
+    std::vector<Frame> frames;
+    int next_index = 0;
+
+    auto open = [&](int node) {
+        index[node] = low_link[node] = next_index++;
+        stack.push_back(node);
+        on_stack[node] = true;
+        frames.push_back({node, graph.successorsBegin(node)});
+    };
+    open(0);
+    while (!frames.empty()) {
+        Frame& frame = frames.back();
+        int node = frame.node;
+        if (frame.next != graph.successorsEnd(node)) {
+            int child = (int)*frame.next++;
+            if (index[child] < 0) {
+                open(child); // Invalidates 'frame'
+            } else if (on_stack[child]) {
+                low_link[node] = std::min(low_link[node], index[child]);
+            }
+            continue;
+        }
+        frames.pop_back();
+        if (!frames.empty()) {
+            int parent = frames.back().node;
+            low_link[parent] = std::min(low_link[parent], low_link[node]);
+        }
+        if (low_link[node] != index[node]) continue;
+
+        // node is the root of a component: pop it off the stack.
+        int id = (int)this->is_loop.size();
+        int members = 0;
+        bool has_action = false;
+        int member;
+        do {
+            member = stack.back();
+            stack.pop_back();
+            on_stack[member] = false;
+            this->component[member] = id;
+            members++;
+            has_action |= isActionInstruction(genome[member]);
+        } while (member != node);
+
+        bool self_loop = std::find(graph.successorsBegin(node), graph.successorsEnd(node), (unsigned int)node) != graph.successorsEnd(node);
+        bool loop = members > 1 || self_loop;
+        this->is_loop.push_back(loop);
+        this->is_action_free_loop.push_back(loop && !has_action);
+        this->loop_count += loop;
+        this->action_free_loop_count += loop && !has_action;
+    }
+
+    for (int pc : graph.getReachableNodes()) {
+        this->action_count += isActionInstruction(genome[pc]);
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "genome_graph.h"
+#include "instructions.h"
+#include <vector>
+
+// Static analysis of genome programs. All branches of LOOK and the conditional jumps count as
+// possible, so the results hold for every run of the program, whatever the bot sees.
+
+// Instructions with an effect on energy or the world: MOVE, ATTACK, PHOTOSYNTHIZE,
+// SHARE_ENERGY, CONSUME_ORGANIC and REPRODUCE. All others only turn, look, push to memory or
+// move the program counter.
+inline bool isActionInstruction(unsigned int instruction) {
+    return getInstructionInfo(instruction).action;
+}
+
+// What the interpreter and the inspector need to know about a genome. Computed in O(genome size)
+// and shared by a bot's unmutated descendants (see Bot::getControlFlow()).
+struct ControlFlowSummary {
+    // The instructions from which no action can be reached. The set is closed under the
+    // successors, so a bot whose program counter enters it loops without any action forever:
+    // it only ages and starves, and the interpreter skips it.
+    std::vector<bool> trapped;
+    int reachable = 0; // Instructions reachable from pc 0
+};
+ControlFlowSummary summarizeControlFlow(const std::vector<uint8_t>& genome);
+
+// The full analysis shown in the genome analyzer: reachability from pc 0, the strongly
+// connected components of the reachable part (a component with a cycle is a loop), and the
+// loops without any action.
+class GenomeAnalysis {
+public:
+    GenomeAnalysis(const std::vector<uint8_t>& genome, const GenomeGraph& graph);
+    int getReachableCount() const { return this->flow.reachable; }
+    int getDeadCount() const { return (int)this->component.size() - this->flow.reachable; }
+    int getActionCount() const { return this->action_count; } // Reachable actions
+    int getComponent(int pc) const { return this->component[pc]; } // -1 if unreachable
+    int getComponentCount() const { return (int)this->is_loop.size(); }
+    bool isLoop(int component) const { return this->is_loop[component]; }
+    bool isActionFreeLoop(int component) const { return this->is_action_free_loop[component]; }
+    int getLoopCount() const { return this->loop_count; }
+    int getActionFreeLoopCount() const { return this->action_free_loop_count; }
+    bool isTrapped(int pc) const { return this->flow.trapped[pc]; }
+    bool isInert() const { return !this->flow.trapped.empty() && this->flow.trapped[0]; } // Never acts at all
+private:
+    ControlFlowSummary flow;
+    std::vector<int> component;
+    std::vector<bool> is_loop;
+    std::vector<bool> is_action_free_loop;
+    int action_count = 0;
+    int loop_count = 0;
+    int action_free_loop_count = 0;
+};
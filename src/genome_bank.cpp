@@ -0,0 +1,214 @@
+#include "genome_bank.h"
+#include "genome_diff.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+int GenomeBank::add(const Bot& bot, const std::string& source, long long step) {
+    int index = find(bot.getGenome());
+    if (index >= 0) {
+        this->entries[index].count++;
+        return index;
+    }
+    Entry entry;
+    entry.step = step;
+    entry.lineage_id = bot.getLineageId();
+    entry.founder_id = bot.getFounderId();
+    Bot prototype(bot);
+    prototype.resetLife();
+    prototype.clearLineage();
+    prototype.is_dead = false;
+    prototype.isOrganic = false; // A saved corpse still has its genome
+    prototype.is_relative = false;
+    prototype.census_record = CensusRecord();
+    return _append(std::move(prototype), entry, source);
+}
+
+int GenomeBank::addWorld(const World& world, const std::string& source) {
+    int before = size();
+    for (const Bot* bot : world.getBots()) {
+        if (!bot->isOrganic && !bot->is_dead) add(*bot, source, world.getStepCount());
+    }
+    return size() - before;
+}
+
+int GenomeBank::importBotFiles(const std::vector<std::string>& filenames) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> files;
+    for (const std::string& filename : filenames) {
+        std::error_code error;
+        if (!fs::is_directory(filename, error)) {
+            files.push_back(filename);
+            continue;
+        }
+        for (const fs::directory_entry& file : fs::directory_iterator(filename, error)) {
+            if (file.is_regular_file(error)) files.push_back(file.path().string());
+        }
+    }
+    std::sort(files.begin(), files.end()); // Directory order is arbitrary
+
+    int imported = 0;
+    for (const std::string& file : files) {
+        // Only files that start like a bot save; loadFromFile() would also try any other
+        // file as a legacy bot.
+        MappedFile mapped(file);
+        if (!mapped.isOpen() || mapped.size() < 4 || memcmp(mapped.data(), SAVE_MAGIC_BOT, 4) != 0) continue;
+        Bot* bot = Bot::loadFromFile(file);
+        if (!bot) continue;
+        add(*bot, std::filesystem::path(file).filename().string(), 0);
+        delete bot;
+        imported++;
+    }
+    return imported;
+}
+
+int GenomeBank::find(const std::vector<uint8_t>& genome) const {
+    auto found = this->entries_by_hash.find(hashGenome(genome.data(), genome.size()));
+    if (found == this->entries_by_hash.end()) return -1;
+    for (int index : found->second) {
+        if (this->bots[index].getGenome() == genome) return index;
+    }
+    return -1;
+}
+
+void GenomeBank::findWithin(const std::vector<uint8_t>& genome, int max_distance, std::vector<int>& out) const {
+    std::vector<std::pair<int, int>> matches; // Distance, entry
+    for (int i = 0; i < size(); i++) {
+        const std::vector<uint8_t>& other = this->bots[i].getGenome();
+        int distance = genomeDifferenceBounded(genome.data(), genome.size(), other.data(), other.size(), max_distance + 1);
+        if (distance <= max_distance) matches.push_back({distance, i});
+    }
+    std::sort(matches.begin(), matches.end());
+    for (const auto& match : matches) out.push_back(match.second);
+}
+
+bool GenomeBank::save(const std::string& filename, int compression_level) const {
+    ByteWriter out;
+    beginSaveFile(out, SAVE_MAGIC_BANK);
+    out.putVarint(this->sources.size());
+    for (const std::string& source : this->sources) {
+        out.putVarint(source.size());
+        out.putBytes(source.data(), source.size());
+    }
+    out.putVarint(this->entries.size());
+    for (size_t i = 0; i < this->entries.size(); i++) {
+        const Entry& entry = this->entries[i];
+        writeGenome(out, this->bots[i].getGenome());
+        this->bots[i].serialize(out);
+        out.putVarint(entry.source);
+        out.putVarint((uint64_t)entry.step);
+        out.putVarint(entry.lineage_id);
+        out.putVarint(entry.founder_id);
+        out.putVarint((uint64_t)entry.count);
+    }
+    finishSaveFile(out);
+    compressSaveFile(out, compression_level);
+    // The bank is a whole library and usually overwrites itself: a failed write must leave the
+    // old file as it was.
+    std::string temporary = filename + ".tmp";
+    if (!writeFile(temporary, out.getBytes()) || !replaceFile(temporary, filename)) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool GenomeBank::load(const std::string& filename) {
+    MappedFile file(filename);
+    if (!file.isOpen()) return false;
+    int version = 0;
+    bool is_legacy = false;
+    std::vector<uint8_t> decompressed;
+    ByteReader in = openSaveFile(file.data(), file.size(), SAVE_MAGIC_BANK, version, is_legacy, decompressed);
+
+    // Decode everything first, so a damaged file leaves the bank as it was.
+    uint64_t source_count = in.getVarint();
+    bool ok = !in.failed() && source_count <= in.remaining();
+    std::vector<std::string> file_sources(ok ? (size_t)source_count : 0);
+    for (size_t i = 0; ok && i < file_sources.size(); i++) {
+        uint64_t length = in.getVarint();
+        const uint8_t* name = length <= in.remaining() ? in.getBytes((size_t)length) : nullptr;
+        ok = name != nullptr;
+        if (ok) file_sources[i].assign((const char*)name, (size_t)length);
+    }
+    uint64_t entry_count = in.getVarint();
+    ok = ok && !in.failed() && entry_count <= in.remaining();
+    GenomeBank loaded;
+    if (ok) {
+        loaded.entries.reserve((size_t)entry_count);
+        loaded.bots.reserve((size_t)entry_count);
+        loaded.entries_by_hash.reserve((size_t)entry_count);
+    }
+    for (uint64_t i = 0; ok && i < entry_count; i++) {
+        std::vector<uint8_t> genome;
+        ok = readGenome(in, genome);
+        if (!ok) break;
+        Bot bot(std::move(genome));
+        Entry entry;
+        ok = bot.deserialize(in, version);
+        entry.source = (uint32_t)in.getVarint();
+        entry.step = (long long)in.getVarint();
+        entry.lineage_id = in.getVarint();
+        entry.founder_id = in.getVarint();
+        entry.count = (int)std::min(in.getVarint(), (uint64_t)INT_MAX);
+        ok = ok && !in.failed() && entry.source < file_sources.size() && !bot.isOrganic;
+        if (!ok) break;
+        bot.clearLineage();
+        int index = loaded.find(bot.getGenome());
+        if (index >= 0) {
+            loaded.entries[index].count += entry.count;
+        } else {
+            loaded._append(std::move(bot), entry, file_sources[entry.source]);
+        }
+    }
+    if (!ok) return false;
+    if (size() == 0) {
+        *this = std::move(loaded); // Nothing to merge with, so nothing to copy
+    } else {
+        merge(loaded);
+    }
+    return true;
+}
+
+void GenomeBank::merge(const GenomeBank& other) {
+    this->entries.reserve(this->entries.size() + other.entries.size());
+    this->bots.reserve(this->bots.size() + other.bots.size());
+    for (int i = 0; i < other.size(); i++) {
+        const Entry& entry = other.entries[i];
+        int index = find(other.bots[i].getGenome());
+        if (index >= 0) {
+            this->entries[index].count += entry.count;
+        } else {
+            _append(Bot(other.bots[i]), entry, other.sources[entry.source]);
+        }
+    }
+}
+
+void GenomeBank::clear() {
+    this->entries.clear();
+    this->bots.clear();
+    this->sources.clear();
+    this->source_indices.clear();
+    this->entries_by_hash.clear();
+}
+
+int GenomeBank::_append(Bot&& prototype, Entry entry, const std::string& source) {
+    int index = (int)this->entries.size();
+    entry.source = _sourceIndex(source);
+    const std::vector<uint8_t>& genome = prototype.getGenome();
+    this->entries_by_hash[hashGenome(genome.data(), genome.size())].push_back(index);
+    this->entries.push_back(entry);
+    this->bots.push_back(std::move(prototype));
+    return index;
+}
+
+uint32_t GenomeBank::_sourceIndex(const std::string& source) {
+    auto found = this->source_indices.find(source);
+    if (found != this->source_indices.end()) return found->second;
+    uint32_t index = (uint32_t)this->sources.size();
+    this->sources.push_back(source);
+    this->source_indices[source] = index;
+    return index;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "bot.h"
+#include "world.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A library of genomes, each with where it came from, to seed worlds and analyzer scenarios
+// from (World::spawnCopies(), EvaluationSettings::neighbor_pool). Genomes are unique: adding
+// one that is already banked only counts it again. Lookups go through the genome hash;
+// similarity searches scan the genomes with the bounded distance kernel (about a millisecond
+// for 30000 of them). A bank file loads in one pass, far faster than as many bot files.
+//
+// A bank file is a save file (see save_format.h) with the magic "EVOG" and the payload:
+//   sources   varint count, then every source name as a varint length and the bytes
+//   entries   varint count, then per entry the genome (as in a world save), the prototype's
+//             Bot record, and varints: source index, step, lineage id, founder id, count
+class GenomeBank {
+public:
+    struct Entry {
+        uint32_t source = 0;     // Index into getSources(): the run or file it came from
+        long long step = 0;      // The source's step when it was banked
+        uint64_t lineage_id = 0; // The bot's lineage in its source world (0 if unknown)
+        uint64_t founder_id = 0;
+        int count = 1;           // Bots with this genome that were banked
+    };
+
+    int size() const { return (int)this->entries.size(); }
+    const Entry& getEntry(int index) const { return this->entries[index]; }
+    // A newborn with the entry's genome and color, without a lineage.
+    const Bot& getBot(int index) const { return this->bots[index]; }
+    const std::vector<Bot>& getBots() const { return this->bots; }
+    const std::vector<std::string>& getSources() const { return this->sources; }
+
+    // Banks the bot's genome and color; returns the entry's index.
+    int add(const Bot& bot, const std::string& source, long long step);
+    // Banks every living bot of the world under one source; returns the number of new entries.
+    int addWorld(const World& world, const std::string& source);
+    // Banks the bots of single-bot save files, and of all files in the directories among the
+    // filenames (files that are not bot saves are skipped). The source is the file's name.
+    // Returns the number of bot files read.
+    int importBotFiles(const std::vector<std::string>& filenames);
+
+    int find(const std::vector<uint8_t>& genome) const; // The identical genome's entry, or -1
+    // Entries whose genome is at most max_distance away, closest first.
+    void findWithin(const std::vector<uint8_t>& genome, int max_distance, std::vector<int>& out) const;
+
+    // Writes a temporary file first, so a failed save leaves an existing file untouched.
+    bool save(const std::string& filename, int compression_level = SAVE_COMPRESSION_LEVEL) const;
+    // Adds the entries of a bank file (merging duplicates). A damaged file adds nothing.
+    bool load(const std::string& filename);
+    void merge(const GenomeBank& other); // Adds the entries of another bank, counts of duplicates add up
+    void clear();
+
+private:
+    int _append(Bot&& prototype, Entry entry, const std::string& source); // A genome not banked yet
+    uint32_t _sourceIndex(const std::string& source);
+
+    std::vector<Entry> entries;
+    std::vector<Bot> bots; // Per entry
+    std::vector<std::string> sources;
+    std::unordered_map<std::string, uint32_t> source_indices;
+    std::unordered_map<uint64_t, std::vector<int>> entries_by_hash;
+};
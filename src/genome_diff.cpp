@@ -0,0 +1,141 @@
+#include "genome_diff.h"
+#include <algorithm>
+#include <climits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define GENOME_DIFF_SSE2 1
+#include <immintrin.h>
+#endif
+
+#if GENOME_DIFF_SSE2 && (defined(__GNUC__) || defined(__clang__))
+// GCC and Clang can compile the AVX2 kernel without -mavx2 and pick it at runtime.
+#define GENOME_DIFF_AVX2 1
+#define GENOME_DIFF_AVX2_TARGET __attribute__((target("avx2")))
+#elif GENOME_DIFF_SSE2 && defined(__AVX2__)
+// MSVC only when the whole program is built with /arch:AVX2.
+#define GENOME_DIFF_AVX2 1
+#define GENOME_DIFF_AVX2_TARGET
+#endif
+
+// The bounded variant checks the limit after every block of genes. A block is small enough
+// to stop early on unrelated genomes, and large enough to keep the vector loop tight.
+static const size_t BLOCK_GENES = 64;
+
+// Each kernel counts the differing genes in [0, size) of two equally long ranges.
+typedef int (*DiffKernel)(const uint8_t* a, const uint8_t* b, size_t size);
+
+static int _diffScalar(const uint8_t* a, const uint8_t* b, size_t size) {
+    int differences = 0;
+    for (size_t i = 0; i < size; ++i) {
+        differences += a[i] != b[i];
+    }
+    return differences;
+}
+
+// The vector kernels count equal genes per byte lane: a lane that compares equal is all ones
+// (-1), so subtracting adds 1. Byte counters overflow after 255 steps, so every
+// COUNTER_STEPS vectors they are summed into 64-bit lanes with a sum of absolute differences.
+static const size_t COUNTER_STEPS = 255;
+
+#if GENOME_DIFF_SSE2
+static int _diffSSE2(const uint8_t* a, const uint8_t* b, size_t size) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i total = zero;
+    size_t i = 0;
+    while (i + 16 <= size) {
+        __m128i equal = zero;
+        size_t end = std::min(size & ~(size_t)15, i + 16 * COUNTER_STEPS);
+        for (; i < end; i += 16) {
+            __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+            __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+            equal = _mm_sub_epi8(equal, _mm_cmpeq_epi8(va, vb));
+        }
+        total = _mm_add_epi64(total, _mm_sad_epu8(equal, zero));
+    }
+    int equal_count = _mm_cvtsi128_si32(total) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(total, total));
+    return (int)i - equal_count + _diffScalar(a + i, b + i, size - i);
+}
+#endif
+
+#if GENOME_DIFF_AVX2
+GENOME_DIFF_AVX2_TARGET
+static int _diffAVX2(const uint8_t* a, const uint8_t* b, size_t size) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i total = zero;
+    size_t i = 0;
+    while (i + 32 <= size) {
+        __m256i equal = zero;
+        size_t end = std::min(size & ~(size_t)31, i + 32 * COUNTER_STEPS);
+        for (; i < end; i += 32) {
+            __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+            __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+            equal = _mm256_sub_epi8(equal, _mm256_cmpeq_epi8(va, vb));
+        }
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(equal, zero));
+    }
+    alignas(32) uint64_t lanes[4];
+    _mm256_store_si256((__m256i*)lanes, total);
+    int equal_count = (int)(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    return (int)i - equal_count + _diffScalar(a + i, b + i, size - i);
+}
+#endif
+
+struct KernelChoice {
+    DiffKernel kernel;
+    const char* name;
+};
+
+static KernelChoice _selectKernel() {
+#if GENOME_DIFF_AVX2 && (defined(__GNUC__) || defined(__clang__))
+    if (__builtin_cpu_supports("avx2")) return {_diffAVX2, "AVX2"};
+#elif GENOME_DIFF_AVX2
+    return {_diffAVX2, "AVX2"};
+#endif
+#if GENOME_DIFF_SSE2
+    return {_diffSSE2, "SSE2"};
+#else
+    return {_diffScalar, "scalar"};
+#endif
+}
+
+static const KernelChoice selected_kernel = _selectKernel();
+static const DiffKernel diff_kernel = selected_kernel.kernel;
+
+const char* genomeDifferenceKernel() {
+    return selected_kernel.name;
+}
+
+uint64_t hashGenome(const uint8_t* genes, size_t size) {
+    uint64_t hash = mix64(size); // Applied per gene
+    for (size_t i = 0; i < size; i++) {
+        hash = mix64(hash ^ genes[i]);
+    }
+    return hash;
+}
+
+int genomeDifference(const uint8_t* a, size_t a_size, const uint8_t* b, size_t b_size) {
+    size_t common = std::min(a_size, b_size);
+    size_t length_difference = std::max(a_size, b_size) - common;
+    return diff_kernel(a, b, common) + (int)std::min(length_difference, (size_t)INT_MAX);
+}
+
+int genomeDifferenceScalar(const uint8_t* a, size_t a_size, const uint8_t* b, size_t b_size) {
+    size_t common = std::min(a_size, b_size);
+    size_t length_difference = std::max(a_size, b_size) - common;
+    return _diffScalar(a, b, common) + (int)std::min(length_difference, (size_t)INT_MAX);
+}
+
+int genomeDifferenceBounded(const uint8_t* a, size_t a_size, const uint8_t* b, size_t b_size, int limit) {
+    size_t common = std::min(a_size, b_size);
+    size_t length_difference = std::max(a_size, b_size) - common;
+    if (length_difference >= (size_t)std::max(limit, 0)) {
+        return (int)std::min(length_difference, (size_t)INT_MAX);
+    }
+
+    int differences = (int)length_difference;
+    for (size_t start = 0; start < common; start += BLOCK_GENES) {
+        differences += diff_kernel(a + start, b + start, std::min(BLOCK_GENES, common - start));
+        if (differences >= limit) break;
+    }
+    return differences;
+}
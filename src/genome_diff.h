@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Hamming distance between two genomes: the number of positions whose genes differ, plus the
+// difference in length (every missing gene counts as one difference).
+//
+// The kernels are vectorized with AVX2 when the CPU supports it (checked once at runtime),
+// otherwise with SSE2 on x86-64, and fall back to a plain loop everywhere else.
+int genomeDifference(const uint8_t* a, size_t a_size, const uint8_t* b, size_t b_size);
+
+// Same as genomeDifference(), but gives up as soon as the result is known to be >= limit.
+// Returns the exact difference when it is below limit, and some value >= limit otherwise.
+// Relatives only need "difference < RELATIVE_GENOME_DIFFERENCE", which usually fails fast.
+int genomeDifferenceBounded(const uint8_t* a, size_t a_size, const uint8_t* b, size_t b_size, int limit);
+
+// The plain loop the vector kernels replace, and the name of the kernel in use ("AVX2",
+// "SSE2" or "scalar"), for bench/genome_diff_bench.cpp.
+int genomeDifferenceScalar(const uint8_t* a, size_t a_size, const uint8_t* b, size_t b_size);
+const char* genomeDifferenceKernel();
+
+// The splitmix64 finalizer: scrambles all bits of x into all bits of the result.
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// A 64-bit hash of a whole genome, for tables keyed by genome. Equal genomes hash equally;
+// different ones rarely collide, so users still compare the genes on a hit.
+uint64_t hashGenome(const uint8_t* genes, size_t size);
@@ -0,0 +1,83 @@
+#include "genome_graph.h"
+#include "instructions.h"
+#include <algorithm>
+
+int getSuccessors(const std::vector<uint8_t>& genome, unsigned int pc, unsigned int successors[3]) {
+    const unsigned int size = (unsigned int)genome.size();
+    const unsigned int instruction = genome[pc];
+    switch (getInstructionInfo(instruction).flow) {
+        case FLOW_LOOK:
+            successors[0] = (pc + LOOK_EMPTY_OFFSET) % size;
+            successors[1] = (pc + LOOK_BOT_OFFSET) % size;
+            successors[2] = (pc + LOOK_ORGANIC_OFFSET) % size;
+            return 3;
+        case FLOW_CONDITIONAL:
+            successors[0] = (pc + conditionalJumpOffset(genome, pc)) % size;
+            successors[1] = (pc + CONDITIONAL_FALLTHROUGH_OFFSET) % size;
+            return 2;
+        case FLOW_JUMP:
+            successors[0] = (pc + instruction) % size;
+            return 1;
+        case FLOW_NEXT:
+        default:
+            successors[0] = (pc + 1) % size;
+            return 1;
+    }
+}
+
+std::string disassemble(const std::vector<uint8_t>& genome, unsigned int pc) {
+    const unsigned int instruction = genome[pc];
+    const InstructionInfo& info = getInstructionInfo(instruction);
+    if (info.flow == FLOW_JUMP) {
+        return std::string(info.name) + " [" + std::to_string((pc + instruction) % genome.size()) + "]";
+    }
+    return info.name;
+}
+
+GenomeGraph::GenomeGraph(const std::vector<uint8_t>& genome) {
+    const int size = (int)genome.size();
+    this->depth.assign(size, -1);
+    this->column.assign(size, -1);
+    this->successor_start.assign(size + 1, 0);
+    if (size == 0) return;
+
+    // Successor lists of every node (reachable or not), as one flat array.
+    this->successors.reserve(size * 2);
+    for (int pc = 0; pc < size; pc++) {
+        unsigned int next[3];
+        int count = getSuccessors(genome, (unsigned int)pc, next);
+        this->successors.insert(this->successors.end(), next, next + count);
+        this->successor_start[pc + 1] = (int)this->successors.size();
+    }
+
+    // Breadth-first layering from pc 0. The queue is 'order' itself.
+    // A conditional jump's "not taken" branch is shifted one column right, like the
+    // analyzer draws it (true path down, false path right).
+    std::vector<int> next_free_column;
+    this->order.reserve(size);
+    this->order.push_back(0);
+    this->depth[0] = 0;
+    this->column[0] = 0;
+    next_free_column.push_back(1);
+    for (size_t head = 0; head < this->order.size(); head++) {
+        int node = this->order[head];
+        int child_depth = this->depth[node] + 1;
+        bool is_conditional = getInstructionInfo(genome[node]).flow == FLOW_CONDITIONAL;
+        int branch = 0;
+        for (const unsigned int* it = successorsBegin(node); it != successorsEnd(node); ++it, ++branch) {
+            int child = (int)*it;
+            if (this->depth[child] >= 0) continue;
+            if ((int)next_free_column.size() <= child_depth) next_free_column.push_back(0);
+            int shift = (is_conditional && branch == 1) ? 1 : 0;
+            int col = std::max(this->column[node] + shift, next_free_column[child_depth]);
+            next_free_column[child_depth] = col + 1;
+            this->depth[child] = child_depth;
+            this->column[child] = col;
+            this->order.push_back(child);
+            this->max_depth = std::max(this->max_depth, child_depth);
+            this->max_column = std::max(this->max_column, col);
+        }
+    }
+    this->max_depth = std::max(this->max_depth, 0);
+    this->max_column = std::max(this->max_column, 0);
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Control flow of a genome program. The interpreter (Bot::_processGenome) and the genome
+// analyzer's graph both decode successors through these helpers, so the drawn graph always
+// matches what a bot actually executes.
+
+// LOOK advances the program counter by one of these, depending on what it sees.
+const int LOOK_EMPTY_OFFSET = 1;
+const int LOOK_BOT_OFFSET = 2;
+const int LOOK_ORGANIC_OFFSET = 3;
+// A conditional jump that is not taken skips its parameter gene.
+const int CONDITIONAL_FALLTHROUGH_OFFSET = 2;
+
+// The distance a taken conditional jump (JUMP_IF_*) at pc moves the program counter.
+inline unsigned int conditionalJumpOffset(const std::vector<uint8_t>& genome, unsigned int pc) {
+    return genome[(pc + 1) % genome.size()] % 10;
+}
+
+// Writes the possible next program counters of the instruction at pc (already reduced modulo
+// the genome size) and returns how many there are (1 to 3). Order: LOOK empty, bot, organic;
+// conditional jumps taken, not taken.
+int getSuccessors(const std::vector<uint8_t>& genome, unsigned int pc, unsigned int successors[3]);
+
+// The name of the instruction at pc, with the target of an unconditional jump ("JMP [12]").
+std::string disassemble(const std::vector<uint8_t>& genome, unsigned int pc);
+
+// The control-flow graph of a genome, restricted to the instructions reachable from pc 0,
+// with a layered layout: every node's depth is its breadth-first distance from pc 0, and
+// nodes of one depth get increasing columns, starting no further left than their parent.
+// Built iteratively in O(genome size).
+class GenomeGraph {
+public:
+    explicit GenomeGraph(const std::vector<uint8_t>& genome);
+    int getNodeCount() const { return (int)this->depth.size(); }
+    bool isReachable(int node) const { return this->depth[node] >= 0; }
+    int getDepth(int node) const { return this->depth[node]; }     // -1 if unreachable
+    int getColumn(int node) const { return this->column[node]; }   // -1 if unreachable
+    int getMaxDepth() const { return this->max_depth; }
+    int getMaxColumn() const { return this->max_column; }
+    // Successors of a node, see getSuccessors().
+    const unsigned int* successorsBegin(int node) const { return this->successors.data() + this->successor_start[node]; }
+    const unsigned int* successorsEnd(int node) const { return this->successors.data() + this->successor_start[node + 1]; }
+    const std::vector<int>& getReachableNodes() const { return this->order; } // In breadth-first order
+private:
+    std::vector<int> depth;
+    std::vector<int> column;
+    std::vector<int> successor_start; // Successors of node i: successors[successor_start[i] .. successor_start[i + 1])
+    std::vector<unsigned int> successors;
+    std::vector<int> order;
+    int max_depth = -1;
+    int max_column = -1;
+};
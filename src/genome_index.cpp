@@ -0,0 +1,172 @@
+#include "genome_index.h"
+#include "genome_diff.h"
+#include "bot.h"
+#include <algorithm>
+
+// Removes one occurrence of value from an unordered bucket.
+static void eraseOne(std::vector<int>& bucket, int value) {
+    auto it = std::find(bucket.begin(), bucket.end(), value);
+    if (it != bucket.end()) {
+        *it = bucket.back();
+        bucket.pop_back();
+    }
+}
+
+GenomeIndex::GenomeIndex(int max_distance) : max_distance(std::max(0, max_distance)), classes(this->max_distance + 1) {}
+
+// Computes the band keys of a genome: one per class for each prefix length from
+// size - max_distance up to the full size. The key covers the prefix length, the class
+// and the genes of that class within the prefix.
+void GenomeIndex::_bandKeys(const std::vector<uint8_t>& genome, std::vector<uint64_t>& keys) const {
+    keys.clear();
+    int size = (int)genome.size();
+    int first_prefix = std::max(0, size - max_distance);
+    uint64_t class_hashes[64];
+    uint64_t* hashes = class_hashes;
+    std::vector<uint64_t> large_hashes;
+    if (classes > 64) {
+        large_hashes.resize(classes);
+        hashes = large_hashes.data();
+    }
+    std::fill(hashes, hashes + classes, 0);
+
+    int c = 0;
+    for (int i = 0; i <= size; i++) {
+        if (i >= first_prefix) {
+            for (int k = 0; k < classes; k++) {
+                keys.push_back(mix64(hashes[k] ^ mix64(((uint64_t)i << 16) | (uint64_t)k)));
+            }
+        }
+        if (i < size) {
+            hashes[c] = mix64(hashes[c] ^ (genome[i] + 1));
+            if (++c == classes) c = 0;
+        }
+    }
+}
+
+int GenomeIndex::_findOrCreateEntry(const std::vector<uint8_t>& genome) {
+    uint64_t hash = hashGenome(genome.data(), genome.size());
+    std::vector<int>& same_hash = this->entries_by_hash[hash];
+    for (int entry_id : same_hash) {
+        if (this->entries[entry_id].genome == genome) return entry_id;
+    }
+
+    int entry_id;
+    if (!this->free_entries.empty()) {
+        entry_id = this->free_entries.back();
+        this->free_entries.pop_back();
+    } else {
+        entry_id = (int)this->entries.size();
+        this->entries.emplace_back();
+    }
+    Entry& entry = this->entries[entry_id];
+    entry.genome = genome;
+    entry.hash = hash;
+    _bandKeys(genome, entry.bands);
+    for (uint64_t key : entry.bands) {
+        this->bands[key].push_back(entry_id);
+    }
+    same_hash.push_back(entry_id);
+    return entry_id;
+}
+
+void GenomeIndex::_releaseEntry(int entry_id) {
+    Entry& entry = this->entries[entry_id];
+    for (uint64_t key : entry.bands) {
+        auto it = this->bands.find(key);
+        if (it == this->bands.end()) continue;
+        eraseOne(it->second, entry_id);
+        if (it->second.empty()) this->bands.erase(it);
+    }
+    auto it = this->entries_by_hash.find(entry.hash);
+    if (it != this->entries_by_hash.end()) {
+        eraseOne(it->second, entry_id);
+        if (it->second.empty()) this->entries_by_hash.erase(it);
+    }
+    entry.genome.clear();
+    entry.genome.shrink_to_fit();
+    entry.bands.clear();
+    this->free_entries.push_back(entry_id);
+}
+
+void GenomeIndex::add(Bot* bot_ptr) {
+    if (this->bot_slots.count(bot_ptr)) return;
+    int entry_id = _findOrCreateEntry(bot_ptr->getGenome());
+    std::vector<Bot*>& bots = this->entries[entry_id].bots;
+    this->bot_slots[bot_ptr] = {entry_id, (int)bots.size()};
+    bots.push_back(bot_ptr);
+}
+
+// The slot is looked up by pointer rather than by genome, so removal works even if the
+// bot's genome was edited after it was added (e.g. by the genome analyzer).
+void GenomeIndex::remove(Bot* bot_ptr) {
+    auto it = this->bot_slots.find(bot_ptr);
+    if (it == this->bot_slots.end()) return;
+    BotSlot slot = it->second;
+    this->bot_slots.erase(it);
+
+    std::vector<Bot*>& bots = this->entries[slot.entry].bots;
+    Bot* moved = bots.back();
+    bots[slot.index] = moved;
+    bots.pop_back();
+    if (moved != bot_ptr) {
+        this->bot_slots[moved].index = slot.index;
+    }
+    if (bots.empty()) {
+        _releaseEntry(slot.entry);
+    }
+}
+
+void GenomeIndex::clear() {
+    this->entries.clear();
+    this->free_entries.clear();
+    this->entries_by_hash.clear();
+    this->bands.clear();
+    this->bot_slots.clear();
+    this->visited.clear();
+}
+
+void GenomeIndex::reserve(size_t bot_count) {
+    // Related genomes share most of their band keys, so a few buckets per bot are plenty.
+    this->bot_slots.reserve(bot_count);
+    this->entries_by_hash.reserve(bot_count);
+    this->bands.reserve(bot_count * this->classes);
+}
+
+void GenomeIndex::findWithin(const std::vector<uint8_t>& genome, int max_distance, std::vector<Bot*>& out) const {
+    if (max_distance < 0) return;
+    auto collect = [&](int entry_id) {
+        const Entry& entry = this->entries[entry_id];
+        if (entry.bots.empty()) return;
+        int distance = genomeDifferenceBounded(genome.data(), genome.size(), entry.genome.data(), entry.genome.size(), max_distance + 1);
+        if (distance <= max_distance) {
+            out.insert(out.end(), entry.bots.begin(), entry.bots.end());
+        }
+    };
+
+    if (max_distance > this->max_distance) {
+        for (int entry_id = 0; entry_id < (int)this->entries.size(); entry_id++) {
+            collect(entry_id);
+        }
+        return;
+    }
+
+    if (this->visited.size() < this->entries.size()) {
+        this->visited.resize(this->entries.size(), 0);
+    }
+    if (++this->query_stamp == 0) { // Wrapped around, forget all old stamps
+        std::fill(this->visited.begin(), this->visited.end(), 0);
+        this->query_stamp = 1;
+    }
+
+    _bandKeys(genome, this->query_keys);
+    for (uint64_t key : this->query_keys) {
+        auto it = this->bands.find(key);
+        if (it == this->bands.end()) continue;
+        for (int entry_id : it->second) {
+            if (this->visited[entry_id] == this->query_stamp) continue;
+            this->visited[entry_id] = this->query_stamp;
+            collect(entry_id);
+        }
+    }
+}
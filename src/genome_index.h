@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class Bot;
+
+// An index over the genomes of living bots that answers "which bots are within distance k of
+// this genome" (see genomeDifference()) without comparing against every bot.
+//
+// Bots with identical genomes share one entry, so a clonal population costs a single lookup.
+// Entries are found through banded hashing: the gene positions are split into
+// max_distance + 1 interleaved classes (position % classes), and every class of a genome is
+// hashed on its own. Two genomes within max_distance cannot differ in every class, so they
+// always share at least one band and the search is exact, not approximate. To allow for
+// length differences, each genome is also banded at the max_distance shorter prefix lengths.
+// Candidates sharing a band are then verified with the bounded distance kernel.
+class GenomeIndex {
+public:
+    explicit GenomeIndex(int max_distance);
+    void add(Bot* bot_ptr);
+    void remove(Bot* bot_ptr); // Does nothing if the bot is not indexed
+    void clear();
+    void reserve(size_t bot_count); // Avoids rehashing while a whole population is added
+    // Appends every indexed bot whose genome is at most max_distance away from genome.
+    // Distances above the index's own max_distance fall back to checking every genome.
+    void findWithin(const std::vector<uint8_t>& genome, int max_distance, std::vector<Bot*>& out) const;
+    int getBotCount() const { return (int)this->bot_slots.size(); }
+    int getGenomeCount() const { return (int)(this->entries.size() - this->free_entries.size()); }
+private:
+    struct Entry {
+        std::vector<uint8_t> genome;
+        uint64_t hash = 0;
+        std::vector<Bot*> bots;       // Empty for unused entries
+        std::vector<uint64_t> bands;  // Band keys this entry is listed under
+    };
+    struct BotSlot {
+        int entry;
+        int index; // Position in Entry::bots
+    };
+    void _bandKeys(const std::vector<uint8_t>& genome, std::vector<uint64_t>& keys) const;
+    int _findOrCreateEntry(const std::vector<uint8_t>& genome);
+    void _releaseEntry(int entry_id);
+
+    int max_distance;
+    int classes;
+    std::vector<Entry> entries;
+    std::vector<int> free_entries;
+    std::unordered_map<uint64_t, std::vector<int>> entries_by_hash; // Full genome hash -> entries
+    std::unordered_map<uint64_t, std::vector<int>> bands;           // Band key -> entries
+    std::unordered_map<const Bot*, BotSlot> bot_slots;
+
+    // Scratch space for queries, so findWithin() does not allocate.
+    mutable std::vector<uint64_t> query_keys;
+    mutable std::vector<unsigned int> visited; // Per entry: query stamp of the last visit
+    mutable unsigned int query_stamp = 0;
+};
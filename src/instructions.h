@@ -1,30 +1,76 @@
 #pragma once
 
+// The instruction set. Every opcode is described once here; the interpreter
+// (Bot::_processGenome), the control-flow graph (getSuccessors), the static analysis and the
+// disassembly in the inspector and the genome analyzer are all driven by this table.
+//
+// X(opcode, name, mnemonic, operands, flow, action)
+//   name      Shown in the genome analyzer
+//   mnemonic  Short form for the inspector's genome listing
+//   operands  Values popped from the memory stack (0 if the stack is empty)
+//   flow      How the program counter moves on, see InstructionFlow
+//   action    Has an effect on energy or the world (see isActionInstruction())
+#define INSTRUCTION_SET(X) \
+    /* Actions */ \
+    X(MOVE,              "MOVE",         "MOVE",   1, FLOW_NEXT,        true)  \
+    X(TURN,              "TURN",         "TURN",   1, FLOW_NEXT,        false) \
+    X(LOOK,              "LOOK",         "LOOK",   1, FLOW_LOOK,        false) \
+    X(ATTACK,            "ATTACK",       "ATTACK", 1, FLOW_NEXT,        true)  \
+    X(PHOTOSYNTHIZE,     "PHOTO",        "PHOTO",  0, FLOW_NEXT,        true)  \
+    X(CHECK_RELATIVE,    "CH_RELATIVE",  "RELAT",  1, FLOW_NEXT,        false) \
+    X(SHARE_ENERGY,      "SHARE",        "SHARE",  1, FLOW_NEXT,        true)  \
+    X(CONSUME_ORGANIC,   "EAT_ORGANIC",  "EAT",    1, FLOW_NEXT,        true)  \
+    X(REPRODUCE,         "REPRODUCE",    "REPRO",  0, FLOW_NEXT,        true)  \
+    /* Checks */ \
+    X(CHECK_BIOME,       "CH_BIOME",     "BIOME",  0, FLOW_NEXT,        false) \
+    X(CHECK_X,           "CHECK_X",      "CH_X",   0, FLOW_NEXT,        false) \
+    X(CHECK_Y,           "CHECK_Y",      "CH_Y",   0, FLOW_NEXT,        false) \
+    X(CHECK_ENERGY,      "CHECK_ENERGY", "CH_NRG", 0, FLOW_NEXT,        false) \
+    X(CHECK_AGE,         "CHECK_AGE",    "CH_AGE", 0, FLOW_NEXT,        false) \
+    /* Control Flow */ \
+    X(JUMP_IF_EQUAL,     "JMP_EQ",       "JE",     2, FLOW_CONDITIONAL, false) \
+    X(JUMP_IF_NOT_EQUAL, "JMP_NE",       "JNE",    2, FLOW_CONDITIONAL, false) \
+    X(JUMP_IF_GREATER,   "JMP_GT",       "JG",     2, FLOW_CONDITIONAL, false) \
+    /* Start of generic jump range: every value from JUMP to MAX_INSTRUCTION_VALUE */ \
+    X(JUMP,              "JMP",          "JUMP",   0, FLOW_JUMP,        false)
+
 enum Instruction {
-    // Actions
-    MOVE = 0,
-    TURN,
-    LOOK,
-    ATTACK,
-    PHOTOSYNTHIZE,
-    CHECK_RELATIVE,
-    SHARE_ENERGY,
-    CONSUME_ORGANIC,
-    REPRODUCE,
-    // Checks
-    CHECK_BIOME,
-    CHECK_X,
-    CHECK_Y,
-    CHECK_ENERGY,
-    CHECK_AGE,
-
-    // Control Flow
-    JUMP_IF_EQUAL,
-    JUMP_IF_NOT_EQUAL,
-    JUMP_IF_GREATER,
-
-    // Start of generic jump range
-    JUMP
+#define INSTRUCTION_ENUM(opcode, name, mnemonic, operands, flow, action) opcode,
+    INSTRUCTION_SET(INSTRUCTION_ENUM)
+#undef INSTRUCTION_ENUM
+    INSTRUCTION_COUNT // Distinct opcodes; all values from JUMP up are the same opcode
+};
+
+const int MAX_INSTRUCTION_VALUE = 127; // Genes are stored as bytes (std::vector<uint8_t>)
+
+enum InstructionFlow {
+    FLOW_NEXT,        // On to pc + 1
+    FLOW_LOOK,        // pc + 1, 2 or 3 for an empty cell, a bot or organic matter
+    FLOW_CONDITIONAL, // Taken: the parameter gene's offset; not taken: skip the parameter
+    FLOW_JUMP         // pc + the instruction value
+};
+
+struct InstructionInfo {
+    const char* name;
+    const char* mnemonic;
+    int operands;
+    InstructionFlow flow;
+    bool action;
+};
+
+constexpr InstructionInfo INSTRUCTION_TABLE[INSTRUCTION_COUNT] = {
+#define INSTRUCTION_INFO(opcode, name, mnemonic, operands, flow, action) {name, mnemonic, operands, flow, action},
+    INSTRUCTION_SET(INSTRUCTION_INFO)
+#undef INSTRUCTION_INFO
 };
 
-const int MAX_INSTRUCTION_VALUE = 127;
+// The opcode of a gene: the gene itself, or JUMP for the whole jump range.
+constexpr unsigned int getOpcode(unsigned int instruction) {
+    return instruction < JUMP ? instruction : JUMP;
+}
+
+constexpr const InstructionInfo& getInstructionInfo(unsigned int instruction) {
+    return INSTRUCTION_TABLE[getOpcode(instruction)];
+}
+
+static_assert(JUMP == 17 && INSTRUCTION_COUNT == 18, "Saved genomes depend on the opcode values");
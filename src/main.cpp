@@ -5,20 +5,271 @@
 #include "world.h"
 #include "config.h"
 #include "ui.h"
+#include "renderer.h"
+#include "simulation.h"
+#include "checkpointer.h"
+#include "trajectory.h"
+#include "telemetry.h"
+#include "genome_bank.h"
+#include "viewport.h"
+#include "survival_evaluator.h"
+#include <memory>
+#include <algorithm>
+#include <chrono>
 #include <random>
 #include <string>
 #include <ctime>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
 
-int main(void)
+// Scores a saved bot with a Monte Carlo survival estimate and prints the report.
+static int runEvaluation(const std::string& bot_file, const EvaluationSettings& settings) {
+    std::unique_ptr<Bot> bot(Bot::loadFromFile(bot_file));
+    if (!bot) {
+        fprintf(stderr, "Could not read %s\n", bot_file.c_str());
+        return 1;
+    }
+    EvaluationReport report = evaluateSurvival(*bot, settings);
+    auto print = [](const char* label, const Distribution& d) {
+        printf("%-15s mean %.1f, min %.0f, p10 %.0f, median %.0f, p90 %.0f, max %.0f\n",
+               label, d.mean, d.min, d.p10, d.median, d.p90, d.max);
+    };
+    printf("%d scenarios of %d steps\n", (int)report.scenarios.size(), settings.max_steps);
+    printf("survival rate   %.1f%% (sunny %.1f%%, balanced %.1f%%, dark %.1f%%)\n", report.survival_rate * 100.0f,
+           report.survival_rate_by_biome[BIOME_SUNNY] * 100.0f, report.survival_rate_by_biome[BIOME_BALANCED] * 100.0f,
+           report.survival_rate_by_biome[BIOME_DARK] * 100.0f);
+    print("survival steps", report.survival_steps);
+    print("reproductions", report.reproductions);
+    if (!report.energy_median.empty()) {
+        printf("median energy   %.0f at start, %.0f at the end\n", report.energy_median.front(), report.energy_median.back());
+    }
+    return 0;
+}
+
+// Rebuilds a checkpoint (a delta is applied to its chain) and writes it as one full world
+// save, so that the chain's files are no longer needed.
+static int runCompaction(const std::string& checkpoint_file, const std::string& output_file, int compression_level) {
+    World world = World();
+    if (!loadCheckpoint(world, checkpoint_file)) {
+        fprintf(stderr, "Could not read %s (or a checkpoint it depends on)\n", checkpoint_file.c_str());
+        return 1;
+    }
+    if (!world.saveWorld(output_file, compression_level)) {
+        fprintf(stderr, "Could not write %s\n", output_file.c_str());
+        return 1;
+    }
+    printf("step %lld: %d bots written to %s\n", world.getStepCount(), world.getBotsSize(), output_file.c_str());
+    return 0;
+}
+
+// Adds bot files (or the bot files in directories) to a genome bank, which is created if it
+// does not exist yet.
+static int runBankImport(const std::string& bank_file, const std::vector<std::string>& bot_files, int compression_level) {
+    GenomeBank bank;
+    if (FileExists(bank_file.c_str()) && !bank.load(bank_file)) {
+        fprintf(stderr, "Could not read %s\n", bank_file.c_str());
+        return 1;
+    }
+    int before = bank.size();
+    int imported = bank.importBotFiles(bot_files);
+    if (!bank.save(bank_file, compression_level)) {
+        fprintf(stderr, "Could not write %s\n", bank_file.c_str());
+        return 1;
+    }
+    printf("%d bot files imported: %d new genomes, %d in %s\n", imported, bank.size() - before, bank.size(), bank_file.c_str());
+    return 0;
+}
+
+// Runs the simulation without a window, then writes the census (and optionally the phylogeny).
+// Usage: main --headless [--steps N] [--seed S] [--bots N] [--census FILE] [--phylogeny FILE]
+//                        [--autosave N] [--autosave-keep K] [--autosave-file FILE] [--autosave-keyframes K]
+//                        [--compress LEVEL] [--record FILE] [--record-every N] [--resume CHECKPOINT]
+//                        [--telemetry FILE] [--telemetry-every N] [--bank BANK] [--bank-save BANK]
+//        main --headless --compact CHECKPOINT [--output FILE] [--compress LEVEL]
+//        main --headless --evaluate BOT_FILE [--scenarios N] [--steps N] [--seed S] [--threads N] [--bank BANK]
+//        main --headless --bank BANK --bank-import FILE_OR_DIR [--bank-import FILE_OR_DIR ...]
+// With --bank, a new world starts with copies of the bank's genomes and an evaluation draws
+// the neighbors from them. --bank-save adds the living genomes to a bank at the end.
+static int runHeadless(int argc, char** argv) {
+    long long steps = 10000;
+    unsigned int seed = (unsigned int)time(NULL);
+    int initial_bots = 10000;
+    std::string census_file = "census.csv";
+    std::string phylogeny_file;
+    std::string evaluate_file;
+    EvaluationSettings evaluation;
+    long long autosave_interval = 0;
+    int autosave_keep = 3;
+    std::string autosave_file = "autosave.save";
+    int autosave_keyframes = 1;
+    std::string compact_file;
+    std::string output_file = "compacted.save";
+    int compression_level = SAVE_COMPRESSION_LEVEL;
+    std::string record_file;
+    long long record_every = TRAJECTORY_DEFAULT_INTERVAL;
+    std::string resume_file;
+    std::string telemetry_file;
+    long long telemetry_every = 1;
+    std::string bank_file;
+    std::string bank_save_file;
+    std::vector<std::string> bank_imports;
+    bool has_steps = false;
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--steps") == 0 && has_value) { steps = atoll(argv[++i]); has_steps = true; }
+        else if (strcmp(argv[i], "--seed") == 0 && has_value) seed = (unsigned int)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--bots") == 0 && has_value) initial_bots = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--census") == 0 && has_value) census_file = argv[++i];
+        else if (strcmp(argv[i], "--phylogeny") == 0 && has_value) phylogeny_file = argv[++i];
+        else if (strcmp(argv[i], "--evaluate") == 0 && has_value) evaluate_file = argv[++i];
+        else if (strcmp(argv[i], "--scenarios") == 0 && has_value) evaluation.scenarios = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && has_value) evaluation.threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--autosave") == 0 && has_value) autosave_interval = atoll(argv[++i]);
+        else if (strcmp(argv[i], "--autosave-keep") == 0 && has_value) autosave_keep = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--autosave-file") == 0 && has_value) autosave_file = argv[++i];
+        else if (strcmp(argv[i], "--autosave-keyframes") == 0 && has_value) autosave_keyframes = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--compact") == 0 && has_value) compact_file = argv[++i];
+        else if (strcmp(argv[i], "--output") == 0 && has_value) output_file = argv[++i];
+        else if (strcmp(argv[i], "--compress") == 0 && has_value) compression_level = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--record") == 0 && has_value) record_file = argv[++i];
+        else if (strcmp(argv[i], "--record-every") == 0 && has_value) record_every = std::max(1LL, atoll(argv[++i]));
+        else if (strcmp(argv[i], "--resume") == 0 && has_value) resume_file = argv[++i];
+        else if (strcmp(argv[i], "--telemetry") == 0 && has_value) telemetry_file = argv[++i];
+        else if (strcmp(argv[i], "--telemetry-every") == 0 && has_value) telemetry_every = std::max(1LL, atoll(argv[++i]));
+        else if (strcmp(argv[i], "--bank") == 0 && has_value) bank_file = argv[++i];
+        else if (strcmp(argv[i], "--bank-save") == 0 && has_value) bank_save_file = argv[++i];
+        else if (strcmp(argv[i], "--bank-import") == 0 && has_value) bank_imports.push_back(argv[++i]);
+    }
+
+    if (!bank_imports.empty()) {
+        if (bank_file.empty()) {
+            fprintf(stderr, "--bank-import needs --bank\n");
+            return 1;
+        }
+        return runBankImport(bank_file, bank_imports, compression_level);
+    }
+    // The whole bank is read once; seeding and evaluating then copy from memory.
+    GenomeBank bank;
+    if (!bank_file.empty() && (!bank.load(bank_file) || bank.size() == 0)) {
+        fprintf(stderr, "Could not read %s (or it is empty)\n", bank_file.c_str());
+        return 1;
+    }
+
+    if (!evaluate_file.empty()) {
+        if (has_steps) evaluation.max_steps = (int)std::min(steps, (long long)INT_MAX);
+        evaluation.seed = seed;
+        if (bank.size() > 0) evaluation.neighbor_pool = std::make_shared<const std::vector<Bot>>(bank.getBots());
+        return runEvaluation(evaluate_file, evaluation);
+    }
+
+    if (!compact_file.empty()) return runCompaction(compact_file, output_file, compression_level);
+
+    // A resumed run goes on exactly as the saved one would have (save format version 2).
+    World world = World();
+    if (resume_file.empty() && bank.size() > 0) {
+        world.newWorld(seed, 0);
+        world.spawnCopies(bank.getBots(), initial_bots);
+    } else if (resume_file.empty()) {
+        world.newWorld(seed, initial_bots);
+    } else if (!loadCheckpoint(world, resume_file)) {
+        fprintf(stderr, "Could not read %s (or a checkpoint it depends on)\n", resume_file.c_str());
+        return 1;
+    }
+    Checkpointer checkpointer;
+    checkpointer.setCompressionLevel(compression_level);
+    TrajectoryRecorder recorder;
+    if (!record_file.empty()) {
+        if (!recorder.start(record_file, world.getWidth(), world.getHeight(), TRAJECTORY_KEYFRAME_INTERVAL)) {
+            fprintf(stderr, "Could not write %s\n", record_file.c_str());
+            return 1;
+        }
+        world.setTrackingCells(record_every < TRAJECTORY_TRACKING_INTERVAL);
+        recorder.record(world);
+    }
+    TelemetryWriter telemetry;
+    if (!telemetry_file.empty() && !telemetry.start(telemetry_file, world, telemetry_every)) {
+        fprintf(stderr, "Could not write %s\n", telemetry_file.c_str());
+        return 1;
+    }
+    for (long long i = 0; i < steps; i++) {
+        std::chrono::steady_clock::time_point step_start = std::chrono::steady_clock::now();
+        world.process();
+        telemetry.recordStep(std::chrono::duration<double>(std::chrono::steady_clock::now() - step_start).count());
+        const long long step = world.getStepCount();
+        if (recorder.isRecording() && step % record_every == 0) recorder.record(world);
+        if (autosave_interval > 0 && step % autosave_interval == 0 && !checkpointer.isBusy()) {
+            WorldImage image;
+            world.captureImage(image);
+            if (autosave_keyframes > 1) {
+                checkpointer.submitIncremental(std::move(image), autosave_file, autosave_keyframes, autosave_keep);
+            } else {
+                checkpointer.submit(std::move(image), autosave_file, autosave_keep);
+            }
+        }
+        if (step % 1000 == 0) {
+            CensusSample census = world.getCensus().getCurrent();
+            printf("step %lld: %d bots, %d clades, mean energy %.1f\n", step, census.bots, census.clades, census.mean_energy);
+        }
+    }
+
+    checkpointer.wait();
+    telemetry.stop();
+    if (telemetry.hasFailed() || telemetry.getDroppedRows() > 0) {
+        fprintf(stderr, "Could not write all of %s (%lld rows dropped)\n", telemetry_file.c_str(), telemetry.getDroppedRows());
+    }
+    recorder.stop();
+    if (recorder.hasFailed()) {
+        fprintf(stderr, "Could not write %s (the recording ends early)\n", record_file.c_str());
+    } else if (recorder.getSkippedFrames() > 0) {
+        fprintf(stderr, "Could not write all of %s (%lld frames skipped)\n", record_file.c_str(), recorder.getSkippedFrames());
+    }
+    if (checkpointer.getFailureCount() > 0) {
+        fprintf(stderr, "Could not write %s (%d autosaves failed)\n", autosave_file.c_str(), checkpointer.getFailureCount());
+    }
+    // Equal checksums mean equal worlds, e.g. for checking that a resumed run matches.
+    printf("step %lld: state checksum %08x\n", world.getStepCount(), world.getStateChecksum());
+    if (!world.getCensus().exportCsv(census_file)) {
+        fprintf(stderr, "Could not write %s\n", census_file.c_str());
+        return 1;
+    }
+    if (!phylogeny_file.empty() && !world.getPhylogeny().exportNewick(phylogeny_file)) {
+        fprintf(stderr, "Could not write %s\n", phylogeny_file.c_str());
+        return 1;
+    }
+    if (!bank_save_file.empty()) {
+        GenomeBank saved;
+        if (FileExists(bank_save_file.c_str()) && !saved.load(bank_save_file)) {
+            fprintf(stderr, "Could not read %s\n", bank_save_file.c_str());
+            return 1;
+        }
+        int added = saved.addWorld(world, "seed " + std::to_string(world.getSeed()));
+        if (!saved.save(bank_save_file, compression_level)) {
+            fprintf(stderr, "Could not write %s\n", bank_save_file.c_str());
+            return 1;
+        }
+        printf("%d new genomes banked, %d in %s\n", added, saved.size(), bank_save_file.c_str());
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
 {
-    const int screenWidth = WORLD_WIDTH * CELL_SIZE + SIDE_PANEL_WIDTH;
-    const int screenHeight = TOP_PANEL_HEIGHT + WORLD_HEIGHT * CELL_SIZE + BOTTOM_PANEL_HEIGHT;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) return runHeadless(argc, argv);
+    }
+
+    // The world is shown through a zoomable viewport, so the window no longer has to fit it.
+    const int screenWidth = std::min(WORLD_WIDTH * CELL_SIZE, MAX_INITIAL_VIEWPORT_WIDTH) + SIDE_PANEL_WIDTH;
+    const int screenHeight = TOP_PANEL_HEIGHT + std::min(WORLD_HEIGHT * CELL_SIZE, MAX_INITIAL_VIEWPORT_HEIGHT) + BOTTOM_PANEL_HEIGHT;
 
     World world = World();
     world.newWorld((unsigned int)time(NULL), 10000);
 
-    SetConfigFlags(FLAG_WINDOW_ALWAYS_RUN);
+    SetConfigFlags(FLAG_WINDOW_ALWAYS_RUN | FLAG_WINDOW_RESIZABLE);
     InitWindow(screenWidth, screenHeight, "Simulation");
+    SetWindowMinSize(SIDE_PANEL_WIDTH + 200, TOP_PANEL_HEIGHT + BOTTOM_PANEL_HEIGHT + 200);
     rlImGuiSetup(true); // Initialize ImGui with dark mode
 
     // Increase the global UI scale for better readability.
@@ -29,42 +280,52 @@ int main(void)
 
     SetExitKey(KEY_NULL);
 
-    SetTargetFPS(0);
+    // The GUI runs at a fixed frame rate; the simulation steps on its own thread.
+    SetTargetFPS(TARGET_FPS);
     UI ui;
-    int frame_counter = 0;
+    WorldRenderer renderer;
+    Viewport viewport;
+    Simulation simulation(world);
+    simulation.start();
 
     // Main loop
     while (!WindowShouldClose())
     {
+        // Always draw the newest state the simulation thread has published, or the frame of
+        // the trajectory being played back.
+        const RenderSnapshot& snapshot = ui.isPlayingBack() ? ui.updatePlayback() : simulation.acquireSnapshot();
+        viewport.setScreenRect({0, (float)TOP_PANEL_HEIGHT,
+                                (float)(GetScreenWidth() - SIDE_PANEL_WIDTH),
+                                (float)(GetScreenHeight() - TOP_PANEL_HEIGHT - BOTTOM_PANEL_HEIGHT)});
+        viewport.setWorldSize(snapshot.width, snapshot.height);
+
         // --- Input Handling ---
-        ui.handleInput(world);
+        ui.handleInput(simulation, snapshot, viewport);
 
         // --- State Update ---
-        if (!ui.isPaused()) {
-            if (frame_counter % ui.getSpeedDivisor() == 0) {
-                world.process();
-                ui.update(); // Check for dead selected bot after processing
-            }
-        }
-        frame_counter = (frame_counter + 1) % 12;
+        // Pausing waits for the running step to finish, so the genome analyzer can safely
+        // run its local simulation on this thread while the main one is paused. Once paused
+        // this returns at once, even while commands (loads, bank files) run.
+        simulation.setPaused(ui.isPaused());
+        simulation.setViewMode(ui.getViewMode());
 
         // --- Drawing ---
         BeginDrawing();
             ClearBackground(BG_COLOR);
             // --- Simulation & UI ---
-            rlPushMatrix();
-            rlTranslatef(0, (float)TOP_PANEL_HEIGHT, 0);
-            world.render(ui.getViewMode(), ui.getOrganismRoot(), ui.getHighlightedRelatives());
-            ui.drawWorldOverlay();
-            rlPopMatrix();
-            
+            renderer.update(snapshot, viewport);
+            renderer.draw(viewport);
+            ui.drawWorldOverlay(snapshot, viewport);
+
             rlImGuiBegin();
-            ui.drawPanels(world);
+            ui.drawPanels(simulation, snapshot);
             rlImGuiEnd();
 
         EndDrawing();
     }
 
+    simulation.stop();
+    renderer.unload();
     rlImGuiShutdown();
     CloseWindow(); 
 
@@ -0,0 +1,147 @@
+#include "phylogeny.h"
+#include <algorithm>
+#include <fstream>
+
+static const uint32_t BINARY_VERSION = 1;
+
+uint64_t Phylogeny::addBirth(uint64_t parent_id, long long step, int mutations) {
+    uint64_t id = this->next_id;
+    restoreBirth(id, parent_id, step, mutations);
+    return id;
+}
+
+void Phylogeny::restoreBirth(uint64_t id, uint64_t parent_id, long long step, int mutations) {
+    Node* parent = _find(parent_id);
+    if (parent != nullptr) {
+        parent->retained_children++;
+    } else {
+        parent_id = 0;
+    }
+    this->next_id = id + 1;
+    this->nodes.push_back({id, parent_id, step, -1, (uint32_t)std::max(0, mutations), 0, false});
+}
+
+void Phylogeny::recordDeath(uint64_t id, long long step) {
+    Node* node = _find(id);
+    if (node == nullptr || node->death_step >= 0) return;
+    node->death_step = step;
+
+    // Release this node and every ancestor that was only kept for it.
+    while (node != nullptr && node->death_step >= 0 && node->retained_children == 0) {
+        node->pruned = true;
+        this->pruned_count++;
+        node = _find(node->parent_id);
+        if (node != nullptr) node->retained_children--;
+    }
+
+    if (this->pruned_count > 1024 && this->pruned_count * 2 > this->nodes.size()) {
+        _compact();
+    }
+}
+
+void Phylogeny::clear() {
+    this->nodes.clear();
+    this->next_id = 1;
+    this->pruned_count = 0;
+}
+
+Phylogeny::Node* Phylogeny::_find(uint64_t id) {
+    auto it = std::lower_bound(this->nodes.begin(), this->nodes.end(), id,
+                               [](const Node& node, uint64_t id) { return node.id < id; });
+    if (it == this->nodes.end() || it->id != id || it->pruned) return nullptr;
+    return &*it;
+}
+
+const Phylogeny::Node* Phylogeny::find(uint64_t id) const {
+    return const_cast<Phylogeny*>(this)->_find(id);
+}
+
+void Phylogeny::_compact() {
+    this->nodes.erase(std::remove_if(this->nodes.begin(), this->nodes.end(), [](const Node& node) { return node.pruned; }),
+                      this->nodes.end());
+    this->pruned_count = 0;
+}
+
+bool Phylogeny::exportNewick(const std::string& filename) const {
+    std::ofstream out(filename);
+    if (!out.is_open()) return false;
+
+    // Children lists as index ranges: parents always precede their children in 'nodes'.
+    std::vector<size_t> live;
+    live.reserve(getNodeCount());
+    for (size_t i = 0; i < this->nodes.size(); i++) {
+        if (!this->nodes[i].pruned) live.push_back(i);
+    }
+    auto index_of = [&](uint64_t id) -> long long {
+        auto it = std::lower_bound(live.begin(), live.end(), id,
+                                   [this](size_t i, uint64_t id) { return this->nodes[i].id < id; });
+        if (it == live.end() || this->nodes[*it].id != id) return -1;
+        return (long long)(it - live.begin());
+    };
+    std::vector<long long> parent(live.size());
+    std::vector<size_t> child_count(live.size() + 1, 0);
+    for (size_t i = 0; i < live.size(); i++) {
+        parent[i] = index_of(this->nodes[live[i]].parent_id);
+        child_count[parent[i] < 0 ? live.size() : (size_t)parent[i]]++;
+    }
+    // child_start[i]..child_start[i + 1] in 'children'; the virtual root is index live.size().
+    std::vector<size_t> child_start(live.size() + 2, 0);
+    for (size_t i = 0; i <= live.size(); i++) child_start[i + 1] = child_start[i] + child_count[i];
+    std::vector<size_t> children(live.size());
+    std::vector<size_t> fill(child_start.begin(), child_start.end() - 1);
+    for (size_t i = 0; i < live.size(); i++) {
+        children[fill[parent[i] < 0 ? live.size() : (size_t)parent[i]]++] = i;
+    }
+
+    // Iterative depth-first walk, the tree can be far deeper than the call stack allows.
+    struct Frame { size_t node; size_t next_child; };
+    std::vector<Frame> stack = {{live.size(), child_start[live.size()]}};
+    out << "(";
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        size_t end = child_start[frame.node + 1];
+        if (frame.next_child < end) {
+            if (frame.next_child > child_start[frame.node]) out << ",";
+            size_t child = children[frame.next_child++];
+            if (child_start[child] < child_start[child + 1]) out << "(";
+            stack.push_back({child, child_start[child]});
+            continue;
+        }
+        size_t index = frame.node;
+        stack.pop_back();
+        if (index == live.size()) break;
+        const Node& node = this->nodes[live[index]];
+        if (child_start[index] < child_start[index + 1]) out << ")";
+        long long parent_birth = parent[index] < 0 ? 0 : this->nodes[live[(size_t)parent[index]]].birth_step;
+        out << node.id << ":" << (node.birth_step - parent_birth);
+    }
+    out << ");\n";
+    return out.good();
+}
+
+template <typename T>
+static void writeLittleEndian(std::ofstream& out, T value) {
+    unsigned char bytes[sizeof(T)];
+    for (size_t i = 0; i < sizeof(T); i++) {
+        bytes[i] = (unsigned char)((uint64_t)value >> (8 * i));
+    }
+    out.write(reinterpret_cast<const char*>(bytes), sizeof(T));
+}
+
+bool Phylogeny::exportBinary(const std::string& filename) const {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open()) return false;
+
+    out.write("PHYL", 4);
+    writeLittleEndian<uint32_t>(out, BINARY_VERSION);
+    writeLittleEndian<uint64_t>(out, getNodeCount());
+    for (const Node& node : this->nodes) {
+        if (node.pruned) continue;
+        writeLittleEndian<uint64_t>(out, node.id);
+        writeLittleEndian<uint64_t>(out, node.parent_id);
+        writeLittleEndian<int64_t>(out, node.birth_step);
+        writeLittleEndian<int64_t>(out, node.death_step);
+        writeLittleEndian<uint32_t>(out, node.mutations);
+    }
+    return out.good();
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Records who descended from whom. Every bot gets a lineage id when it is added to the world;
+// the store keeps one compact node per id with its parent, birth and death step and the
+// number of mutations it was born with.
+//
+// Nodes are appended in id order, so lookups are a binary search and no pointers are needed.
+// A node is pruned as soon as it is dead and none of its descendants is alive: each node counts
+// its retained children, and a death walks up the ancestry releasing nodes until it reaches one
+// that is still needed. Pruned nodes are dropped in bulk once they make up half of the store.
+class Phylogeny {
+public:
+    struct Node {
+        uint64_t id;
+        uint64_t parent_id;       // 0 for founders (and bots whose parent is unknown)
+        long long birth_step;
+        long long death_step;     // -1 while alive
+        uint32_t mutations;       // Mutations relative to the parent's genome
+        uint32_t retained_children;
+        bool pruned;
+    };
+
+    uint64_t addBirth(uint64_t parent_id, long long step, int mutations); // Returns the new id
+    // A birth under a known id, when a saved world is restored: ids must come in ascending
+    // order and not below getNextId(). Ancestors that were not saved are unknown (parent 0).
+    void restoreBirth(uint64_t id, uint64_t parent_id, long long step, int mutations);
+    uint64_t getNextId() const { return this->next_id; }
+    void setNextId(uint64_t id) { this->next_id = std::max(this->next_id, id); } // Never goes back
+    void recordDeath(uint64_t id, long long step); // Ignored for unknown or already dead ids
+    void clear();
+    const Node* find(uint64_t id) const; // nullptr if unknown or pruned
+    size_t getNodeCount() const { return this->nodes.size() - this->pruned_count; }
+
+    // Export the retained tree. Newick uses the ids as labels and the steps between a node's
+    // birth and its parent's birth as branch lengths; founders hang off one unnamed root.
+    // The binary format is "PHYL", a uint32 version, a uint64 node count, then per node
+    // id, parent id, birth step, death step (int64) and mutations (uint32), little-endian.
+    bool exportNewick(const std::string& filename) const;
+    bool exportBinary(const std::string& filename) const;
+private:
+    Node* _find(uint64_t id);
+    void _compact();
+
+    std::vector<Node> nodes; // Sorted by id
+    uint64_t next_id = 1;
+    size_t pruned_count = 0;
+};
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+
+// A small random generator owned by a world (xoshiro128**, the generator raylib uses for
+// GetRandomValue). Every world draws from its own instance, so worlds can be processed on
+// different threads at once and a seed alone reproduces a run.
+class Random {
+public:
+    Random() { seed(0); }
+    explicit Random(uint64_t seed_value) { seed(seed_value); }
+
+    void seed(uint64_t seed_value) {
+        // Expand the seed with splitmix64, which never yields an all-zero state.
+        for (uint32_t& word : this->state) {
+            seed_value += 0x9e3779b97f4a7c15ULL;
+            uint64_t z = seed_value;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            word = (uint32_t)(z ^ (z >> 31));
+        }
+    }
+
+    // The whole state, for saving a world mid-run and going on with the same sequence.
+    void getState(uint32_t out[4]) const {
+        for (int i = 0; i < 4; i++) out[i] = this->state[i];
+    }
+    bool setState(const uint32_t in[4]) { // False (and unchanged) for the all-zero state, which never moves
+        if ((in[0] | in[1] | in[2] | in[3]) == 0) return false;
+        for (int i = 0; i < 4; i++) this->state[i] = in[i];
+        return true;
+    }
+
+    uint32_t nextUInt() {
+        const uint32_t result = rotl(this->state[1] * 5, 7) * 9;
+        const uint32_t t = this->state[1] << 9;
+        this->state[2] ^= this->state[0];
+        this->state[3] ^= this->state[1];
+        this->state[1] ^= this->state[2];
+        this->state[0] ^= this->state[3];
+        this->state[2] ^= t;
+        this->state[3] = rotl(this->state[3], 11);
+        return result;
+    }
+
+    // A value in [min, max], both inclusive, like GetRandomValue().
+    int next(int min, int max) {
+        if (min > max) {
+            int tmp = max;
+            max = min;
+            min = tmp;
+        }
+        uint64_t range = (uint64_t)((int64_t)max - (int64_t)min) + 1;
+        return (int)((int64_t)min + (int64_t)(nextUInt() % range));
+    }
+
+    // A value in [0, 1).
+    float nextFloat() { return (nextUInt() >> 8) * (1.0f / 16777216.0f); }
+
+private:
+    static uint32_t rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+    uint32_t state[4];
+};
@@ -0,0 +1,139 @@
+#include "renderer.h"
+#include <algorithm>
+#include <cmath>
+
+// Zoom (pixels per cell) below which the grid lines are hidden.
+static const float GRID_MIN_ZOOM = 6.0f;
+
+WorldRenderer::WorldRenderer() {}
+
+WorldRenderer::~WorldRenderer() {
+    unload();
+}
+
+void WorldRenderer::_createResources(int width, int height) {
+    unload();
+    this->width = width;
+    this->height = height;
+
+    // One texel per cell. Point filtering (raylib's default) keeps the cells crisp when scaled up.
+    Image image = GenImageColor(width, height, BG_COLOR);
+    cell_texture = LoadTextureFromImage(image);
+    UnloadImage(image);
+}
+
+void WorldRenderer::unload() {
+    if (cell_texture.id != 0) UnloadTexture(cell_texture);
+    if (lod_texture.id != 0) UnloadTexture(lod_texture);
+    cell_texture = {};
+    lod_texture = {};
+    lod_block = 1;
+    uploaded_generation = -1;
+}
+
+void WorldRenderer::update(const RenderSnapshot& snapshot, const Viewport& viewport) {
+    if (snapshot.pixels.empty()) return; // Nothing published yet
+    if (snapshot.width != width || snapshot.height != height || cell_texture.id == 0) {
+        _createResources(snapshot.width, snapshot.height);
+    }
+
+    // Smallest power of two block size that gives at least one pixel per LOD texel.
+    int block = 1;
+    while (block < 64 && viewport.getZoom() * block < 1.0f) block *= 2;
+
+    if (snapshot.generation == uploaded_generation && block == lod_block) return; // Unchanged
+    uploaded_generation = snapshot.generation;
+
+    if (block > 1) {
+        _updateLod(snapshot, block);
+    } else {
+        lod_block = 1;
+        UpdateTexture(cell_texture, snapshot.pixels.data());
+    }
+    outlined_cells = snapshot.outlined_cells;
+}
+
+// Averages every block x block square of cells into one texel. Occupied cells are brighter
+// than the background, so the tiles show both the dominant color and the density of a block.
+void WorldRenderer::_updateLod(const RenderSnapshot& snapshot, int block) {
+    int lod_width = (width + block - 1) / block;
+    int lod_height = (height + block - 1) / block;
+    if (block != lod_block || lod_texture.id == 0) {
+        if (lod_texture.id != 0) UnloadTexture(lod_texture);
+        Image image = GenImageColor(lod_width, lod_height, BG_COLOR);
+        lod_texture = LoadTextureFromImage(image);
+        UnloadImage(image);
+        lod_block = block;
+    }
+
+    lod_pixels.resize(lod_width * lod_height);
+    for (int by = 0; by < lod_height; by++) {
+        int y_end = std::min(height, (by + 1) * block);
+        for (int bx = 0; bx < lod_width; bx++) {
+            int x_end = std::min(width, (bx + 1) * block);
+            unsigned int r = 0, g = 0, b = 0, count = 0;
+            for (int y = by * block; y < y_end; y++) {
+                const Color* row = &snapshot.pixels[y * width];
+                for (int x = bx * block; x < x_end; x++) {
+                    r += row[x].r;
+                    g += row[x].g;
+                    b += row[x].b;
+                }
+                count += x_end - bx * block;
+            }
+            lod_pixels[by * lod_width + bx] = { (unsigned char)(r / count), (unsigned char)(g / count), (unsigned char)(b / count), 255 };
+        }
+    }
+    UpdateTexture(lod_texture, lod_pixels.data());
+}
+
+// One line per visible column and row, a few hundred at most (they share raylib's batch).
+// The lines scale with the zoom (GRID_THICKNESS at CELL_SIZE pixels per cell); thinner than a
+// pixel, they fade instead, so they do not flicker while zooming.
+void WorldRenderer::_drawGrid(const Viewport& viewport, Rectangle visible) const {
+    float thickness = GRID_THICKNESS * viewport.getZoom() / CELL_SIZE;
+    Color color = GRID_COLOR;
+    if (thickness < 1.0f) {
+        color = Fade(GRID_COLOR, thickness);
+        thickness = 1.0f;
+    }
+    float x_end = visible.x + visible.width;
+    float y_end = visible.y + visible.height;
+    for (float x = visible.x; x < x_end; x++) {
+        DrawLineEx(viewport.cellToScreen({x, visible.y}), viewport.cellToScreen({x, y_end}), thickness, color);
+    }
+    for (float y = visible.y; y < y_end; y++) {
+        DrawLineEx(viewport.cellToScreen({visible.x, y}), viewport.cellToScreen({x_end, y}), thickness, color);
+    }
+}
+
+void WorldRenderer::draw(const Viewport& viewport) const {
+    if (cell_texture.id == 0) return;
+
+    Rectangle visible = viewport.getVisibleCells();
+    if (visible.width <= 0 || visible.height <= 0) return;
+    Rectangle screen = viewport.getScreenRect();
+    Rectangle dest = viewport.cellRectToScreen(visible);
+
+    BeginScissorMode((int)screen.x, (int)screen.y, (int)screen.width, (int)screen.height);
+
+    if (lod_block > 1) {
+        // The LOD texture covers whole blocks, so the source rect is simply scaled down.
+        float scale = 1.0f / lod_block;
+        DrawTexturePro(lod_texture,
+                       {visible.x * scale, visible.y * scale, visible.width * scale, visible.height * scale},
+                       dest, {0, 0}, 0.0f, WHITE);
+    } else {
+        DrawTexturePro(cell_texture, visible, dest, {0, 0}, 0.0f, WHITE);
+    }
+
+    if (viewport.getZoom() >= GRID_MIN_ZOOM) _drawGrid(viewport, visible);
+
+    float outline = std::clamp(viewport.getZoom() / 8.0f, 1.0f, 2.0f);
+    for (const Vector2& pos : outlined_cells) {
+        if (pos.x < visible.x || pos.y < visible.y || pos.x >= visible.x + visible.width || pos.y >= visible.y + visible.height) continue;
+        DrawRectangleLinesEx(viewport.cellRectToScreen({pos.x, pos.y, 1, 1}), outline, WHITE);
+    }
+
+    EndScissorMode();
+}
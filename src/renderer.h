@@ -0,0 +1,41 @@
+#pragma once
+#include "raylib.h"
+#include "simulation.h"
+#include "viewport.h"
+#include "config.h"
+#include <vector>
+
+// The WorldRenderer draws the simulation grid with a constant number of draw calls.
+// Every cell is one texel of a texture that is refreshed from a CPU pixel buffer with a
+// single UpdateTexture call per frame (the pixels are composed by the simulation thread)
+// and drawn scaled by the viewport zoom.
+// - Only the part of the world inside the viewport is drawn (culling via the source rect).
+// - Grid lines are drawn for the visible cells only, and only when zoomed in far enough to
+//   see them, so their cost depends on the window size, not the world size.
+// - When zoomed out below one pixel per cell, blocks of cells are averaged into a smaller
+//   level-of-detail texture instead, so the image stays stable instead of aliasing.
+// Note: GPU resources are created lazily, so the renderer must only be used after InitWindow().
+class WorldRenderer {
+public:
+    WorldRenderer();
+    ~WorldRenderer();
+    void update(const RenderSnapshot& snapshot, const Viewport& viewport);
+    void draw(const Viewport& viewport) const;
+    void unload(); // Releases the GPU resources; call before CloseWindow()
+
+private:
+    void _createResources(int width, int height);
+    void _updateLod(const RenderSnapshot& snapshot, int block);
+    void _drawGrid(const Viewport& viewport, Rectangle visible) const;
+
+    int width = 0;  // World size in cells (and texture size in texels)
+    int height = 0;
+    Texture2D cell_texture = {};
+    std::vector<Vector2> outlined_cells; // Cells that get a highlight border (relatives)
+    long long uploaded_generation = -1;
+
+    // Level of detail: one texel per lod_block x lod_block cells (1 = LOD disabled).
+    int lod_block = 1;
+    std::vector<Color> lod_pixels;
+    Texture2D lod_texture = {};
+};
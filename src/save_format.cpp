@@ -0,0 +1,298 @@
+#include "save_format.h"
+#include "compression.h"
+#include "config.h"
+#include "instructions.h"
+#include "genome_diff.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SAVE_FORMAT_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const char SAVE_MAGIC_WORLD[4] = {'E', 'V', 'O', 'W'};
+const char SAVE_MAGIC_BOT[4] = {'E', 'V', 'O', 'B'};
+const char SAVE_MAGIC_DELTA[4] = {'E', 'V', 'O', 'D'};
+const char SAVE_MAGIC_BANK[4] = {'E', 'V', 'O', 'G'};
+
+uint32_t crc32(const uint8_t* data, size_t size) {
+    // CRC-32 (the polynomial of zlib and PNG), slicing by 8: table k advances the CRC of a
+    // byte by k more zero bytes, so eight bytes are folded in with eight independent lookups.
+    static const struct Tables {
+        uint32_t entries[8][256];
+        Tables() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                entries[0][i] = c;
+            }
+            for (int k = 1; k < 8; k++) {
+                for (uint32_t i = 0; i < 256; i++) {
+                    entries[k][i] = entries[0][entries[k - 1][i] & 0xFF] ^ (entries[k - 1][i] >> 8);
+                }
+            }
+        }
+    } tables;
+    const auto& t = tables.entries;
+    uint32_t crc = 0xFFFFFFFFu;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        const uint8_t* p = data + i;
+        uint32_t low = crc ^ ((uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24);
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+              t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+    }
+    for (; i < size; i++) crc = t[0][(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void ByteWriter::putU16(uint16_t value) {
+    putU8((uint8_t)value);
+    putU8((uint8_t)(value >> 8));
+}
+
+void ByteWriter::putU32(uint32_t value) {
+    for (int i = 0; i < 4; i++) putU8((uint8_t)(value >> (8 * i)));
+}
+
+void ByteWriter::putVarint(uint64_t value) {
+    while (value >= 0x80) {
+        putU8((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    putU8((uint8_t)value);
+}
+
+void ByteWriter::putBytes(const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    this->bytes.insert(this->bytes.end(), bytes, bytes + size);
+}
+
+uint8_t ByteReader::getU8() {
+    if (this->data == this->end) {
+        this->has_failed = true;
+        return 0;
+    }
+    return *this->data++;
+}
+
+uint16_t ByteReader::getU16() {
+    uint16_t low = getU8();
+    return (uint16_t)(low | (getU8() << 8));
+}
+
+uint32_t ByteReader::getU32() {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) value |= (uint32_t)getU8() << (8 * i);
+    return value;
+}
+
+uint64_t ByteReader::getVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t byte = getU8();
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    this->has_failed = true; // More than 10 bytes
+    return 0;
+}
+
+const uint8_t* ByteReader::getBytes(size_t size) {
+    if (size > remaining()) {
+        this->has_failed = true;
+        this->data = this->end;
+        return nullptr;
+    }
+    const uint8_t* bytes = this->data;
+    this->data += size;
+    return bytes;
+}
+
+void beginSaveFile(ByteWriter& out, const char magic[4]) {
+    out.putBytes(magic, 4);
+    out.putU16(SAVE_FORMAT_VERSION);
+    out.putU16(0);
+    out.putU32(0); // Size and checksum, see finishSaveFile()
+    out.putU32(0);
+}
+
+void finishSaveFile(ByteWriter& out) {
+    std::vector<uint8_t>& bytes = out.getBytes();
+    uint32_t size = (uint32_t)(bytes.size() - SAVE_HEADER_SIZE);
+    uint32_t crc = crc32(bytes.data() + SAVE_HEADER_SIZE, size);
+    for (int i = 0; i < 4; i++) {
+        bytes[8 + i] = (uint8_t)(size >> (8 * i));
+        bytes[12 + i] = (uint8_t)(crc >> (8 * i));
+    }
+}
+
+void compressSaveFile(ByteWriter& out, int level, int threads) {
+    if (level <= 0) return;
+    level = std::min(level, MAX_COMPRESSION_LEVEL);
+    std::vector<uint8_t>& bytes = out.getBytes();
+    std::vector<uint8_t> blocks;
+    compressBlocks(bytes.data() + SAVE_HEADER_SIZE, bytes.size() - SAVE_HEADER_SIZE, level, threads, blocks);
+    if (blocks.size() >= bytes.size() - SAVE_HEADER_SIZE) return;
+
+    bytes.resize(SAVE_HEADER_SIZE);
+    bytes.insert(bytes.end(), blocks.begin(), blocks.end());
+    uint16_t flags = (uint16_t)(SAVE_CODEC_LZ | level << 4);
+    uint32_t size = (uint32_t)blocks.size();
+    bytes[6] = (uint8_t)flags;
+    bytes[7] = (uint8_t)(flags >> 8);
+    for (int i = 0; i < 4; i++) bytes[8 + i] = (uint8_t)(size >> (8 * i)); // The checksum stays
+}
+
+ByteReader openSaveFile(const uint8_t* file, size_t size, const char magic[4], int& version, bool& is_legacy,
+                        std::vector<uint8_t>& buffer) {
+    ByteReader failed(nullptr, 0);
+    failed.fail();
+    is_legacy = size < 4 || (memcmp(file, SAVE_MAGIC_WORLD, 4) != 0 && memcmp(file, SAVE_MAGIC_BOT, 4) != 0 &&
+                             memcmp(file, SAVE_MAGIC_DELTA, 4) != 0 && memcmp(file, SAVE_MAGIC_BANK, 4) != 0);
+    if (is_legacy || memcmp(file, magic, 4) != 0) return failed;
+
+    ByteReader header(file + 4, size - 4);
+    version = header.getU16();
+    uint16_t flags = header.getU16();
+    uint32_t payload_size = header.getU32();
+    uint32_t crc = header.getU32();
+    if (header.failed() || version < 1 || version > SAVE_FORMAT_VERSION || payload_size != header.remaining()) return failed;
+    switch (flags & 0xF) {
+    case SAVE_CODEC_NONE:
+        if (crc32(header.position(), payload_size) != crc) return failed;
+        return ByteReader(header.position(), payload_size);
+    case SAVE_CODEC_LZ:
+        if (!decompressBlocks(header.position(), payload_size, 0, buffer) || crc32(buffer.data(), buffer.size()) != crc) {
+            return failed;
+        }
+        return ByteReader(buffer.data(), buffer.size());
+    default:
+        return failed; // Written by a newer version
+    }
+}
+
+void writeGenome(ByteWriter& out, const std::vector<uint8_t>& genome) {
+    out.putVarint(genome.size());
+    out.putBytes(genome.data(), genome.size());
+}
+
+const uint8_t* readGenomeInPlace(ByteReader& in, size_t& size) {
+    uint64_t length = in.getVarint();
+    if (in.failed() || length < MIN_GENOME_SIZE || length > MAX_GENOME_SIZE) {
+        in.fail();
+        return nullptr;
+    }
+    const uint8_t* genes = in.getBytes((size_t)length);
+    if (!genes) return nullptr;
+    uint8_t combined = 0;
+    for (size_t i = 0; i < length; i++) combined |= genes[i];
+    static_assert(MAX_INSTRUCTION_VALUE == 127, "Only the high bit marks an invalid gene");
+    if (combined > MAX_INSTRUCTION_VALUE) {
+        in.fail();
+        return nullptr;
+    }
+    size = (size_t)length;
+    return genes;
+}
+
+bool readGenome(ByteReader& in, std::vector<uint8_t>& genome) {
+    size_t size = 0;
+    const uint8_t* genes = readGenomeInPlace(in, size);
+    if (!genes) return false;
+    genome.assign(genes, genes + size);
+    return true;
+}
+
+uint32_t GenomeTable::intern(const uint8_t* genes, size_t size) {
+    std::vector<uint32_t>& candidates = this->ids_by_hash[hashGenome(genes, size)];
+    auto found = std::find_if(candidates.begin(), candidates.end(), [&](uint32_t id) {
+        return getSize(id) == size && memcmp(getGenes(id), genes, size) == 0;
+    });
+    if (found != candidates.end()) return *found;
+    uint32_t id = (uint32_t)this->ends.size();
+    this->genes.insert(this->genes.end(), genes, genes + size);
+    this->ends.push_back(this->genes.size());
+    candidates.push_back(id);
+    return id;
+}
+
+void GenomeTable::clear() {
+    this->genes.clear();
+    this->ends.clear();
+    this->ids_by_hash.clear();
+}
+
+MappedFile::MappedFile(const std::string& filename) {
+#if SAVE_FORMAT_MMAP
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat info;
+    bool is_file = fstat(fd, &info) == 0 && S_ISREG(info.st_mode);
+    void* mapping = MAP_FAILED;
+    if (is_file && info.st_size > 0) {
+        mapping = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd); // The mapping stays valid
+    if (!is_file) return;
+    if (info.st_size == 0) {
+        this->is_open = true;
+        return;
+    }
+    if (mapping != MAP_FAILED) {
+        madvise(mapping, (size_t)info.st_size, MADV_SEQUENTIAL); // Loaders read front to back, once
+        this->bytes = (const uint8_t*)mapping;
+        this->length = (size_t)info.st_size;
+        this->is_mapped = true;
+        this->is_open = true;
+        return;
+    }
+#endif
+    // Not mappable here: read the whole file instead.
+    this->is_open = readFile(filename, this->buffer);
+    this->bytes = this->buffer.data();
+    this->length = this->buffer.size();
+}
+
+MappedFile::~MappedFile() {
+#if SAVE_FORMAT_MMAP
+    if (this->is_mapped) munmap((void*)this->bytes, this->length);
+#endif
+}
+
+bool readFile(const std::string& filename, std::vector<uint8_t>& out) {
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (!file) return false;
+    bool ok = fseek(file, 0, SEEK_END) == 0;
+    long size = ok ? ftell(file) : -1;
+    ok = size >= 0 && fseek(file, 0, SEEK_SET) == 0;
+    if (ok) {
+        out.resize((size_t)size);
+        ok = fread(out.data(), 1, out.size(), file) == out.size();
+    }
+    fclose(file);
+    return ok;
+}
+
+bool writeFile(const std::string& filename, const std::vector<uint8_t>& bytes) {
+    FILE* file = fopen(filename.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    ok = fclose(file) == 0 && ok;
+    return ok;
+}
+
+bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+    if (FILE* source = fopen(from.c_str(), "rb")) {
+        fclose(source);
+        std::remove(to.c_str());
+    }
+#endif
+    return std::rename(from.c_str(), to.c_str()) == 0;
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Building blocks of the save files (worlds and single bots).
+//
+// A save file is a 16-byte header followed by the payload:
+//   magic      4 bytes, "EVOW" for a world, "EVOB" for a bot, "EVOD" for a world delta
+//              (an incremental checkpoint, see checkpoint_chain.h), "EVOG" for a genome bank
+//              (see genome_bank.h)
+//   version    uint16, SAVE_FORMAT_VERSION when written
+//   flags      uint16, bits 0-3 the codec (SaveCodec), bits 4-7 the level it was written
+//              with; the other bits are reserved (0)
+//   size       uint32, stored payload bytes
+//   crc        uint32, CRC-32 of the payload (before compression)
+// All fixed-size integers are little-endian. Inside the payload, counts and most fields are
+// LEB128 varints (signed ones zigzag-encoded) and genes are single bytes, so a typical bot
+// takes 10-15 bytes plus its genome, and genomes shared by several bots are stored once.
+//
+// A compressed payload is stored as the blocks described in compression.h. The checksum is
+// always that of the plain payload, so it identifies the contents whatever the codec.
+//
+// Files written before the header existed have no magic; the loaders fall back to their
+// raw layout (see World::loadWorld and Bot::loadFromFile).
+
+// Version 2 added the random generator's state and the next lineage id to world saves and
+// deltas, and the memory stack, idle steps and lineage to bot records (see Bot::serialize()).
+// Version 1 files still load; their worlds go on with a reseeded generator.
+const uint16_t SAVE_FORMAT_VERSION = 2;
+enum SaveCodec {
+    SAVE_CODEC_NONE = 0,
+    SAVE_CODEC_LZ = 1 // See compression.h
+};
+const size_t SAVE_HEADER_SIZE = 16;
+extern const char SAVE_MAGIC_WORLD[4];
+extern const char SAVE_MAGIC_BOT[4];
+extern const char SAVE_MAGIC_DELTA[4];
+extern const char SAVE_MAGIC_BANK[4];
+
+uint32_t crc32(const uint8_t* data, size_t size);
+
+class ByteWriter {
+public:
+    void putU8(uint8_t value) { this->bytes.push_back(value); }
+    void putU16(uint16_t value);
+    void putU32(uint32_t value);
+    void putVarint(uint64_t value);
+    void putSignedVarint(int64_t value) { putVarint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63)); }
+    void putBytes(const void* data, size_t size);
+    size_t size() const { return this->bytes.size(); }
+    std::vector<uint8_t>& getBytes() { return this->bytes; }
+    const std::vector<uint8_t>& getBytes() const { return this->bytes; }
+private:
+    std::vector<uint8_t> bytes;
+};
+
+// Reads from a buffer it does not own. Reading past the end (or a malformed varint) yields
+// zeros and sets the failed flag, so a caller can decode a whole record and check once.
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data, size_t size) : data(data), end(data + size) {}
+    uint8_t getU8();
+    uint16_t getU16();
+    uint32_t getU32();
+    uint64_t getVarint();
+    int64_t getSignedVarint() { uint64_t v = getVarint(); return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+    // Returns a pointer to the next size bytes and skips them, or nullptr (and fails).
+    const uint8_t* getBytes(size_t size);
+    bool failed() const { return this->has_failed; }
+    void fail() { this->has_failed = true; }
+    size_t remaining() const { return (size_t)(this->end - this->data); }
+    const uint8_t* position() const { return this->data; }
+private:
+    const uint8_t* data;
+    const uint8_t* end;
+    bool has_failed = false;
+};
+
+// Starts a save file in out: writes the header, to be completed by finishSaveFile().
+void beginSaveFile(ByteWriter& out, const char magic[4]);
+// Fills in the payload size and checksum.
+void finishSaveFile(ByteWriter& out);
+// Compresses the payload of a finished save file in out (level 1 to MAX_COMPRESSION_LEVEL,
+// 0 leaves it as it is), on up to 'threads' threads (0 = all cores). Payloads that do not
+// get smaller stay uncompressed.
+void compressSaveFile(ByteWriter& out, int level, int threads = 0);
+// Checks the magic, version and checksum of a save file. On success, returns a reader over
+// the payload and sets version; a compressed payload is decompressed into buffer first.
+// Returns a failed reader if the file is not of this kind or is damaged; is_legacy tells
+// whether it has no header at all.
+ByteReader openSaveFile(const uint8_t* file, size_t size, const char magic[4], int& version, bool& is_legacy,
+                        std::vector<uint8_t>& buffer);
+
+// A genome as its length and one byte per gene. Reading fails on a length outside
+// MIN_GENOME_SIZE..MAX_GENOME_SIZE or a gene above MAX_INSTRUCTION_VALUE. readGenomeInPlace
+// returns the genes where they are in the reader's buffer (nullptr on failure).
+void writeGenome(ByteWriter& out, const std::vector<uint8_t>& genome);
+const uint8_t* readGenomeInPlace(ByteReader& in, size_t& size);
+bool readGenome(ByteReader& in, std::vector<uint8_t>& genome);
+
+// Genomes by intern id: equal genomes get the same id, in order of first appearance. The
+// table keeps its own copy of the genes.
+class GenomeTable {
+public:
+    uint32_t intern(const uint8_t* genes, size_t size);
+    size_t size() const { return this->ends.size(); }
+    const uint8_t* getGenes(uint32_t id) const { return this->genes.data() + (id > 0 ? this->ends[id - 1] : 0); }
+    size_t getSize(uint32_t id) const { return this->ends[id] - (id > 0 ? this->ends[id - 1] : 0); }
+    void clear();
+private:
+    std::vector<uint8_t> genes; // All genomes back to back
+    std::vector<size_t> ends;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> ids_by_hash;
+};
+
+// A whole file, read-only. It is memory-mapped where the platform supports it (POSIX), so
+// loading touches the pages once instead of copying them into a buffer first; elsewhere it
+// is read into memory.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    bool isOpen() const { return this->is_open; }
+    const uint8_t* data() const { return this->bytes; }
+    size_t size() const { return this->length; }
+private:
+    bool is_open = false;
+    bool is_mapped = false;
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+    std::vector<uint8_t> buffer; // When the file is not mapped
+};
+
+bool readFile(const std::string& filename, std::vector<uint8_t>& out);
+bool writeFile(const std::string& filename, const std::vector<uint8_t>& bytes);
+// Replaces 'to' with 'from'. POSIX rename() does this atomically; on Windows the target has
+// to be removed first (but only if there is something to replace it with).
+bool replaceFile(const std::string& from, const std::string& to);
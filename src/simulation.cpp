@@ -0,0 +1,359 @@
+#include "simulation.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+
+Simulation::Simulation(World& world) : world(world) {}
+
+Simulation::~Simulation() {
+    stop();
+}
+
+void Simulation::start() {
+    if (running) return;
+    running = true;
+    thread = std::thread(&Simulation::_run, this);
+}
+
+void Simulation::stop() {
+    if (!running) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wake_sim.notify_all();
+    thread.join();
+}
+
+const RenderSnapshot& Simulation::acquireSnapshot() {
+    if (middle.load(std::memory_order_relaxed) & FRESH_SNAPSHOT) {
+        front = middle.exchange(front, std::memory_order_acq_rel) & ~FRESH_SNAPSHOT;
+    }
+    return snapshots[front];
+}
+
+void Simulation::setPaused(bool paused) {
+    std::unique_lock<std::mutex> lock(mutex);
+    bool was_paused = this->paused;
+    this->paused = paused;
+    if (paused && !was_paused) {
+        // Wait for the current step to finish so the caller owns the shared resources. Only
+        // when pausing: the commands that run while paused don't touch them, and waiting
+        // for those would hold up the caller (this is called every frame).
+        sim_idle.wait(lock, [this] { return idle || !running; });
+    } else if (!paused) {
+        wake_sim.notify_all();
+    }
+}
+
+bool Simulation::isPaused() const {
+    return paused;
+}
+
+void Simulation::setTargetRate(int steps_per_second) {
+    target_rate = std::max(0, steps_per_second);
+}
+
+int Simulation::getTargetRate() const {
+    return target_rate;
+}
+
+void Simulation::setViewMode(int view_mode) {
+    if (requested_view_mode.exchange(view_mode) == view_mode) return;
+    _post([this, view_mode] { this->view_mode = view_mode; });
+}
+
+void Simulation::selectAt(Vector2 cell) {
+    _post([this, cell] {
+        Bot* bot = world.getBotAt(cell);
+        if (bot != world.getSelectedBot()) {
+            world.clearRelatives();
+        }
+        world.selectBot(bot);
+    });
+}
+
+void Simulation::deselect() {
+    _post([this] {
+        world.selectBot(nullptr);
+        world.clearRelatives();
+    });
+}
+
+void Simulation::findRelatives() {
+    _post([this] { world.highlightRelatives(world.getSelectedBot()); });
+}
+
+void Simulation::hideRelatives() {
+    _post([this] { world.clearRelatives(); });
+}
+
+void Simulation::placeBot(const Bot& bot, Vector2 cell) {
+    _post([this, bot, cell] {
+        if (world.getBotAt(cell) == nullptr) {
+            Bot* new_bot = new Bot(bot);
+            new_bot->setParent(bot.getLineageId());
+            new_bot->setPosition(cell);
+            world.addBot(new_bot);
+        }
+    });
+}
+
+void Simulation::newWorld(unsigned int seed, int initial_bot_count) {
+    _post([this, seed, initial_bot_count] { world.newWorld(seed, initial_bot_count); });
+}
+
+void Simulation::spawnBots(int count) {
+    _post([this, count] { world.spawnInitialBots(count); });
+}
+
+void Simulation::spawnCopies(std::vector<Bot> prototypes, int count) {
+    _post([this, prototypes = std::move(prototypes), count] { world.spawnCopies(prototypes, count); });
+}
+
+void Simulation::bankLivingBots(GenomeBank bank) {
+    _post([this, bank = std::move(bank)]() mutable {
+        bank.addWorld(world, "seed " + std::to_string(world.getSeed()));
+        std::string status = "Banked the living bots: " + std::to_string(bank.size()) + " genomes.";
+        _returnBank(std::move(bank), std::move(status));
+    });
+}
+
+void Simulation::loadBank(GenomeBank bank, const std::string& filename) {
+    _post([this, bank = std::move(bank), filename]() mutable {
+        int before = bank.size();
+        std::string status = bank.load(filename) ? "Loaded " + std::to_string(bank.size() - before) + " new genomes."
+                                                 : "Could not load " + filename + ".";
+        _returnBank(std::move(bank), std::move(status));
+    });
+}
+
+void Simulation::importBotFiles(GenomeBank bank, const std::string& path) {
+    _post([this, bank = std::move(bank), path]() mutable {
+        int imported = bank.importBotFiles({path});
+        _returnBank(std::move(bank), "Imported " + std::to_string(imported) + " bot files.");
+    });
+}
+
+void Simulation::saveBank(GenomeBank bank, const std::string& filename) {
+    _post([this, bank = std::move(bank), filename]() mutable {
+        std::string status = bank.save(filename) ? "Saved." : "Could not write " + filename + ".";
+        _returnBank(std::move(bank), std::move(status));
+    });
+}
+
+void Simulation::_returnBank(GenomeBank bank, std::string status) {
+    std::lock_guard<std::mutex> lock(mutex);
+    returned_bank = std::move(bank);
+    bank_status = std::move(status);
+}
+
+bool Simulation::takeBank(GenomeBank& bank, std::string& status) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!returned_bank) return false;
+    bank = std::move(*returned_bank);
+    returned_bank.reset();
+    status = std::move(bank_status);
+    return true;
+}
+
+void Simulation::saveWorld(const std::string& filename) {
+    _post([this, filename] {
+        WorldImage image;
+        world.captureImage(image);
+        checkpointer.submit(std::move(image), filename);
+    });
+}
+
+void Simulation::setAutosave(long long interval, int keep, const std::string& filename, int keyframe_interval) {
+    _post([this, interval, keep, filename, keyframe_interval] {
+        autosave_interval = std::max(0LL, interval);
+        autosave_keep = std::max(1, keep);
+        autosave_filename = filename;
+        autosave_keyframe_interval = std::max(1, keyframe_interval);
+    });
+}
+
+void Simulation::loadWorld(const std::string& filename) {
+    _post([this, filename] {
+        // The file (or a checkpoint of its chain) may still be queued or half written.
+        checkpointer.wait();
+        loadCheckpoint(world, filename);
+    });
+}
+
+void Simulation::exportPhylogeny(const std::string& filename, bool newick) {
+    _post([this, filename, newick] {
+        if (newick) {
+            world.getPhylogeny().exportNewick(filename);
+        } else {
+            world.getPhylogeny().exportBinary(filename);
+        }
+    });
+}
+
+void Simulation::startRecording(const std::string& filename, int interval) {
+    _post([this, filename, interval] {
+        recording_interval = std::max(1, interval);
+        recording = recorder.start(filename, world.getWidth(), world.getHeight(), TRAJECTORY_KEYFRAME_INTERVAL);
+        world.setTrackingCells(recording && recording_interval < TRAJECTORY_TRACKING_INTERVAL);
+        if (recording) recorder.record(world); // The current state is the first frame
+    });
+}
+
+void Simulation::stopRecording() {
+    _post([this] {
+        recorder.stop();
+        recording = false;
+        world.setTrackingCells(false);
+    });
+}
+
+void Simulation::exportCensus(const std::string& filename) {
+    _post([this, filename] { world.getCensus().exportCsv(filename); });
+}
+
+void Simulation::_post(Command command) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        commands.push_back(std::move(command));
+    }
+    wake_sim.notify_all();
+}
+
+// Runs all queued commands. Returns true if any were executed.
+bool Simulation::_executeCommands() {
+    std::vector<Command> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.swap(commands);
+    }
+    for (Command& command : pending) {
+        command();
+    }
+    return !pending.empty();
+}
+
+void Simulation::_run() {
+    using Clock = std::chrono::steady_clock;
+    const Clock::duration frame = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / TARGET_FPS));
+    const Clock::duration step_budget = std::chrono::duration_cast<Clock::duration>(frame * SIM_FRAME_BUDGET);
+
+    Clock::time_point frame_start = Clock::now();
+    Clock::time_point measure_start = frame_start;
+    long long measured_steps = 0;
+    double step_credit = 0.0; // Fractional steps owed to the target rate
+
+    _publish();
+    while (running) {
+        if (_executeCommands()) {
+            _publish();
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (paused) {
+                idle = true;
+                sim_idle.notify_all();
+                wake_sim.wait(lock, [this] { return !paused || !commands.empty() || !running; });
+                idle = false;
+                frame_start = measure_start = Clock::now();
+                measured_steps = 0;
+                step_credit = 0.0;
+                continue;
+            }
+        }
+
+        // Wait for the next frame, but wake up early for commands.
+        if (Clock::now() < frame_start) {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake_sim.wait_until(lock, frame_start, [this] { return !commands.empty() || !running; });
+            continue;
+        }
+
+        int max_steps = INT_MAX;
+        int rate = target_rate;
+        if (rate > 0) {
+            step_credit = std::min(step_credit + (double)rate / TARGET_FPS, (double)rate); // Cap the backlog at 1s
+            max_steps = (int)step_credit;
+        }
+        int steps = _stepFrame(frame_start + step_budget, max_steps);
+        if (rate > 0) step_credit -= steps;
+        if (steps > 0) {
+            measured_steps += steps;
+            _publish();
+        }
+
+        Clock::time_point now = Clock::now();
+        if (now - measure_start >= std::chrono::milliseconds(500)) {
+            steps_per_second = (float)(measured_steps / std::chrono::duration<double>(now - measure_start).count());
+            measure_start = now;
+            measured_steps = 0;
+        }
+
+        frame_start += frame;
+        if (frame_start < now - frame) frame_start = now; // Fell behind, don't try to catch up
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    idle = true;
+    sim_idle.notify_all();
+}
+
+// Runs up to max_steps steps, stopping early once budget_end has passed.
+// At least one step is taken when any are requested, so huge worlds still make progress.
+int Simulation::_stepFrame(std::chrono::steady_clock::time_point budget_end, int max_steps) {
+    int steps = 0;
+    while (steps < max_steps && (steps == 0 || std::chrono::steady_clock::now() < budget_end)) {
+        world.process();
+        steps++;
+        if (autosave_interval > 0 && world.getStepCount() % autosave_interval == 0) {
+            _autosave();
+        }
+        if (recording && world.getStepCount() % recording_interval == 0) {
+            recorder.record(world);
+        }
+    }
+    return steps;
+}
+
+void Simulation::_autosave() {
+    if (checkpointer.isBusy()) return; // Still writing the last one, the disk can't keep up
+    WorldImage image;
+    world.captureImage(image);
+    if (autosave_keyframe_interval > 1) {
+        checkpointer.submitIncremental(std::move(image), autosave_filename, autosave_keyframe_interval, autosave_keep);
+    } else {
+        checkpointer.submit(std::move(image), autosave_filename, autosave_keep);
+    }
+}
+
+// Fills the back buffer from the current world state and hands it over to the UI thread.
+void Simulation::_publish() {
+    RenderSnapshot& snapshot = snapshots[back];
+    snapshot.generation = ++generation;
+    snapshot.width = world.getWidth();
+    snapshot.height = world.getHeight();
+    snapshot.pixels.resize(snapshot.width * snapshot.height);
+    world.render(snapshot.pixels.data(), snapshot.outlined_cells, view_mode);
+
+    snapshot.step_count = world.getStepCount();
+    snapshot.steps_per_second = steps_per_second;
+    snapshot.bot_count = world.getBotsSize();
+    snapshot.genome_count = world.getGenomeCount();
+    snapshot.lineage_count = (int)world.getPhylogeny().getNodeCount();
+    snapshot.census = world.getCensus().getCurrent();
+    snapshot.census.step = world.getStepCount();
+    snapshot.census.genomes = world.getGenomeCount();
+    world.getCensus().copyRecent(snapshot.census_recent);
+    snapshot.census_history = world.getCensus().getHistory();
+    snapshot.seed = world.getSeed();
+    snapshot.showing_relatives = world.isShowingRelatives();
+    if (world.getSelectedBot() != nullptr) {
+        snapshot.selected_bot = *world.getSelectedBot();
+    } else {
+        snapshot.selected_bot.reset();
+    }
+
+    back = middle.exchange(back | FRESH_SNAPSHOT, std::memory_order_acq_rel) & ~FRESH_SNAPSHOT;
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include "world.h"
+#include "checkpointer.h"
+#include "genome_bank.h"
+#include "trajectory.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// An immutable image of the world, produced by the simulation thread for the UI thread.
+// Everything the UI needs to draw a frame and fill the inspector is copied in here, so the
+// UI never has to touch the live World (or a Bot pointer) while the simulation is running.
+struct RenderSnapshot {
+    int width = 0;
+    int height = 0;
+    std::vector<Color> pixels;           // One final color per cell, see World::render()
+    std::vector<Vector2> outlined_cells; // Positions of the highlighted relatives
+    long long generation = 0;            // Increases with every published snapshot
+    long long step_count = 0;
+    float steps_per_second = 0.0f;       // Measured simulation speed
+    int bot_count = 0;
+    int genome_count = 0;                // Distinct genomes among the living bots
+    int lineage_count = 0;               // Phylogeny nodes: living bots and their ancestors
+    CensusSample census;                 // Population aggregates after the last step
+    std::vector<CensusSample> census_recent;  // The last steps, oldest first
+    std::vector<CensusSample> census_history; // The whole run, downsampled
+    unsigned int seed = 0;
+    std::optional<Bot> selected_bot;     // A copy of the selected bot's full state
+    bool showing_relatives = false;
+};
+
+// The Simulation runs World::process() on its own thread, independent of the UI frame rate.
+// - Time is split into frames of 1/TARGET_FPS. In every frame the thread runs as many steps
+//   as the target rate asks for (all that fit in turbo mode), but never for longer than
+//   SIM_FRAME_BUDGET of the frame, so the UI thread keeps some CPU time even on one core.
+// - Only the state after the last step of a frame is published (render decimation), as a
+//   RenderSnapshot handed over through a lock-free triple buffer (double buffering plus a
+//   spare slot, so neither side ever waits for the other).
+// - The UI never mutates the world directly. Actions such as selection, bot placement or
+//   saving are queued as commands and executed on the simulation thread between steps.
+// - Saving only captures a WorldImage between steps; the Checkpointer encodes and writes it
+//   in the background. Autosaves work the same way every N steps.
+// - A trajectory recording captures the cells every N steps (for small N the world keeps them
+//   up to date as it goes); a TrajectoryRecorder compresses and writes them in the background.
+// - Bank commands take the UI's GenomeBank along and hand it back when done, so reading,
+//   writing and merging genome banks never holds up a frame.
+class Simulation {
+public:
+    explicit Simulation(World& world);
+    ~Simulation();
+    void start();
+    void stop();
+
+    // Returns the most recently published snapshot. The reference stays valid (and unchanged)
+    // until the next call, and must only be used from the UI thread.
+    const RenderSnapshot& acquireSnapshot();
+
+    // Pausing blocks until the simulation thread has finished its current step, so the
+    // caller may safely use shared resources (e.g. raylib's random generator) afterwards.
+    // Staying paused never blocks, even while commands run.
+    void setPaused(bool paused);
+    bool isPaused() const;
+    void setTargetRate(int steps_per_second); // 0 = turbo, as many steps as the frame budget allows
+    int getTargetRate() const;
+    void setViewMode(int view_mode);
+
+    // --- Commands (executed asynchronously on the simulation thread) ---
+    void selectAt(Vector2 cell);
+    void deselect();
+    void findRelatives();
+    void hideRelatives();
+    void placeBot(const Bot& bot, Vector2 cell);
+    void newWorld(unsigned int seed, int initial_bot_count);
+    void spawnBots(int count);
+    // Places copies of the prototypes (in turn) on random empty cells, see World::spawnCopies().
+    void spawnCopies(std::vector<Bot> prototypes, int count);
+    // Bank commands. The UI hands its bank over and gets it back through takeBank(), so it
+    // never waits on the disk, nor on merging thousands of genomes.
+    void bankLivingBots(GenomeBank bank);
+    void loadBank(GenomeBank bank, const std::string& filename); // Merges the file's genomes in
+    void importBotFiles(GenomeBank bank, const std::string& path); // See GenomeBank::importBotFiles()
+    void saveBank(GenomeBank bank, const std::string& filename);
+    // Moves the bank of the last bank command into bank and sets status to what it did; false
+    // while the command is still running.
+    bool takeBank(GenomeBank& bank, std::string& status);
+    void saveWorld(const std::string& filename);
+    // Saves every interval steps (0 turns it off), keeping the last keep saves (see
+    // Checkpointer::submit()). An autosave is skipped while the previous one is still written.
+    // With keyframe_interval > 1 the autosaves are incremental and keep counts whole chains
+    // (see Checkpointer::submitIncremental()).
+    void setAutosave(long long interval, int keep, const std::string& filename, int keyframe_interval = 1);
+    bool isSaving() const { return checkpointer.isBusy(); }
+    void setCompressionLevel(int level) { checkpointer.setCompressionLevel(level); } // Of world saves, 0 = off
+    int getCompressionLevel() const { return checkpointer.getCompressionLevel(); }
+    void loadWorld(const std::string& filename); // A world save or an incremental checkpoint
+    // Records the cells every 'interval' steps to a trajectory file (see trajectory.h).
+    void startRecording(const std::string& filename, int interval);
+    void stopRecording();
+    bool isRecording() const { return recording; }
+    long long getRecordedFrameCount() const { return recorder.getFrameCount(); }
+    long long getSkippedFrameCount() const { return recorder.getSkippedFrames(); } // The writer fell behind
+    bool hasRecordingFailed() const { return recorder.hasFailed(); }
+    void exportPhylogeny(const std::string& filename, bool newick);
+    void exportCensus(const std::string& filename);
+
+private:
+    using Command = std::function<void()>;
+    void _post(Command command);
+    void _run();
+    int _stepFrame(std::chrono::steady_clock::time_point budget_end, int max_steps);
+    bool _executeCommands();
+    void _publish();
+    void _autosave();
+    void _returnBank(GenomeBank bank, std::string status);
+
+    World& world;
+    std::thread thread;
+    std::atomic<bool> running{false};
+
+    // Shared state guarded by mutex.
+    std::mutex mutex;
+    std::condition_variable wake_sim;  // Signals new commands, unpausing or stopping
+    std::condition_variable sim_idle;  // Signals that the simulation thread parked itself
+    std::vector<Command> commands;
+    std::atomic<bool> paused{false};
+    bool idle = false;
+    std::optional<GenomeBank> returned_bank; // Waiting for takeBank()
+    std::string bank_status;
+
+    std::atomic<int> target_rate{0};
+    std::atomic<int> requested_view_mode{2};
+
+    // State owned by the simulation thread.
+    int view_mode = 2;
+    float steps_per_second = 0.0f;
+    long long autosave_interval = 0;
+    int autosave_keep = 1;
+    int autosave_keyframe_interval = 1;
+    std::string autosave_filename;
+    int recording_interval = 1;
+
+    // Triple buffer: the producer writes snapshots[back], the consumer reads snapshots[front],
+    // and the third index is exchanged through 'middle' (with a flag marking fresh data).
+    static const int FRESH_SNAPSHOT = 4;
+    RenderSnapshot snapshots[3];
+    long long generation = 0;
+    int back = 0;
+    int front = 1;
+    std::atomic<int> middle{2};
+
+    std::atomic<bool> recording{false};
+    TrajectoryRecorder recorder;
+    Checkpointer checkpointer; // Finishes the queued saves when the simulation is destroyed
+};
@@ -0,0 +1,198 @@
+#include "survival_evaluator.h"
+#include "world.h"
+#include <algorithm>
+#include <thread>
+
+static const int SCENARIO_WORLD_SIZE = 11; // Same as the analyzer's local world
+static const int ENERGY_SAMPLES = 100;     // Energy samples per scenario, at most
+static const float MAX_NEIGHBOR_DENSITY = 0.3f;
+static const float MAX_ORGANIC_DENSITY = 0.2f;
+static const int MAX_RELATIVES = 4;
+
+// Follows the evaluated bot through one scenario.
+class ScenarioObserver : public WorldObserver {
+public:
+    explicit ScenarioObserver(const Bot* bot) : bot(bot) {}
+    void onReproduce(const Bot& parent, const Bot& child) override {
+        if (&parent == this->bot) this->reproductions++;
+    }
+    void onDeath(const Bot& dead_bot) override {
+        if (&dead_bot == this->bot) this->died = true;
+    }
+    const Bot* bot;
+    int reproductions = 0;
+    bool died = false;
+};
+
+static uint64_t scenarioSeed(uint64_t seed, int index) {
+    uint64_t z = seed + 0x9e3779b97f4a7c15ULL * (uint64_t)(index + 1);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static Vector2 randomEmptyCell(World& world) {
+    Random& random = world.getRandom();
+    for (int attempt = 0; attempt < SCENARIO_WORLD_SIZE * SCENARIO_WORLD_SIZE * 4; attempt++) {
+        Vector2 cell = {(float)random.next(0, SCENARIO_WORLD_SIZE - 1), (float)random.next(0, SCENARIO_WORLD_SIZE - 1)};
+        if (world.getBotAt(cell) == nullptr) return cell;
+    }
+    return {-1, -1};
+}
+
+static ScenarioResult runScenario(const Bot& original, const EvaluationSettings& settings, int index, int energy_interval) {
+    ScenarioResult result;
+    World world(SCENARIO_WORLD_SIZE, SCENARIO_WORLD_SIZE);
+    Random& random = world.getRandom();
+    random.seed(scenarioSeed(settings.seed, index));
+
+    // The evaluated bot sits in the center, as in the analyzer.
+    result.biome = random.next(0, BIOME_COUNT - 1);
+    world.setBiomeOverride(result.biome);
+    Bot* bot = new Bot(original);
+    bot->resetLife();
+    bot->setPosition({(float)(SCENARIO_WORLD_SIZE / 2), (float)(SCENARIO_WORLD_SIZE / 2)});
+    world.addBot(bot);
+
+    // Fill the other cells with random bots (or ones drawn from the pool) and corpses.
+    const std::vector<Bot>* pool = settings.neighbor_pool && !settings.neighbor_pool->empty() ? settings.neighbor_pool.get() : nullptr;
+    float neighbor_density = random.nextFloat() * MAX_NEIGHBOR_DENSITY;
+    float organic_density = random.nextFloat() * MAX_ORGANIC_DENSITY;
+    for (int x = 0; x < SCENARIO_WORLD_SIZE; x++) {
+        for (int y = 0; y < SCENARIO_WORLD_SIZE; y++) {
+            Vector2 cell = {(float)x, (float)y};
+            if (world.getBotAt(cell) != nullptr) continue;
+            float roll = random.nextFloat();
+            if (roll >= neighbor_density + organic_density) continue;
+            Bot* other = nullptr;
+            if (roll < neighbor_density && pool) {
+                other = new Bot((*pool)[random.next(0, (int)pool->size() - 1)]);
+                other->resetLife();
+                other->clearLineage();
+            } else {
+                other = new Bot(random);
+            }
+            other->setPosition(cell);
+            if (roll < neighbor_density) {
+                result.neighbors++;
+            } else {
+                other->isOrganic = true;
+                other->addEnergy(random.next(0, 100)); // Some are worth more than others
+                result.organics++;
+            }
+            world.addBot(other);
+        }
+    }
+    int relatives = random.next(0, MAX_RELATIVES);
+    for (int i = 0; i < relatives; i++) {
+        Vector2 cell = randomEmptyCell(world);
+        if (cell.x < 0) break;
+        Bot* relative = new Bot(original);
+        relative->resetLife();
+        relative->setPosition(cell);
+        world.addBot(relative);
+        result.relatives++;
+    }
+
+    ScenarioObserver observer(bot);
+    world.setObserver(&observer);
+    result.energy.reserve(settings.max_steps / energy_interval + 1);
+    result.energy.push_back((float)bot->getEnergy());
+    int step = 0;
+    while (step < settings.max_steps) {
+        world.process();
+        step++;
+        if (observer.died) break; // The bot is gone, the rest of the world does not matter
+        if (step % energy_interval == 0) result.energy.push_back((float)bot->getEnergy());
+    }
+    result.survived = !observer.died;
+    result.survival_steps = step;
+    result.reproductions = observer.reproductions;
+    result.energy.resize(settings.max_steps / energy_interval + 1, 0.0f);
+    return result;
+}
+
+// Sorts values in place.
+static Distribution distributionOf(std::vector<float>& values) {
+    Distribution distribution;
+    if (values.empty()) return distribution;
+    std::sort(values.begin(), values.end());
+    auto percentile = [&](float p) { return values[(size_t)(p * (values.size() - 1) + 0.5f)]; };
+    double sum = 0.0;
+    for (float value : values) sum += value;
+    distribution.mean = (float)(sum / values.size());
+    distribution.min = values.front();
+    distribution.p10 = percentile(0.1f);
+    distribution.median = percentile(0.5f);
+    distribution.p90 = percentile(0.9f);
+    distribution.max = values.back();
+    return distribution;
+}
+
+EvaluationReport evaluateSurvival(const Bot& bot, const EvaluationSettings& settings,
+                                  std::atomic<int>* progress, const std::atomic<bool>* cancel) {
+    EvaluationReport report;
+    report.energy_interval = std::max(1, settings.max_steps / ENERGY_SAMPLES);
+    if (settings.scenarios <= 0 || bot.getGenome().empty()) return report;
+
+    // Threads take the next scenario index until none is left. The results land at their
+    // index, so the report is the same for any thread count.
+    std::vector<ScenarioResult> results(settings.scenarios);
+    std::vector<char> finished(settings.scenarios, 0);
+    std::atomic<int> next_scenario{0};
+    auto work = [&]() {
+        while (true) {
+            if (cancel && cancel->load(std::memory_order_relaxed)) return;
+            int index = next_scenario.fetch_add(1);
+            if (index >= settings.scenarios) return;
+            results[index] = runScenario(bot, settings, index, report.energy_interval);
+            finished[index] = 1;
+            if (progress) progress->fetch_add(1);
+        }
+    };
+    int thread_count = settings.threads > 0 ? settings.threads : (int)std::thread::hardware_concurrency();
+    thread_count = std::clamp(thread_count, 1, settings.scenarios);
+    std::vector<std::thread> threads;
+    for (int i = 1; i < thread_count; i++) threads.emplace_back(work);
+    work();
+    for (std::thread& thread : threads) thread.join();
+
+    for (int i = 0; i < settings.scenarios; i++) {
+        if (finished[i]) {
+            report.scenarios.push_back(std::move(results[i]));
+        } else {
+            report.cancelled = true;
+        }
+    }
+    if (report.scenarios.empty()) return report;
+
+    // Aggregate.
+    std::vector<float> survival_steps, reproductions;
+    int survivors = 0;
+    int biome_scenarios[BIOME_COUNT] = {};
+    int biome_survivors[BIOME_COUNT] = {};
+    for (const ScenarioResult& result : report.scenarios) {
+        survival_steps.push_back((float)result.survival_steps);
+        reproductions.push_back((float)result.reproductions);
+        survivors += result.survived;
+        biome_scenarios[result.biome]++;
+        biome_survivors[result.biome] += result.survived;
+    }
+    report.survival_rate = (float)survivors / report.scenarios.size();
+    for (int b = 0; b < BIOME_COUNT; b++) {
+        report.survival_rate_by_biome[b] = biome_scenarios[b] ? (float)biome_survivors[b] / biome_scenarios[b] : 0.0f;
+    }
+    report.survival_steps = distributionOf(survival_steps);
+    report.reproductions = distributionOf(reproductions);
+
+    size_t samples = report.scenarios[0].energy.size();
+    std::vector<float> column(report.scenarios.size());
+    for (size_t s = 0; s < samples; s++) {
+        for (size_t i = 0; i < report.scenarios.size(); i++) column[i] = report.scenarios[i].energy[s];
+        Distribution distribution = distributionOf(column);
+        report.energy_p10.push_back(distribution.p10);
+        report.energy_median.push_back(distribution.median);
+        report.energy_p90.push_back(distribution.p90);
+    }
+    return report;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "bot.h"
+#include "census.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Monte Carlo estimate of how a genome fares: the bot is dropped into many small randomized
+// worlds (biome, neighbor density, corpses and relatives vary), which are processed in
+// parallel. Every scenario is generated from the seed and its own index, so a report does
+// not depend on the number of threads.
+struct EvaluationSettings {
+    int scenarios = 200;
+    int max_steps = 3000;  // A bot still alive after this many steps survived its scenario
+    int threads = 0;       // 0 = one per hardware thread
+    uint64_t seed = 1;
+    // Neighbors are copies of these bots (e.g. a genome bank's, see genome_bank.h) instead of
+    // random ones, if set and not empty. Corpses stay random.
+    std::shared_ptr<const std::vector<Bot>> neighbor_pool;
+};
+
+// What happened in one scenario.
+struct ScenarioResult {
+    int biome = 0;
+    int neighbors = 0;        // Unrelated random bots (or from the neighbor pool)
+    int organics = 0;         // Corpses
+    int relatives = 0;        // Copies of the evaluated bot
+    int survival_steps = 0;   // Steps until death, max_steps if it survived
+    bool survived = false;
+    int reproductions = 0;
+    std::vector<float> energy; // At every sample point (see EvaluationReport::energy_interval), 0 after death
+};
+
+struct Distribution {
+    float mean = 0.0f;
+    float min = 0.0f;
+    float p10 = 0.0f;
+    float median = 0.0f;
+    float p90 = 0.0f;
+    float max = 0.0f;
+};
+
+struct EvaluationReport {
+    std::vector<ScenarioResult> scenarios; // In scenario order
+    bool cancelled = false;                // Only the finished scenarios are in the report then
+    float survival_rate = 0.0f;
+    float survival_rate_by_biome[BIOME_COUNT] = {};
+    Distribution survival_steps;
+    Distribution reproductions;
+    int energy_interval = 1;               // Steps between energy samples, the first is at step 0
+    std::vector<float> energy_p10;         // Per sample point, over all scenarios
+    std::vector<float> energy_median;
+    std::vector<float> energy_p90;
+};
+
+// Evaluates the genome of bot (its state is reset to a newborn's). progress, if given, is
+// increased after every finished scenario; setting cancel stops the evaluation early.
+EvaluationReport evaluateSurvival(const Bot& bot, const EvaluationSettings& settings,
+                                  std::atomic<int>* progress = nullptr, const std::atomic<bool>* cancel = nullptr);
@@ -0,0 +1,141 @@
+#include "telemetry.h"
+#include <algorithm>
+#include <cstdio>
+
+static const size_t BLOCK_SIZE = 64 * 1024;
+static const size_t MAX_PENDING_BLOCKS = 16; // 1 MB at most waiting for the disk
+
+TelemetryWriter::~TelemetryWriter() {
+    stop();
+}
+
+bool TelemetryWriter::start(const std::string& filename, World& world, long long interval) {
+    stop();
+    this->file = fopen(filename.c_str(), "w");
+    if (!this->file) return false;
+    this->world = &world;
+    this->next_observer = world.getObserver();
+    world.setObserver(this);
+    this->interval = std::max(1LL, interval);
+    this->steps = 0;
+    this->step_seconds = 0.0;
+    this->births = this->deaths = this->kills = 0;
+    std::fill(std::begin(this->genome_buckets), std::end(this->genome_buckets), 0);
+    this->total_genome_length = 0;
+    this->living = 0;
+    for (const Bot* bot : world.getBots()) {
+        if (!bot->isOrganic) _addGenome(bot->getGenome().size(), 1);
+    }
+    this->dropped_rows = 0;
+    this->failed = false;
+    this->stopping = false;
+
+    this->block = "step,bots,organic,births,deaths,kills,mean_energy,mean_genome_length,step_ms";
+    for (int i = 0; i < GENOME_BUCKETS - 1; i++) {
+        this->block += ",genome_len_" + std::to_string(i * GENOME_BUCKET_SIZE) + "_" + std::to_string((i + 1) * GENOME_BUCKET_SIZE - 1);
+    }
+    this->block += ",genome_len_" + std::to_string((GENOME_BUCKETS - 1) * GENOME_BUCKET_SIZE) + "_plus\n";
+    this->block_rows = 0;
+    this->block_start = std::chrono::steady_clock::now();
+    this->thread = std::thread(&TelemetryWriter::_run, this);
+    return true;
+}
+
+void TelemetryWriter::stop() {
+    if (!this->world) return;
+    if (this->world->getObserver() == this) this->world->setObserver(this->next_observer);
+    this->world = nullptr;
+    _handOver();
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    this->thread.join();
+    if (fclose(this->file) != 0) this->failed = true;
+    this->file = nullptr;
+}
+
+void TelemetryWriter::recordStep(double step_seconds) {
+    if (!this->world) return;
+    this->steps++;
+    this->step_seconds += step_seconds;
+    if (this->world->getStepCount() % this->interval == 0) _writeRow();
+}
+
+void TelemetryWriter::onReproduce(const Bot& parent, const Bot& child) {
+    this->births++;
+    _addGenome(child.getGenome().size(), 1);
+    if (this->next_observer) this->next_observer->onReproduce(parent, child);
+}
+
+void TelemetryWriter::onAttack(const Bot& attacker, const Bot& victim) {
+    this->kills++;
+    if (this->next_observer) this->next_observer->onAttack(attacker, victim);
+}
+
+void TelemetryWriter::onDeath(const Bot& bot) {
+    this->deaths++;
+    _addGenome(bot.getGenome().size(), -1);
+    if (this->next_observer) this->next_observer->onDeath(bot);
+}
+
+void TelemetryWriter::_addGenome(size_t size, int sign) {
+    int bucket = (int)std::min(size / GENOME_BUCKET_SIZE, (size_t)GENOME_BUCKETS - 1);
+    this->genome_buckets[bucket] += sign;
+    this->total_genome_length += sign * (long long)size;
+    this->living += sign;
+}
+
+void TelemetryWriter::_writeRow() {
+    CensusSample census = this->world->getCensus().getCurrent();
+    char row[512];
+    int length = snprintf(row, sizeof(row), "%lld,%d,%d,%d,%d,%d,%.2f,%.2f,%.4f", this->world->getStepCount(), census.bots,
+                          census.organic, this->births, this->deaths, this->kills, census.mean_energy,
+                          this->living > 0 ? (double)this->total_genome_length / this->living : 0.0,
+                          this->steps > 0 ? this->step_seconds * 1000.0 / this->steps : 0.0);
+    for (int count : this->genome_buckets) {
+        length += snprintf(row + length, sizeof(row) - length, ",%d", count);
+    }
+    this->block.append(row, (size_t)length);
+    this->block += '\n';
+    this->block_rows++;
+    this->steps = 0;
+    this->step_seconds = 0.0;
+    this->births = this->deaths = this->kills = 0;
+
+    if (this->block.size() >= BLOCK_SIZE || std::chrono::steady_clock::now() - this->block_start >= std::chrono::seconds(1)) {
+        _handOver();
+    }
+}
+
+void TelemetryWriter::_handOver() {
+    if (!this->block.empty()) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->blocks.size() < MAX_PENDING_BLOCKS) {
+            this->blocks.push_back(std::move(this->block));
+        } else {
+            this->dropped_rows += this->block_rows;
+        }
+    }
+    this->wake.notify_all();
+    this->block.clear();
+    this->block.reserve(BLOCK_SIZE + 512);
+    this->block_rows = 0;
+    this->block_start = std::chrono::steady_clock::now();
+}
+
+void TelemetryWriter::_run() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true) {
+        this->wake.wait(lock, [this] { return this->stopping || !this->blocks.empty(); });
+        if (this->blocks.empty()) return; // Stopping, and everything is written
+        std::string block = std::move(this->blocks.front());
+        this->blocks.pop_front();
+        lock.unlock();
+        if (!this->failed && (fwrite(block.data(), 1, block.size(), this->file) != block.size() || fflush(this->file) != 0)) {
+            this->failed = true;
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "world.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// A CSV stream of what happens in a world, one row every 'interval' steps:
+//   step, bots, organic, births, deaths, kills, mean_energy, mean_genome_length, step_ms,
+//   genome_len_0_15, genome_len_16_31, ..., genome_len_240_255, genome_len_256_plus
+// Births, deaths (living bots that died, including the killed ones) and kills are totals
+// since the row before, step_ms the mean World::process() time over them; the rest is the
+// state after the row's step. The histogram counts living bots by genome length.
+//
+// The writer observes the world (see WorldObserver), so births, deaths and kills are counted
+// where they happen and the genome lengths are kept up to date with them; only attaching
+// scans the bots once. Rows are formatted on the simulation thread into a block that a
+// background thread writes out once it is full (or a second old). The queue of full blocks is
+// bounded: should the disk fall that far behind, rows are dropped and counted rather than
+// making the simulation wait.
+class TelemetryWriter : public WorldObserver {
+public:
+    static const int GENOME_BUCKET_SIZE = 16;
+    static const int GENOME_BUCKETS = 17; // The last one holds all longer genomes
+
+    TelemetryWriter() = default;
+    ~TelemetryWriter() override; // Stops
+    TelemetryWriter(const TelemetryWriter&) = delete;
+    TelemetryWriter& operator=(const TelemetryWriter&) = delete;
+
+    // Creates the file, writes the header and attaches to the world (events go on to the
+    // world's previous observer). False if the file cannot be created.
+    bool start(const std::string& filename, World& world, long long interval);
+    // Detaches, writes the rest and closes the file.
+    void stop();
+    bool isRunning() const { return this->world != nullptr; }
+    // To be called after every World::process() with the time it took.
+    void recordStep(double step_seconds);
+    long long getDroppedRows() const { return this->dropped_rows; }
+    bool hasFailed() const { return this->failed; } // A write failed; the file ends before it
+
+    void onReproduce(const Bot& parent, const Bot& child) override;
+    void onAttack(const Bot& attacker, const Bot& victim) override;
+    void onDeath(const Bot& bot) override;
+
+private:
+    void _addGenome(size_t size, int sign);
+    void _writeRow();
+    void _handOver(); // Queues the current block for the writer thread
+    void _run();
+
+    World* world = nullptr;
+    WorldObserver* next_observer = nullptr;
+    long long interval = 1;
+
+    // Owned by the simulation thread
+    long long steps = 0; // Since the last row
+    double step_seconds = 0.0;
+    int births = 0;
+    int deaths = 0;
+    int kills = 0;
+    int genome_buckets[GENOME_BUCKETS] = {};
+    long long total_genome_length = 0;
+    int living = 0; // Bots in the histogram
+    std::string block;
+    int block_rows = 0;
+    std::chrono::steady_clock::time_point block_start;
+
+    FILE* file = nullptr;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake; // Signals new blocks or stopping
+    std::deque<std::string> blocks;
+    bool stopping = false;
+    std::atomic<long long> dropped_rows{0};
+    std::atomic<bool> failed{false};
+};
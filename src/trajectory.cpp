@@ -0,0 +1,264 @@
+#include "trajectory.h"
+#include "compression.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+const char TRAJECTORY_MAGIC[4] = {'E', 'V', 'O', 'T'};
+const uint16_t TRAJECTORY_VERSION = 1;
+const size_t MAX_PENDING_FRAMES = 8;
+const std::chrono::milliseconds MAX_WRITER_WAIT(2); // Per frame, before it is skipped
+
+void captureTrajectoryFrame(const World& world, uint8_t* cells) {
+    memset(cells, 0, 2 * (size_t)world.getWidth() * world.getHeight());
+    for (const Bot* bot : world.getBots()) captureTrajectoryCell(*bot, world.getWidth(), world.getHeight(), cells);
+}
+
+void captureTrajectoryCell(const Bot& bot, int width, int height, uint8_t* cells) {
+    Vector2 position = bot.getPosition();
+    size_t cell = (size_t)position.y * width + (size_t)position.x;
+    cells[cell] = trajectoryCellState(bot, bot.getDiet());
+    Color color = bot.getColor();
+    cells[(size_t)width * height + cell] = (uint8_t)((color.r & 0xE0) | (color.g & 0xE0) >> 3 | color.b >> 6);
+}
+
+void renderTrajectoryFrame(const uint8_t* cells, int width, int height, int view_mode, Color* pixels) {
+    // The diets' colors at full strength in the nutrition view
+    static const Color diet_colors[DIET_COUNT] = {
+        {255, 255, 0, 255}, // DIET_NEUTRAL
+        {0, 255, 0, 255},   // DIET_PHOTOSYNTHESIS
+        {255, 0, 0, 255},   // DIET_HUNTING
+        {0, 0, 255, 255}    // DIET_SCAVENGING
+    };
+    const size_t cell_count = (size_t)width * height;
+    renderBackground(pixels, width, height);
+    for (size_t cell = 0; cell < cell_count; cell++) {
+        uint8_t state = cells[cell];
+        int kind = state & 3;
+        if (kind == TRAJECTORY_EMPTY) continue;
+        Color color;
+        if (kind == TRAJECTORY_ORGANIC) {
+            color = {GRAY.r, GRAY.g, GRAY.b, 255};
+        } else {
+            uint8_t rgb = cells[cell_count + cell];
+            color = view_mode == 1 ? diet_colors[state >> 6]
+                                   : Color{(unsigned char)((rgb & 0xE0) * 255 / 0xE0), (unsigned char)(((rgb >> 2) & 0x7) * 255 / 7),
+                                           (unsigned char)((rgb & 0x3) * 255 / 3), 255};
+            int energy = (((state >> 2) & 15) * 2 + 1) * (MAX_ENERGY + 1) / 32; // The middle of the bucket
+            color.a = (unsigned char)(std::min(energy, MAX_ENERGY) * 255 / MAX_ENERGY);
+        }
+        pixels[cell] = blendOver(pixels[cell], color);
+    }
+}
+
+static void putU32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+static uint32_t getU32(const uint8_t* in) {
+    return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+// out = a ^ b, eight bytes at a time (out may be a)
+static void xorBytes(const uint8_t* a, const uint8_t* b, uint8_t* out, size_t size) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t x, y;
+        memcpy(&x, a + i, 8);
+        memcpy(&y, b + i, 8);
+        x ^= y;
+        memcpy(out + i, &x, 8);
+    }
+    for (; i < size; i++) out[i] = a[i] ^ b[i];
+}
+
+TrajectoryRecorder::~TrajectoryRecorder() {
+    stop();
+}
+
+bool TrajectoryRecorder::start(const std::string& filename, int width, int height, int keyframe_interval) {
+    stop();
+    this->file = fopen(filename.c_str(), "wb");
+    if (!this->file) return false;
+    this->width = width;
+    this->height = height;
+    this->keyframe_interval = std::clamp(keyframe_interval, 1, 65535);
+    this->frame_count = 0;
+    this->skipped_frames = 0;
+    this->writer_stalled = false;
+    this->failed = false;
+    this->stopping = false;
+
+    uint8_t header[TRAJECTORY_HEADER_SIZE];
+    memcpy(header, TRAJECTORY_MAGIC, 4);
+    header[4] = (uint8_t)TRAJECTORY_VERSION;
+    header[5] = (uint8_t)(TRAJECTORY_VERSION >> 8);
+    header[6] = (uint8_t)this->keyframe_interval;
+    header[7] = (uint8_t)(this->keyframe_interval >> 8);
+    putU32(header + 8, (uint32_t)width);
+    putU32(header + 12, (uint32_t)height);
+    if (fwrite(header, 1, sizeof(header), this->file) != sizeof(header)) {
+        fclose(this->file);
+        this->file = nullptr;
+        return false;
+    }
+    this->thread = std::thread(&TrajectoryRecorder::_run, this);
+    return true;
+}
+
+void TrajectoryRecorder::stop() {
+    if (!this->file) return;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    this->thread.join();
+    if (fclose(this->file) != 0) this->failed = true;
+    this->file = nullptr;
+    this->spare.clear();
+}
+
+void TrajectoryRecorder::record(const World& world) {
+    if (!this->file || world.getWidth() != this->width || world.getHeight() != this->height) return;
+    std::vector<uint8_t> cells;
+    {
+        // A short wait lets the writer run on a single core. Once one timed out the disk is
+        // stalled, and frames are skipped without waiting until the writer takes one again.
+        std::unique_lock<std::mutex> lock(this->mutex);
+        auto has_space = [this] { return this->queue.size() < MAX_PENDING_FRAMES; };
+        if (!has_space() && (this->writer_stalled || !this->space.wait_for(lock, MAX_WRITER_WAIT, has_space))) {
+            this->writer_stalled = true;
+            this->skipped_frames++;
+            return;
+        }
+        this->writer_stalled = false;
+        if (!this->spare.empty()) {
+            cells.swap(this->spare.back());
+            this->spare.pop_back();
+        }
+    }
+    cells.resize(2 * (size_t)this->width * this->height);
+    if (const uint8_t* tracked = world.getTrackedCells()) {
+        memcpy(cells.data(), tracked, cells.size());
+    } else {
+        captureTrajectoryFrame(world, cells.data());
+    }
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->queue.push_back({world.getStepCount(), std::move(cells)});
+    }
+    this->wake.notify_all();
+}
+
+void TrajectoryRecorder::_run() {
+    std::vector<uint8_t> previous;
+    std::vector<uint8_t> delta;
+    std::vector<uint8_t> stored;
+    long long written = 0;
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true) {
+        this->wake.wait(lock, [this] { return this->stopping || !this->queue.empty(); });
+        if (this->queue.empty()) return; // Stopping, and everything is written
+        Frame frame = std::move(this->queue.front());
+        this->queue.pop_front();
+        lock.unlock();
+        this->space.notify_all();
+
+        bool is_keyframe = written % this->keyframe_interval == 0;
+        if (is_keyframe) {
+            compressBlocks(frame.cells.data(), frame.cells.size(), 1, 1, stored);
+        } else {
+            delta.resize(frame.cells.size());
+            xorBytes(frame.cells.data(), previous.data(), delta.data(), delta.size());
+            compressBlocks(delta.data(), delta.size(), 1, 1, stored);
+        }
+        uint8_t header[TRAJECTORY_FRAME_HEADER_SIZE];
+        putU32(header, (uint32_t)stored.size());
+        putU32(header + 4, crc32(stored.data(), stored.size()));
+        putU32(header + 8, (uint32_t)(uint64_t)frame.step);
+        putU32(header + 12, (uint32_t)((uint64_t)frame.step >> 32));
+        header[16] = is_keyframe;
+        if (!this->failed && (fwrite(header, 1, sizeof(header), this->file) != sizeof(header) ||
+                              fwrite(stored.data(), 1, stored.size(), this->file) != stored.size())) {
+            this->failed = true;
+        }
+        written++;
+        this->frame_count = written;
+        previous.swap(frame.cells);
+
+        lock.lock();
+        this->spare.push_back(std::move(frame.cells)); // The frame before this one
+    }
+}
+
+bool TrajectoryPlayer::open(const std::string& filename) {
+    close();
+    std::unique_ptr<MappedFile> mapped(new MappedFile(filename));
+    const uint8_t* data = mapped->data();
+    size_t size = mapped->size();
+    if (!mapped->isOpen() || size < TRAJECTORY_HEADER_SIZE || memcmp(data, TRAJECTORY_MAGIC, 4) != 0) return false;
+    uint16_t version = (uint16_t)(data[4] | data[5] << 8);
+    uint32_t width = getU32(data + 8);
+    uint32_t height = getU32(data + 12);
+    if (version < 1 || version > TRAJECTORY_VERSION || width == 0 || height == 0 || (uint64_t)width * height > (1u << 28)) {
+        return false;
+    }
+
+    // Index the frames up to the last complete one. Decoding starts at the first keyframe.
+    size_t offset = TRAJECTORY_HEADER_SIZE;
+    while (size - offset >= TRAJECTORY_FRAME_HEADER_SIZE) {
+        const uint8_t* header = data + offset;
+        FrameInfo frame;
+        frame.size = getU32(header);
+        frame.crc = getU32(header + 4);
+        frame.step = (long long)((uint64_t)getU32(header + 8) | (uint64_t)getU32(header + 12) << 32);
+        frame.is_keyframe = header[16] != 0;
+        frame.offset = offset + TRAJECTORY_FRAME_HEADER_SIZE;
+        if (frame.size > size - frame.offset) break;
+        if (this->frames.empty() && !frame.is_keyframe) break;
+        this->frames.push_back(frame);
+        offset = frame.offset + frame.size;
+    }
+    this->file = std::move(mapped);
+    this->width = (int)width;
+    this->height = (int)height;
+    this->cells.assign(2 * (size_t)width * height, 0);
+    this->current = -1;
+    return true;
+}
+
+void TrajectoryPlayer::close() {
+    this->file.reset();
+    this->frames.clear();
+    this->cells.clear();
+    this->current = -1;
+}
+
+bool TrajectoryPlayer::seek(int frame) {
+    if (!this->file || frame < 0 || frame >= (int)this->frames.size()) return false;
+    if (frame == this->current) return true;
+    int keyframe = frame;
+    while (!this->frames[keyframe].is_keyframe) keyframe--; // Frame 0 is one
+    int start = this->current >= keyframe && this->current < frame ? this->current + 1 : keyframe;
+    for (int i = start; i <= frame; i++) {
+        if (!_decode(i)) {
+            this->current = -1;
+            return false;
+        }
+        this->current = i;
+    }
+    return true;
+}
+
+bool TrajectoryPlayer::_decode(int frame) {
+    const FrameInfo& info = this->frames[frame];
+    const uint8_t* stored = this->file->data() + info.offset;
+    if (crc32(stored, info.size) != info.crc) return false;
+    if (info.is_keyframe) {
+        return decompressBlocks(stored, info.size, 1, this->cells) && this->cells.size() == 2 * (size_t)this->width * this->height;
+    }
+    if (!decompressBlocks(stored, info.size, 1, this->decoded) || this->decoded.size() != this->cells.size()) return false;
+    xorBytes(this->cells.data(), this->decoded.data(), this->cells.data(), this->cells.size());
+    return true;
+}
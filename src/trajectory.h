@@ -0,0 +1,132 @@
+#pragma once
+#include "world.h"
+#include "save_format.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Trajectories: the cells of a world recorded step by step, to be played back (scrubbed,
+// seeked, at any speed) without running the simulation.
+//
+// A frame has two bytes per cell, in two planes of width * height bytes (row by row):
+//   state   bits 0-1 the kind (TrajectoryCell), bits 2-5 the energy in 16 buckets of
+//           MAX_ENERGY, bits 6-7 the diet (Diet)
+//   color   the bot's color as RGB 3-3-2
+// The file is "EVOT", a uint16 version, a uint16 keyframe interval, uint32 width and height,
+// then the frames, each with a 17-byte header:
+//   uint32 stored size, uint32 CRC-32 of the stored bytes, int64 step, uint8 1 for a keyframe
+// and the frame compressed as in compression.h. Every keyframe interval frames the whole
+// frame is stored; the frames in between are XORed with the one before, so the unchanged
+// cells turn into runs of zeros. There is no index: the player builds one by walking the
+// frame headers, so a recording cut off by a crash plays up to its last complete frame.
+enum TrajectoryCell {
+    TRAJECTORY_EMPTY = 0,
+    TRAJECTORY_LIVING = 1,
+    TRAJECTORY_ORGANIC = 2
+};
+const int TRAJECTORY_KEYFRAME_INTERVAL = 128;
+const int TRAJECTORY_DEFAULT_INTERVAL = 10; // Steps between frames
+// Below this many steps between frames, the recorder's callers let the world track its cells
+// (a few percent of every step); from here on a full capture per frame costs less.
+const int TRAJECTORY_TRACKING_INTERVAL = 16;
+const size_t TRAJECTORY_HEADER_SIZE = 16;
+const size_t TRAJECTORY_FRAME_HEADER_SIZE = 17;
+
+void captureTrajectoryFrame(const World& world, uint8_t* cells); // 2 * width * height bytes
+void captureTrajectoryCell(const Bot& bot, int width, int height, uint8_t* cells); // The bot's cell only
+// A bot's byte in the state plane, given its diet (Bot::getDiet()). Only this byte changes
+// while a bot stays in its cell.
+inline uint8_t trajectoryCellState(const Bot& bot, int diet) {
+    int energy_bucket = std::clamp(bot.getEnergy() * 16 / (MAX_ENERGY + 1), 0, 15);
+    int kind = bot.isOrganic ? TRAJECTORY_ORGANIC : TRAJECTORY_LIVING;
+    return (uint8_t)(kind | energy_bucket << 2 | diet << 6);
+}
+// Draws a frame the way World::render() draws the world (view_mode 1 colors by diet).
+void renderTrajectoryFrame(const uint8_t* cells, int width, int height, int view_mode, Color* pixels);
+
+// Appends frames to a trajectory file. Capturing a frame (record()) copies the world's tracked
+// cells (see World::setTrackingCells()) or, while it does not track them, is a pass over the
+// bots on the caller's thread; the delta, the compression and the writing happen on a writer
+// thread. If the writer is a few frames behind, record() waits for it, but only briefly: frames
+// the writer cannot take in time (a stalled disk) are skipped and counted. The next frame's
+// delta is taken against the last written one, so the file only misses those steps.
+class TrajectoryRecorder {
+public:
+    TrajectoryRecorder() = default;
+    ~TrajectoryRecorder(); // Stops
+    TrajectoryRecorder(const TrajectoryRecorder&) = delete;
+    TrajectoryRecorder& operator=(const TrajectoryRecorder&) = delete;
+
+    bool start(const std::string& filename, int width, int height, int keyframe_interval = TRAJECTORY_KEYFRAME_INTERVAL);
+    void stop(); // Writes the queued frames and closes the file
+    bool isRecording() const { return this->file != nullptr; }
+    void record(const World& world); // Ignored for a world of another size
+    long long getFrameCount() const { return this->frame_count; } // Written
+    long long getSkippedFrames() const { return this->skipped_frames; }
+    bool hasFailed() const { return this->failed; } // A write failed; the file ends before it
+
+private:
+    struct Frame {
+        long long step;
+        std::vector<uint8_t> cells;
+    };
+    void _run();
+
+    FILE* file = nullptr;
+    int width = 0;
+    int height = 0;
+    int keyframe_interval = TRAJECTORY_KEYFRAME_INTERVAL;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;  // Signals a new frame or stopping
+    std::condition_variable space; // Signals that the writer took a frame
+    std::deque<Frame> queue;
+    std::vector<std::vector<uint8_t>> spare; // Written frames' buffers, for reuse
+    bool stopping = false;
+    bool writer_stalled = false; // The last wait for the writer timed out
+    std::atomic<long long> frame_count{0};
+    std::atomic<long long> skipped_frames{0};
+    std::atomic<bool> failed{false};
+};
+
+// Reads a trajectory file for playback.
+class TrajectoryPlayer {
+public:
+    bool open(const std::string& filename); // Fails for anything but a trajectory
+    void close();
+    bool isOpen() const { return this->file != nullptr; }
+    int getWidth() const { return this->width; }
+    int getHeight() const { return this->height; }
+    int getFrameCount() const { return (int)this->frames.size(); }
+    long long getStep(int frame) const { return this->frames[frame].step; }
+    // Makes frame the current one, decoding forward from the current frame or the keyframe
+    // before it, whichever is closer. False if a frame on the way is damaged.
+    bool seek(int frame);
+    int getCurrentFrame() const { return this->current; }
+    const uint8_t* getCells() const { return this->cells.data(); } // The current frame
+
+private:
+    struct FrameInfo {
+        size_t offset; // Of the stored bytes
+        uint32_t size;
+        uint32_t crc;
+        long long step;
+        bool is_keyframe;
+    };
+    bool _decode(int frame);
+
+    std::unique_ptr<MappedFile> file;
+    int width = 0;
+    int height = 0;
+    std::vector<FrameInfo> frames;
+    std::vector<uint8_t> cells;
+    std::vector<uint8_t> decoded;
+    int current = -1;
+};
@@ -1,9 +1,10 @@
 #include "ui.h"
 #include <string>
-#include <fstream>
 #include <algorithm>
+#include <cstdio>
 
 #include "instructions.h"
+#include "compression.h"
 UI::UI() {}
 
 UI::~UI() {
@@ -14,102 +15,77 @@ UI::~UI() {
 }
 
 bool UI::isPaused() const {
-    return is_paused || is_scanning_relatives || genome_analyzer.isOpen();
+    return is_paused || genome_analyzer.isOpen() || player.isOpen();
 }
 
 int UI::getViewMode() const {
     return current_view_mode;
 }
 
-Bot* UI::getOrganismRoot() const {
-    return organism_root;
-}
-
-int UI::getSpeedDivisor() const {
-    return speed_divisor;
-}
-
 bool UI::isScanningRelatives() const {
     return is_scanning_relatives;
 }
 
-const std::vector<Bot*>& UI::getHighlightedRelatives() const {
-    return highlighted_relatives;
-}
+void UI::handleInput(Simulation& simulation, const RenderSnapshot& snapshot, Viewport& viewport) {
+    // Zoom and pan, unless ImGui (or the genome analyzer) owns the input.
+    viewport.handleInput(ImGui::GetIO().WantCaptureMouse || genome_analyzer.isOpen(),
+                         ImGui::GetIO().WantCaptureKeyboard || genome_analyzer.isOpen());
 
-void UI::handleInput(World& world) {
     // Keyboard input
     // We check WantCaptureKeyboard to prevent triggering hotkeys while typing in InputText or navigating menus/modals.
     if (!ImGui::GetIO().WantCaptureKeyboard) {
-        if (IsKeyPressed(KEY_SPACE) && !is_scanning_relatives) is_paused = !is_paused;
+        if (IsKeyPressed(KEY_SPACE)) is_paused = !is_paused;
         if (IsKeyPressed(KEY_ONE)) current_view_mode = 1;
         if (IsKeyPressed(KEY_TWO)) current_view_mode = 2;
-        if (IsKeyPressed(KEY_G) && selected_bot != nullptr && !selected_bot->isOrganic) {
-            genome_analyzer.analyze(selected_bot);
+        if (IsKeyPressed(KEY_T)) simulation.setTargetRate(simulation.getTargetRate() == 0 ? target_rate : 0);
+        if (IsKeyPressed(KEY_G) && snapshot.selected_bot && !snapshot.selected_bot->isOrganic) {
+            genome_analyzer.analyze(*snapshot.selected_bot);
         }
     }
 
     // Mouse input
     // Don't allow deselection if the genome analyzer is open
     if (IsMouseButtonPressed(MOUSE_RIGHT_BUTTON) && !genome_analyzer.isOpen()) {
-        selected_bot = nullptr;
-        organism_root = nullptr;
+        simulation.deselect();
         selected_loaded_bot = nullptr;
+        selected_bank_entry = -1;
         is_scanning_relatives = false;
-        highlighted_relatives.clear();
-        scan_origin_bot = nullptr;
     }
 
     // ImGui::GetIO().WantCaptureMouse is true if the mouse is hovering over an ImGui window.
     // We only want to process world clicks (selecting bots) if the mouse is NOT interacting with the UI.
-    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && !ImGui::GetIO().WantCaptureMouse) {
-        Vector2 mouse_pos = GetMousePosition();
-        mouse_pos.y -= TOP_PANEL_HEIGHT; // Adjust for top panel
+    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && !ImGui::GetIO().WantCaptureMouse && !player.isOpen() && viewport.containsScreenPoint(GetMousePosition())) {
+        Vector2 cell = viewport.screenToCell(GetMousePosition());
         
         // Check if click is within the world bounds
-        if (mouse_pos.x >= 0 && mouse_pos.x < WORLD_WIDTH * CELL_SIZE && mouse_pos.y >= 0 && mouse_pos.y < WORLD_HEIGHT * CELL_SIZE) {
-            int grid_x = mouse_pos.x / CELL_SIZE;
-            int grid_y = mouse_pos.y / CELL_SIZE;
+        if (cell.x >= 0 && cell.x < snapshot.width && cell.y >= 0 && cell.y < snapshot.height) {
+            int grid_x = (int)cell.x;
+            int grid_y = (int)cell.y;
             Vector2 target_pos = {(float)grid_x, (float)grid_y};
 
             if (selected_loaded_bot != nullptr) {
-                if (world.getBotAt(target_pos) == nullptr) {
-                    Bot* new_bot = new Bot(*selected_loaded_bot);
-                    new_bot->setPosition(target_pos);
-                    world.addBot(new_bot);
-                }
+                simulation.placeBot(*selected_loaded_bot, target_pos);
             } else {
-                selected_bot = world.getBotAt(target_pos);
-                organism_root = selected_bot;
-                if (scan_origin_bot != selected_bot) {
-                    is_scanning_relatives = false;
-                    highlighted_relatives.clear();
-                    scan_origin_bot = nullptr;
-                }
+                // The simulation drops the relative highlighting if another bot gets selected.
+                simulation.selectAt(target_pos);
             }
         }
     }
 }
 
-void UI::drawWorldOverlay() const {
+void UI::drawWorldOverlay(const RenderSnapshot& snapshot, const Viewport& viewport) const {
     // World Overlay (Raylib)
     // We draw the selection box directly in the world using Raylib functions because
     // it needs to be aligned with the grid, not the UI layer.
-    if (selected_bot != nullptr) {
-        Vector2 pos = selected_bot->getPosition();
-        DrawRectangleLinesEx({pos.x * CELL_SIZE, pos.y * CELL_SIZE, (float)CELL_SIZE, (float)CELL_SIZE}, 3, YELLOW);
-    }
-}
-
-void UI::update() {
-    // If the selected bot has died during the last world process, clear the selection.
-    // This is safe to call after world.process() but before the next frame's drawing/input.
-    if (organism_root != nullptr && organism_root->is_dead) {
-        selected_bot = nullptr;
-        organism_root = nullptr;
-        is_scanning_relatives = false;
-        highlighted_relatives.clear();
-        scan_origin_bot = nullptr;
+    if (snapshot.selected_bot) {
+        Vector2 pos = snapshot.selected_bot->getPosition();
+        Rectangle screen = viewport.getScreenRect();
+        // Keep the box visible when zoomed out: at least 6 pixels wide.
+        float grow = std::max(0.0f, (6.0f / viewport.getZoom() - 1.0f) * 0.5f);
+        BeginScissorMode((int)screen.x, (int)screen.y, (int)screen.width, (int)screen.height);
+        DrawRectangleLinesEx(viewport.cellRectToScreen({pos.x - grow, pos.y - grow, 1 + 2 * grow, 1 + 2 * grow}),
+                             std::clamp(viewport.getZoom() / 5.0f, 1.0f, 3.0f), YELLOW);
+        EndScissorMode();
     }
 }
 
@@ -120,6 +96,8 @@ void UI::closeAllModals() {
     show_load_world_modal = false;
     show_save_bot_modal = false;
     show_load_bot_modal = false;
+    show_export_phylogeny_modal = false;
+    show_record_modal = false;
     // Close any active ImGui popups
     if (ImGui::IsPopupOpen(nullptr, ImGuiPopupFlags_AnyPopup)) {
         ImGui::CloseCurrentPopup();
@@ -127,7 +105,18 @@ void UI::closeAllModals() {
     genome_analyzer.close();
 }
 
-void UI::drawPanels(World& world) {
+void UI::drawPanels(Simulation& simulation, const RenderSnapshot& snapshot) {
+    // The selection and the relative highlighting live on the simulation thread;
+    // a selected bot that died is simply missing from the snapshot.
+    is_scanning_relatives = snapshot.showing_relatives;
+    if (snapshot.seed != last_seen_seed) {
+        if (refresh_seed_buffer) {
+            snprintf(seed_buffer, sizeof(seed_buffer), "%u", snapshot.seed);
+            refresh_seed_buffer = false;
+        }
+        last_seen_seed = snapshot.seed;
+    }
+
     // --- Main Menu Bar ---
     // Make menu bar transparent and borderless
     if (ImGui::BeginMainMenuBar()) {
@@ -151,28 +140,46 @@ void UI::drawPanels(World& world) {
             if (ImGui::MenuItem("Spawn Bots")) {
                 show_spawn_bots_modal = true;
             }
+            ImGui::MenuItem("Census", NULL, &show_census_window);
+            if (ImGui::MenuItem("Export Phylogeny")) {
+                show_export_phylogeny_modal = true;
+            }
+            if (simulation.isRecording()) {
+                if (ImGui::MenuItem("Stop Recording")) simulation.stopRecording();
+            } else if (ImGui::MenuItem("Record Trajectory")) {
+                show_record_modal = true;
+            }
+            ImGui::MenuItem("Playback", NULL, &show_playback_window);
             if (ImGui::MenuItem("Copy Seed")) {
-                std::string seed_str = std::to_string(world.getSeed());
+                std::string seed_str = std::to_string(snapshot.seed);
                 ImGui::SetClipboardText(seed_str.c_str());
             }
             ImGui::EndMenu();
         }
         ImGui::Dummy(ImVec2(10.0f, 0.0f));
         if (ImGui::BeginMenu("Speed")) {
-            if (ImGui::MenuItem("Original", NULL, speed_divisor == 1)) speed_divisor = 1;
-            if (ImGui::MenuItem("1/2", NULL, speed_divisor == 2)) speed_divisor = 2;
-            if (ImGui::MenuItem("1/4", NULL, speed_divisor == 4)) speed_divisor = 4;
-            if (ImGui::MenuItem("1/12", NULL, speed_divisor == 12)) speed_divisor = 12;
+            // The simulation runs on its own thread, so its speed is a step rate, not a frame divisor.
+            // Turbo runs as many steps as fit in the frame budget; the slider sets a fixed rate.
+            int rate = simulation.getTargetRate();
+            if (ImGui::MenuItem("Turbo (T)", NULL, rate == 0)) simulation.setTargetRate(0);
+            ImGui::Separator();
+            if (ImGui::SliderInt("Steps/s", &target_rate, 1, 10000, "%d", ImGuiSliderFlags_Logarithmic)) {
+                simulation.setTargetRate(target_rate);
+            }
+            if (ImGui::MenuItem("5 steps/s", NULL, rate == 5)) simulation.setTargetRate(target_rate = 5);
+            if (ImGui::MenuItem("60 steps/s", NULL, rate == 60)) simulation.setTargetRate(target_rate = 60);
+            if (ImGui::MenuItem("600 steps/s", NULL, rate == 600)) simulation.setTargetRate(target_rate = 600);
             ImGui::EndMenu();
         }
         ImGui::Dummy(ImVec2(10.0f, 0.0f));
         if (ImGui::BeginMenu("Bot")) {
-            if (ImGui::MenuItem("Save Bot", NULL, false, selected_bot != nullptr)) {
+            if (ImGui::MenuItem("Save Bot", NULL, false, snapshot.selected_bot.has_value())) {
                 show_save_bot_modal = true;
             }
             if (ImGui::MenuItem("Load Bot")) {
                 show_load_bot_modal = true;
             }
+            ImGui::MenuItem("Genome Bank", NULL, &show_bank_window);
             ImGui::EndMenu();
         }
         ImGui::Dummy(ImVec2(10.0f, 0.0f));
@@ -180,8 +187,8 @@ void UI::drawPanels(World& world) {
             for (const auto& bot_info : loaded_bots) {
                 if (ImGui::MenuItem(bot_info.filename.c_str(), NULL, selected_loaded_bot == bot_info.bot)) {
                     selected_loaded_bot = bot_info.bot;
-                    selected_bot = nullptr;
-                    organism_root = nullptr;
+                    selected_bank_entry = -1;
+                    simulation.deselect();
                 }
             }
             ImGui::EndMenu();
@@ -222,7 +229,7 @@ void UI::drawPanels(World& world) {
                     for (const char* p = seed_buffer; *p; ++p) final_seed = 31 * final_seed + *p;
                 }
             }
-            world.newWorld(final_seed, initial_bots_count);
+            simulation.newWorld(final_seed, initial_bots_count);
             ImGui::CloseCurrentPopup();
         }
         ImGui::SameLine();
@@ -243,7 +250,7 @@ void UI::drawPanels(World& world) {
 
         ImGui::InputInt("Amount", &bots_to_spawn_count);
         if (ImGui::Button("Spawn", ImVec2(0, 0))) {
-            world.spawnInitialBots(bots_to_spawn_count);
+            simulation.spawnBots(bots_to_spawn_count);
             ImGui::CloseCurrentPopup();
         }
         ImGui::SameLine();
@@ -263,12 +270,84 @@ void UI::drawPanels(World& world) {
         }
 
         ImGui::InputText("Filename", save_filename_buffer, IM_ARRAYSIZE(save_filename_buffer));
+        int compression_level = simulation.getCompressionLevel();
+        if (ImGui::SliderInt("Compression (0 = off)", &compression_level, 0, MAX_COMPRESSION_LEVEL)) {
+            simulation.setCompressionLevel(compression_level); // Autosaves too
+        }
         if (ImGui::Button("Save", ImVec2(0, 0))) { 
-            world.saveWorld(save_filename_buffer);
+            simulation.saveWorld(save_filename_buffer);
             ImGui::CloseCurrentPopup(); 
         }
         ImGui::SameLine();
         if (ImGui::Button("Cancel", ImVec2(0, 0))) { ImGui::CloseCurrentPopup(); }
+
+        // Autosaves are written in the background and rotated: the newest has the plain name.
+        ImGui::Separator();
+        ImGui::InputInt("Autosave every N steps (0 = off)", &autosave_interval, 1000, 10000);
+        ImGui::InputInt("Keep last", &autosave_keep);
+        ImGui::InputInt("Keyframe every N autosaves (1 = full saves only)", &autosave_keyframe_interval);
+        ImGui::InputText("Autosave file", autosave_filename_buffer, IM_ARRAYSIZE(autosave_filename_buffer));
+        autosave_interval = std::max(0, autosave_interval);
+        autosave_keep = std::max(1, autosave_keep);
+        autosave_keyframe_interval = std::max(1, autosave_keyframe_interval);
+        if (autosave_keyframe_interval > 1) {
+            ImGui::TextDisabled("Incremental: keeps the last %d keyframes and their deltas", autosave_keep);
+        }
+        if (ImGui::Button("Apply Autosave", ImVec2(0, 0))) {
+            simulation.setAutosave(autosave_interval, autosave_keep, autosave_filename_buffer, autosave_keyframe_interval);
+            ImGui::CloseCurrentPopup();
+        }
+        ImGui::EndPopup();
+    }
+
+    // Export Phylogeny Modal
+    bool export_phylogeny_open = true;
+    if (show_export_phylogeny_modal) {
+        ImGui::OpenPopup("Export Phylogeny");
+        show_export_phylogeny_modal = false;
+    }
+    if (ImGui::BeginPopupModal("Export Phylogeny", &export_phylogeny_open, ImGuiWindowFlags_AlwaysAutoResize)) {
+        if (ImGui::IsKeyPressed(ImGuiKey_Escape)) {
+            ImGui::CloseCurrentPopup();
+        }
+
+        ImGui::Text("Ancestry of all living bots (%d nodes).", snapshot.lineage_count);
+        ImGui::InputText("Filename", phylogeny_filename_buffer, IM_ARRAYSIZE(phylogeny_filename_buffer));
+        if (ImGui::Button("Newick", ImVec2(0, 0))) {
+            simulation.exportPhylogeny(phylogeny_filename_buffer, true);
+            ImGui::CloseCurrentPopup();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Binary", ImVec2(0, 0))) {
+            simulation.exportPhylogeny(phylogeny_filename_buffer, false);
+            ImGui::CloseCurrentPopup();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel", ImVec2(0, 0))) { ImGui::CloseCurrentPopup(); }
+        ImGui::EndPopup();
+    }
+
+    // Record Trajectory Modal
+    bool record_open = true;
+    if (show_record_modal) {
+        ImGui::OpenPopup("Record Trajectory");
+        show_record_modal = false;
+    }
+    if (ImGui::BeginPopupModal("Record Trajectory", &record_open, ImGuiWindowFlags_AlwaysAutoResize)) {
+        if (ImGui::IsKeyPressed(ImGuiKey_Escape)) {
+            ImGui::CloseCurrentPopup();
+        }
+
+        ImGui::Text("Records the cells while the simulation runs, for Tools > Playback.");
+        ImGui::InputText("Filename", record_filename_buffer, IM_ARRAYSIZE(record_filename_buffer));
+        ImGui::InputInt("Every N steps", &record_interval);
+        record_interval = std::max(1, record_interval);
+        if (ImGui::Button("Record", ImVec2(0, 0))) {
+            simulation.startRecording(record_filename_buffer, record_interval);
+            ImGui::CloseCurrentPopup();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel", ImVec2(0, 0))) { ImGui::CloseCurrentPopup(); }
         ImGui::EndPopup();
     }
 
@@ -285,10 +364,8 @@ void UI::drawPanels(World& world) {
 
         ImGui::InputText("Filename", save_filename_buffer, IM_ARRAYSIZE(save_filename_buffer));
         if (ImGui::Button("Load", ImVec2(0, 0))) { 
-            world.loadWorld(save_filename_buffer);
-            selected_bot = nullptr;
-            organism_root = nullptr;
-            snprintf(seed_buffer, sizeof(seed_buffer), "%u", world.getSeed());
+            simulation.loadWorld(save_filename_buffer); // Also clears the selection
+            refresh_seed_buffer = true; // Show the loaded seed once the load went through
             ImGui::CloseCurrentPopup(); 
         }
         ImGui::SameLine();
@@ -309,12 +386,8 @@ void UI::drawPanels(World& world) {
 
         ImGui::InputText("Filename", bot_filename_buffer, IM_ARRAYSIZE(bot_filename_buffer));
         if (ImGui::Button("Save", ImVec2(0, 0))) {
-            if (selected_bot) {
-                std::ofstream out(bot_filename_buffer, std::ios::binary);
-                if (out.is_open()) {
-                    selected_bot->serialize(out);
-                    out.close();
-                }
+            if (snapshot.selected_bot) {
+                snapshot.selected_bot->saveToFile(bot_filename_buffer);
             }
             ImGui::CloseCurrentPopup();
         }
@@ -336,12 +409,9 @@ void UI::drawPanels(World& world) {
 
         ImGui::InputText("Filename", bot_filename_buffer, IM_ARRAYSIZE(bot_filename_buffer));
         if (ImGui::Button("Load", ImVec2(0, 0))) {
-            std::ifstream in(bot_filename_buffer, std::ios::binary);
-            if (in.is_open()) {
-                Bot* bot = new Bot();
-                bot->deserialize(in);
+            Bot* bot = Bot::loadFromFile(bot_filename_buffer);
+            if (bot) {
                 loaded_bots.push_back({std::string(bot_filename_buffer), bot});
-                in.close();
             }
             ImGui::CloseCurrentPopup();
         }
@@ -351,12 +421,16 @@ void UI::drawPanels(World& world) {
     }
 
     // Side Panel (ImGui)
-    ImGui::SetNextWindowPos(ImVec2(WORLD_WIDTH * CELL_SIZE, TOP_PANEL_HEIGHT));
-    ImGui::SetNextWindowSize(ImVec2(SIDE_PANEL_WIDTH, WORLD_HEIGHT * CELL_SIZE));
+    // The panels follow the window size; the world viewport takes the remaining space.
+    const float screen_width = (float)GetScreenWidth();
+    const float screen_height = (float)GetScreenHeight();
+    ImGui::SetNextWindowPos(ImVec2(screen_width - SIDE_PANEL_WIDTH, TOP_PANEL_HEIGHT));
+    ImGui::SetNextWindowSize(ImVec2(SIDE_PANEL_WIDTH, screen_height - TOP_PANEL_HEIGHT - BOTTOM_PANEL_HEIGHT));
     ImGui::Begin("Inspector", nullptr, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse);
     
     // Dynamic content: The UI changes immediately based on whether a bot is selected.
-    Bot* inspector_bot = selected_bot ? selected_bot : selected_loaded_bot;
+    const Bot* selected_bot = snapshot.selected_bot ? &*snapshot.selected_bot : nullptr;
+    const Bot* inspector_bot = selected_bot ? selected_bot : selected_loaded_bot;
     if (inspector_bot != nullptr) {
         if (selected_bot) ImGui::TextColored(ImVec4(1, 1, 0, 1), "SELECTED BOT");
         else ImGui::TextColored(ImVec4(0, 1, 1, 1), "LOADED BOT (Placement Mode)");
@@ -375,14 +449,20 @@ void UI::drawPanels(World& world) {
         ImGui::ColorEdit3("Color", color, ImGuiColorEditFlags_NoInputs | ImGuiColorEditFlags_NoPicker);
 
         ImGui::Text("Age: %d", inspector_bot->getAge());
+        ImGui::Text("Lineage: #%llu (parent #%llu)", (unsigned long long)inspector_bot->getLineageId(), (unsigned long long)inspector_bot->getParentId());
+        ImGui::Text("Mutations: %d", inspector_bot->getMutationCount());
+        if (!inspector_bot->isOrganic) {
+            ImGui::Text("Reachable code: %d of %d genes%s", inspector_bot->getControlFlow().reachable,
+                        inspector_bot->getGenomeSize(), inspector_bot->isInert() ? " (inert)" : "");
+        }
 
         ImGui::Separator();
         ImGui::Text("Memory Stack");
         if (ImGui::BeginChild("MemoryStack", ImVec2(0, 100), true)) {
-            const std::stack<unsigned int> memory = inspector_bot->getMemory();
+            const std::vector<unsigned int>& memory = inspector_bot->getMemory();
             // Display from top to bottom
-            for (int i = 0; i < (int)memory.size(); ++i) {
-                ImGui::Text("%02d: %u", (int)memory.size() - 1 - i, memory.top());
+            for (int i = (int)memory.size() - 1; i >= 0; --i) {
+                ImGui::Text("%02d: %u", i, memory[i]);
             }
         }
         ImGui::EndChild();
@@ -390,30 +470,11 @@ void UI::drawPanels(World& world) {
         ImGui::Separator();
         ImGui::Text("Genome");
         if (ImGui::BeginChild("GenomeView", ImVec2(0, 150), true)) {
-            const std::vector<unsigned int>& genome = inspector_bot->getGenome();
+            const std::vector<uint8_t>& genome = inspector_bot->getGenome();
             unsigned int pc = inspector_bot->getPC();
             for (size_t i = 0; i < genome.size(); ++i) {
                 unsigned int val = genome[i];
-                const char* instr = "JUMP";
-                switch(val) {
-                    case MOVE: instr = "MOVE"; break;
-                    case TURN: instr = "TURN"; break;
-                    case LOOK: instr = "LOOK"; break;
-                    case ATTACK: instr = "ATTACK"; break;
-                    case PHOTOSYNTHIZE: instr = "PHOTO"; break;
-                    case CHECK_RELATIVE: instr = "RELAT"; break;
-                    case SHARE_ENERGY: instr = "SHARE"; break;
-                    case CONSUME_ORGANIC: instr = "EAT"; break;
-                    case REPRODUCE: instr = "REPRO"; break;
-                    case CHECK_BIOME: instr = "BIOME"; break;
-                    case CHECK_X: instr = "CH_X"; break;
-                    case CHECK_Y: instr = "CH_Y"; break;
-                    case CHECK_ENERGY: instr = "CH_NRG"; break;
-                    case CHECK_AGE: instr = "CH_AGE"; break;
-                    case JUMP_IF_EQUAL: instr = "JE"; break;
-                    case JUMP_IF_NOT_EQUAL: instr = "JNE"; break;
-                    case JUMP_IF_GREATER: instr = "JG"; break;
-                }
+                const char* instr = getInstructionInfo(val).mnemonic;
 
                 if (i == pc) {
                     ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "> %02zu: %s (%u)", i, instr, val);
@@ -427,29 +488,25 @@ void UI::drawPanels(World& world) {
         ImGui::Separator();
         if (selected_bot && !inspector_bot->isOrganic) {
             if (is_scanning_relatives) {
+                ImGui::Text("Relatives: %d", (int)snapshot.outlined_cells.size());
                 if (ImGui::Button("Hide Relatives", ImVec2(-1, 0))) {
                     is_scanning_relatives = false;
-                    highlighted_relatives.clear();
-                    scan_origin_bot = nullptr;
+                    simulation.hideRelatives();
                 }
             } else {
                 if (ImGui::Button("Find Relatives", ImVec2(-1, 0))) {
-                    // The logic for finding relatives is already here, just reusing it.
+                    // The scan runs once on the simulation thread; newborn relatives are highlighted as they appear.
                     is_scanning_relatives = true;
-                    scan_origin_bot = selected_bot;
-                    highlighted_relatives.clear();
-                    const auto& all_bots = world.getBots();
-                    for (Bot* other_bot : all_bots) {
-                        if (other_bot != scan_origin_bot && !other_bot->is_dead && !other_bot->isOrganic) {
-                            if (scan_origin_bot->genomeDifference(*other_bot) < 5) {
-                                highlighted_relatives.push_back(other_bot);
-                            }
-                        }
-                    }
+                    simulation.findRelatives();
                 }
             }
             if (ImGui::Button("Analyze Genome (G)", ImVec2(-1, 0))) {
-                genome_analyzer.analyze(selected_bot);
+                genome_analyzer.analyze(*selected_bot);
+            }
+        } else if (!selected_bot && !inspector_bot->isOrganic) {
+            // Loaded bots can be analyzed (and scored with a survival estimate) without placing them.
+            if (ImGui::Button("Analyze Genome", ImVec2(-1, 0))) {
+                genome_analyzer.analyze(*inspector_bot);
             }
         }
     }
@@ -459,24 +516,44 @@ void UI::drawPanels(World& world) {
     ImGui::End();
 
     // Bottom Panel (ImGui)
-    ImGui::SetNextWindowPos(ImVec2(0, TOP_PANEL_HEIGHT + WORLD_HEIGHT * CELL_SIZE));
-    ImGui::SetNextWindowSize(ImVec2(WORLD_WIDTH * CELL_SIZE + SIDE_PANEL_WIDTH, BOTTOM_PANEL_HEIGHT));
+    ImGui::SetNextWindowPos(ImVec2(0, screen_height - BOTTOM_PANEL_HEIGHT));
+    ImGui::SetNextWindowSize(ImVec2(screen_width, BOTTOM_PANEL_HEIGHT));
     ImGui::Begin("Controls", nullptr, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoTitleBar);
     
     // Stats
-    ImGui::Text("Bots: %d", world.getBotsSize());
+    ImGui::Text("Bots: %d", snapshot.bot_count);
+    ImGui::SameLine(0.0f, 30.0f);
+    ImGui::Text("Genomes: %d", snapshot.genome_count);
     ImGui::SameLine(0.0f, 30.0f);
-    ImGui::Text("Step: %lld", world.getStepCount());
+    ImGui::Text("Step: %lld", snapshot.step_count);
+    ImGui::SameLine(0.0f, 30.0f);
+    ImGui::Text("Steps/s: %.0f%s", snapshot.steps_per_second, simulation.getTargetRate() == 0 ? " (turbo)" : "");
     ImGui::SameLine(0.0f, 30.0f);
     ImGui::Text("FPS: %d", GetFPS());
+    if (simulation.isSaving()) {
+        ImGui::SameLine(0.0f, 30.0f);
+        ImGui::Text("Saving...");
+    }
+    if (simulation.isRecording()) {
+        ImGui::SameLine(0.0f, 30.0f);
+        if (simulation.hasRecordingFailed()) {
+            ImGui::Text("Recording failed");
+        } else if (simulation.getSkippedFrameCount() > 0) {
+            ImGui::Text("Recording (%lld frames, %lld skipped)", simulation.getRecordedFrameCount(), simulation.getSkippedFrameCount());
+        } else {
+            ImGui::Text("Recording (%lld frames)", simulation.getRecordedFrameCount());
+        }
+    }
+    if (player.isOpen()) {
+        ImGui::SameLine(0.0f, 30.0f);
+        ImGui::Text("Playback");
+    }
 
     ImGui::SameLine(0.0f, 60.0f);
     // ImGui::Button returns true only on the frame it is clicked.
-    ImGui::BeginDisabled(is_scanning_relatives);
-    if (ImGui::Button((is_paused || is_scanning_relatives) ? "Resume (Space)" : "Pause (Space)")) {
+    if (ImGui::Button(is_paused ? "Resume (Space)" : "Pause (Space)")) {
         is_paused = !is_paused;
     }
-    ImGui::EndDisabled();
 
     // Radio buttons for switching view modes. They update 'current_view_mode' directly.
     ImGui::SameLine(0.0f, 60.0f);
@@ -488,6 +565,21 @@ void UI::drawPanels(World& world) {
 
     ImGui::End();
 
+    if (show_census_window) {
+        _drawCensusWindow(simulation, snapshot);
+    }
+    if (bank_busy && simulation.takeBank(bank, bank_status)) {
+        bank_busy = false;
+    }
+    if (show_bank_window) {
+        _drawBankWindow(simulation, snapshot);
+    }
+    if (show_playback_window) {
+        _drawPlaybackWindow();
+    } else if (player.isOpen()) {
+        player.close(); // The window was closed: back to the live world
+    }
+
     // Draw the genome analyzer window if it's open
     if (genome_analyzer.isOpen()) {
         ImGui::SetNextWindowPos(ImVec2(0,0));
@@ -499,3 +591,243 @@ void UI::drawPanels(World& world) {
     }
     genome_analyzer.draw();
 }
+
+void UI::_plotCensus(const char* label, const std::vector<CensusSample>& samples, float (*value)(const CensusSample&)) {
+    plot_values.clear();
+    for (const CensusSample& sample : samples) {
+        plot_values.push_back(value(sample));
+    }
+    char overlay[64] = "";
+    if (!plot_values.empty()) snprintf(overlay, sizeof(overlay), "%.1f", plot_values.back());
+    ImGui::PlotLines(label, plot_values.data(), (int)plot_values.size(), 0, overlay, 3.4e38f, 3.4e38f, ImVec2(0, 50));
+}
+
+void UI::_drawCensusWindow(Simulation& simulation, const RenderSnapshot& snapshot) {
+    ImGui::SetNextWindowSize(ImVec2(420, 560), ImGuiCond_FirstUseEver);
+    if (ImGui::Begin("Census", &show_census_window)) {
+        const CensusSample& now = snapshot.census;
+        ImGui::Text("Bots: %d  Organic: %d  Mean energy: %.1f", now.bots, now.organic, now.mean_energy);
+        ImGui::Text("Diet: %d photosynthesis, %d hunting, %d scavenging, %d neutral",
+                    now.diet[DIET_PHOTOSYNTHESIS], now.diet[DIET_HUNTING], now.diet[DIET_SCAVENGING], now.diet[DIET_NEUTRAL]);
+        ImGui::Text("Biomes: %d sunny, %d balanced, %d dark", now.biome[0], now.biome[1], now.biome[2]);
+        ImGui::Text("Clades: %d (largest %d)  Genomes: %d", now.clades, now.largest_clade, now.genomes);
+        ImGui::Text("Inert: %d (stuck in action-free loops)", now.inert);
+        ImGui::Separator();
+
+        if (ImGui::RadioButton("Recent steps", !census_show_history)) census_show_history = false;
+        ImGui::SameLine();
+        if (ImGui::RadioButton("Whole run", census_show_history)) census_show_history = true;
+        const std::vector<CensusSample>& samples = census_show_history ? snapshot.census_history : snapshot.census_recent;
+        if (!samples.empty()) {
+            ImGui::Text("Steps %lld - %lld", samples.front().step, samples.back().step);
+        }
+
+        _plotCensus("Bots", samples, [](const CensusSample& s) { return (float)s.bots; });
+        _plotCensus("Mean energy", samples, [](const CensusSample& s) { return s.mean_energy; });
+        _plotCensus("Photosynthesis", samples, [](const CensusSample& s) { return (float)s.diet[DIET_PHOTOSYNTHESIS]; });
+        _plotCensus("Hunting", samples, [](const CensusSample& s) { return (float)s.diet[DIET_HUNTING]; });
+        _plotCensus("Scavenging", samples, [](const CensusSample& s) { return (float)s.diet[DIET_SCAVENGING]; });
+        _plotCensus("Sunny biome", samples, [](const CensusSample& s) { return (float)s.biome[0]; });
+        _plotCensus("Balanced biome", samples, [](const CensusSample& s) { return (float)s.biome[1]; });
+        _plotCensus("Dark biome", samples, [](const CensusSample& s) { return (float)s.biome[2]; });
+        _plotCensus("Clades", samples, [](const CensusSample& s) { return (float)s.clades; });
+        _plotCensus("Genomes", samples, [](const CensusSample& s) { return (float)s.genomes; });
+        _plotCensus("Inert", samples, [](const CensusSample& s) { return (float)s.inert; });
+
+        ImGui::Separator();
+        ImGui::InputText("Filename", census_filename_buffer, IM_ARRAYSIZE(census_filename_buffer));
+        ImGui::SameLine();
+        if (ImGui::Button("Export CSV")) {
+            simulation.exportCensus(census_filename_buffer);
+        }
+    }
+    ImGui::End();
+}
+
+const RenderSnapshot& UI::updatePlayback() {
+    if (playback_running) {
+        playback_position += GetFrameTime() * playback_speed;
+        if (playback_position >= player.getFrameCount() - 1) {
+            playback_position = player.getFrameCount() - 1;
+            playback_running = false;
+        }
+    }
+    int frame = (int)playback_position;
+    if (frame == player.getCurrentFrame() && current_view_mode == playback_view_mode) return playback_snapshot;
+    if (!player.seek(frame)) {
+        playback_running = false; // Damaged: stay on the last good frame
+        return playback_snapshot;
+    }
+
+    const int cell_count = player.getWidth() * player.getHeight();
+    const uint8_t* cells = player.getCells();
+    playback_snapshot.generation = --playback_generation;
+    playback_snapshot.width = player.getWidth();
+    playback_snapshot.height = player.getHeight();
+    playback_snapshot.pixels.resize(cell_count);
+    renderTrajectoryFrame(cells, player.getWidth(), player.getHeight(), current_view_mode, playback_snapshot.pixels.data());
+    playback_snapshot.step_count = player.getStep(frame);
+    playback_snapshot.bot_count = 0;
+    for (int cell = 0; cell < cell_count; cell++) {
+        playback_snapshot.bot_count += (cells[cell] & 3) == TRAJECTORY_LIVING;
+    }
+    playback_view_mode = current_view_mode;
+    return playback_snapshot;
+}
+
+void UI::_drawPlaybackWindow() {
+    ImGui::SetNextWindowSize(ImVec2(420, 200), ImGuiCond_FirstUseEver);
+    if (ImGui::Begin("Playback", &show_playback_window)) {
+        ImGui::InputText("Filename", playback_filename_buffer, IM_ARRAYSIZE(playback_filename_buffer));
+        ImGui::SameLine();
+        if (ImGui::Button("Open")) {
+            player.open(playback_filename_buffer);
+            playback_position = 0.0;
+            playback_running = false;
+            playback_view_mode = -1;
+        }
+        if (!player.isOpen()) {
+            ImGui::TextDisabled("No trajectory open.");
+        } else if (player.getFrameCount() == 0) {
+            ImGui::TextDisabled("The trajectory has no complete frames.");
+        } else {
+            // Scrubbing seeks from the nearest keyframe, so any frame shows up at once.
+            const int last = player.getFrameCount() - 1;
+            int frame = (int)playback_position;
+            if (ImGui::SliderInt("Frame", &frame, 0, last)) playback_position = frame;
+            ImGui::Text("Step %lld (frame %d of %d)", player.getStep(frame), frame + 1, last + 1);
+            if (ImGui::Button("|<")) playback_position = 0.0;
+            ImGui::SameLine();
+            if (ImGui::Button("<")) playback_position = std::max(0, frame - 1);
+            ImGui::SameLine();
+            if (ImGui::Button(playback_running ? "Pause" : "Play")) {
+                if (!playback_running && frame == last) playback_position = 0.0; // Replay from the start
+                playback_running = !playback_running;
+            }
+            ImGui::SameLine();
+            if (ImGui::Button(">")) playback_position = std::min(last, frame + 1);
+            ImGui::SameLine();
+            if (ImGui::Button(">|")) playback_position = last;
+            ImGui::SliderFloat("Frames/s", &playback_speed, 1.0f, 1000.0f, "%.0f", ImGuiSliderFlags_Logarithmic);
+            if (ImGui::Button("Close")) player.close();
+        }
+    }
+    ImGui::End();
+}
+
+void UI::_onBankChanged() {
+    // Entries are stored by value, so adding some may move the selected one.
+    if (selected_bank_entry >= 0) {
+        selected_loaded_bot = nullptr;
+        selected_bank_entry = -1;
+    }
+    bank_filtered = false;
+    bank_matches.clear();
+}
+
+GenomeBank UI::_lendBank() {
+    _onBankChanged(); // The simulation thread may change it meanwhile
+    bank_busy = true;
+    return std::move(bank);
+}
+
+// The genome bank: loading, importing and saving it, searching it and seeding from it.
+void UI::_drawBankWindow(Simulation& simulation, const RenderSnapshot& snapshot) {
+    ImGui::SetNextWindowSize(ImVec2(460, 520), ImGuiCond_FirstUseEver);
+    if (ImGui::Begin("Genome Bank", &show_bank_window)) {
+        ImGui::InputText("Bank file", bank_filename_buffer, IM_ARRAYSIZE(bank_filename_buffer));
+        // Loading, saving, importing and banking the living bots run on the simulation thread,
+        // which has the bank until draw() takes it back.
+        ImGui::BeginDisabled(bank_busy);
+        if (ImGui::Button("Load")) simulation.loadBank(_lendBank(), bank_filename_buffer);
+        ImGui::SameLine();
+        if (ImGui::Button("Save")) simulation.saveBank(_lendBank(), bank_filename_buffer);
+        ImGui::SameLine();
+        if (ImGui::Button("Clear")) {
+            bank.clear();
+            bank_status.clear();
+            _onBankChanged();
+        }
+        ImGui::InputText("Bot files", bank_import_buffer, IM_ARRAYSIZE(bank_import_buffer));
+        ImGui::SameLine();
+        if (ImGui::Button("Import")) simulation.importBotFiles(_lendBank(), bank_import_buffer);
+        if (ImGui::Button("Bank Living Bots")) simulation.bankLivingBots(_lendBank());
+        ImGui::SameLine();
+        ImGui::BeginDisabled(!snapshot.selected_bot || snapshot.selected_bot->isOrganic);
+        if (ImGui::Button("Bank Selected Bot")) {
+            bank.add(*snapshot.selected_bot, "seed " + std::to_string(snapshot.seed), snapshot.step_count);
+            _onBankChanged();
+        }
+        ImGui::EndDisabled();
+        ImGui::EndDisabled();
+        if (bank_busy) {
+            ImGui::TextDisabled("Working...");
+            ImGui::End();
+            return;
+        }
+        if (!bank_status.empty()) ImGui::TextDisabled("%s", bank_status.c_str());
+        ImGui::Separator();
+
+        ImGui::Text("%d genomes from %d sources", bank.size(), (int)bank.getSources().size());
+        ImGui::BeginDisabled(bank.size() == 0);
+        ImGui::SetNextItemWidth(120);
+        ImGui::InputInt("Bots", &bank_seed_count, 10, 100);
+        bank_seed_count = std::clamp(bank_seed_count, 1, 1000000);
+        ImGui::SameLine();
+        if (ImGui::Button("Seed World")) simulation.spawnCopies(bank.getBots(), bank_seed_count);
+        ImGui::SameLine();
+        if (ImGui::Button("Use as Analyzer Neighbors")) {
+            genome_analyzer.setNeighborPool(std::make_shared<const std::vector<Bot>>(bank.getBots()));
+        }
+        ImGui::EndDisabled();
+
+        // Similarity search against the bot in the inspector.
+        const Bot* reference = snapshot.selected_bot ? &*snapshot.selected_bot : selected_loaded_bot;
+        ImGui::SetNextItemWidth(120);
+        ImGui::SliderInt("Max distance", &bank_max_distance, 0, 64);
+        ImGui::SameLine();
+        ImGui::BeginDisabled(!reference || reference->isOrganic);
+        if (ImGui::Button("Find Similar")) {
+            bank_matches.clear();
+            bank.findWithin(reference->getGenome(), bank_max_distance, bank_matches);
+            bank_filtered = true;
+        }
+        ImGui::EndDisabled();
+        if (bank_filtered) {
+            ImGui::SameLine();
+            if (ImGui::Button("Show All")) bank_filtered = false;
+            ImGui::Text("%d similar genomes", (int)bank_matches.size());
+        }
+
+        // Clicking an entry selects it for placement, like a loaded bot.
+        int rows = bank_filtered ? (int)bank_matches.size() : bank.size();
+        ImGui::BeginChild("BankEntries", ImVec2(0, 0), true);
+        ImGuiListClipper clipper;
+        clipper.Begin(rows);
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                int index = bank_filtered ? bank_matches[row] : row;
+                const GenomeBank::Entry& entry = bank.getEntry(index);
+                const Bot& bot = bank.getBot(index);
+                Color color = bot.getColor();
+                ImGui::ColorButton("##Color", ImVec4(color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, 1.0f),
+                                   ImGuiColorEditFlags_NoTooltip, ImVec2(12, 12));
+                ImGui::SameLine();
+                std::string label = std::to_string(bot.getGenomeSize()) + " genes  x" + std::to_string(entry.count) + "  " +
+                                    bank.getSources()[entry.source] + " @" + std::to_string(entry.step) +
+                                    "##" + std::to_string(index);
+                if (ImGui::Selectable(label.c_str(), selected_bank_entry == index)) {
+                    selected_bank_entry = index;
+                    selected_loaded_bot = &bot;
+                    simulation.deselect();
+                }
+                if (entry.lineage_id != 0 && ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("Lineage %llu, clade %llu", (unsigned long long)entry.lineage_id,
+                                      (unsigned long long)entry.founder_id);
+                }
+            }
+        }
+        ImGui::EndChild();
+    }
+    ImGui::End();
+}
@@ -1,6 +1,9 @@
 #pragma once
 #include "raylib.h"
 #include "world.h"
+#include "simulation.h"
+#include "trajectory.h"
+#include "viewport.h"
 #include "imgui.h"
 #include "GenomeAnalyzer.h"
 #include "config.h"
@@ -9,36 +12,36 @@
 // It bridges the gap between the simulation state (World/Bot) and the user.
 // Note: Input handling here is for selecting entities in the world; 
 // ImGui handles its own input (buttons, sliders) internally within the draw() method.
+// The UI only reads the RenderSnapshot published by the Simulation; anything that changes
+// the world is sent to the simulation thread as a command.
 class UI {
 public:
     UI();
     ~UI();
-    void handleInput(World& world);
-    void drawWorldOverlay() const;
-    void drawPanels(const World& world);
-    void update();
-    void drawPanels(World& world);
+    void handleInput(Simulation& simulation, const RenderSnapshot& snapshot, Viewport& viewport);
+    void drawWorldOverlay(const RenderSnapshot& snapshot, const Viewport& viewport) const;
+    void drawPanels(Simulation& simulation, const RenderSnapshot& snapshot);
     bool isPaused() const; // Note: isPaused() is now const
     int getViewMode() const;
-    Bot* getOrganismRoot() const;
-    int getSpeedDivisor() const;
+
+    // While a trajectory is open for playback, main draws its frames instead of the live
+    // world (and the simulation stays paused). updatePlayback() advances it by a frame's time.
+    bool isPlayingBack() const { return player.isOpen() && player.getFrameCount() > 0; }
+    const RenderSnapshot& updatePlayback();
 
     bool isScanningRelatives() const;
-    const std::vector<Bot*>& getHighlightedRelatives() const;
     void closeAllModals();
 
 private:
     // State
     bool is_paused = false; // Main simulation pause
     int current_view_mode = 2; // 1: Nutrition, 2: Species Color
-    Bot* selected_bot = nullptr;
-    Bot* organism_root = nullptr;
-    int speed_divisor = 1;
+    int target_rate = 60; // Steps per second used when turbo mode is off
 
-    // Relative scanning state
+    // Relative scanning state (mirrors the latest snapshot)
     bool is_scanning_relatives = false;
-    std::vector<Bot*> highlighted_relatives;
-    Bot* scan_origin_bot = nullptr;
+    unsigned int last_seen_seed = 0;
+    bool refresh_seed_buffer = false;
 
     // Top panel state
     char seed_buffer[128] = "";
@@ -51,6 +54,35 @@ private:
     bool show_save_world_modal = false;
     bool show_load_world_modal = false;
     char save_filename_buffer[128] = "world.save";
+    int autosave_interval = 0; // Steps between autosaves, 0 = off
+    int autosave_keep = 3;
+    int autosave_keyframe_interval = 1; // Autosaves per keyframe, 1 = full saves only
+    char autosave_filename_buffer[128] = "autosave.save";
+    bool show_export_phylogeny_modal = false;
+    char phylogeny_filename_buffer[128] = "phylogeny.nwk";
+
+    // Census window state
+    bool show_census_window = false;
+    bool census_show_history = false; // Whole run instead of the recent steps
+    char census_filename_buffer[128] = "census.csv";
+    std::vector<float> plot_values;
+    void _drawCensusWindow(Simulation& simulation, const RenderSnapshot& snapshot);
+    void _plotCensus(const char* label, const std::vector<CensusSample>& samples, float (*value)(const CensusSample&));
+
+    // Trajectory recording and playback
+    bool show_record_modal = false;
+    char record_filename_buffer[128] = "world.traj";
+    int record_interval = TRAJECTORY_DEFAULT_INTERVAL; // Steps between frames
+    bool show_playback_window = false;
+    char playback_filename_buffer[128] = "world.traj";
+    TrajectoryPlayer player;
+    bool playback_running = false;
+    float playback_speed = 30.0f; // Frames per second
+    double playback_position = 0.0; // Frame, with the fraction played so far
+    int playback_view_mode = -1; // Of the rendered frame
+    long long playback_generation = -1; // Counts down, so it never matches a live snapshot
+    RenderSnapshot playback_snapshot;
+    void _drawPlaybackWindow();
 
     // Bot management state
     struct LoadedBotInfo {
@@ -58,11 +90,27 @@ private:
         Bot* bot;
     };
     std::vector<LoadedBotInfo> loaded_bots;
-    Bot* selected_loaded_bot = nullptr;
+    const Bot* selected_loaded_bot = nullptr; // A loaded bot or a bank entry, placed by clicking
+    int selected_bank_entry = -1;
     bool show_save_bot_modal = false;
     bool show_load_bot_modal = false;
     char bot_filename_buffer[128] = "bot.save";
 
+    // Genome bank window
+    bool show_bank_window = false;
+    GenomeBank bank;
+    bool bank_busy = false; // A bank command has the bank, see Simulation::takeBank()
+    char bank_filename_buffer[128] = "genomes.bank";
+    char bank_import_buffer[128] = "bots";
+    std::string bank_status;
+    bool bank_filtered = false; // The list only shows bank_matches
+    std::vector<int> bank_matches;
+    int bank_max_distance = 8;
+    int bank_seed_count = 100;
+    void _drawBankWindow(Simulation& simulation, const RenderSnapshot& snapshot);
+    void _onBankChanged(); // Entries moved: drops the selection and the filter
+    GenomeBank _lendBank(); // To a bank command, draw() takes it back
+
     // Analysis tools
     GenomeAnalyzer genome_analyzer;
 };
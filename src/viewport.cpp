@@ -0,0 +1,100 @@
+#include "viewport.h"
+#include <algorithm>
+#include <cmath>
+
+void Viewport::setScreenRect(Rectangle rect) {
+    screen_rect = rect;
+    _clampTarget();
+}
+
+void Viewport::setWorldSize(int width, int height) {
+    if (width == world_width && height == world_height) return;
+    world_width = width;
+    world_height = height;
+    fit();
+}
+
+// Shows the whole world, but never zooms in further than the classic CELL_SIZE pixels per cell.
+void Viewport::fit() {
+    zoom = std::min((float)CELL_SIZE, _fitZoom());
+    target = {0, 0};
+    _clampTarget();
+}
+
+float Viewport::_fitZoom() const {
+    if (world_width <= 0 || world_height <= 0) return CELL_SIZE;
+    return std::min(screen_rect.width / world_width, screen_rect.height / world_height);
+}
+
+void Viewport::handleInput(bool mouse_captured, bool keyboard_captured) {
+    Vector2 mouse = GetMousePosition();
+    if (!mouse_captured && containsScreenPoint(mouse)) {
+        float wheel = GetMouseWheelMove();
+        if (wheel != 0.0f) {
+            _zoomAround(mouse, zoom * std::pow(1.25f, wheel));
+        }
+        if (IsMouseButtonDown(MOUSE_MIDDLE_BUTTON)) {
+            Vector2 delta = GetMouseDelta();
+            target.x -= delta.x / zoom;
+            target.y -= delta.y / zoom;
+            _clampTarget();
+        }
+    }
+
+    if (!keyboard_captured) {
+        float pan = 600.0f * GetFrameTime() / zoom; // 600 screen pixels per second
+        if (IsKeyDown(KEY_LEFT)) target.x -= pan;
+        if (IsKeyDown(KEY_RIGHT)) target.x += pan;
+        if (IsKeyDown(KEY_UP)) target.y -= pan;
+        if (IsKeyDown(KEY_DOWN)) target.y += pan;
+        if (IsKeyPressed(KEY_HOME)) fit();
+        _clampTarget();
+    }
+}
+
+void Viewport::_zoomAround(Vector2 screen_point, float new_zoom) {
+    // Allow zooming out a bit past "fit" (but not below the LOD floor) and in up to 64 px per cell.
+    float min_zoom = std::max(1.0f / 64.0f, std::min((float)CELL_SIZE, _fitZoom() * 0.5f));
+    new_zoom = std::clamp(new_zoom, min_zoom, 64.0f);
+    Vector2 anchor = screenToCell(screen_point); // Keep the cell under the cursor in place
+    zoom = new_zoom;
+    target.x = anchor.x - (screen_point.x - screen_rect.x) / zoom;
+    target.y = anchor.y - (screen_point.y - screen_rect.y) / zoom;
+    _clampTarget();
+}
+
+// Keeps at least half of the view over the world, and centers worlds smaller than the view.
+void Viewport::_clampTarget() {
+    float view_w = screen_rect.width / zoom;
+    float view_h = screen_rect.height / zoom;
+    if (view_w >= world_width) target.x = (world_width - view_w) * 0.5f;
+    else target.x = std::clamp(target.x, -view_w * 0.5f, world_width - view_w * 0.5f);
+    if (view_h >= world_height) target.y = (world_height - view_h) * 0.5f;
+    else target.y = std::clamp(target.y, -view_h * 0.5f, world_height - view_h * 0.5f);
+}
+
+bool Viewport::containsScreenPoint(Vector2 point) const {
+    return point.x >= screen_rect.x && point.x < screen_rect.x + screen_rect.width &&
+           point.y >= screen_rect.y && point.y < screen_rect.y + screen_rect.height;
+}
+
+Vector2 Viewport::screenToCell(Vector2 point) const {
+    return { target.x + (point.x - screen_rect.x) / zoom, target.y + (point.y - screen_rect.y) / zoom };
+}
+
+Vector2 Viewport::cellToScreen(Vector2 cell) const {
+    return { screen_rect.x + (cell.x - target.x) * zoom, screen_rect.y + (cell.y - target.y) * zoom };
+}
+
+Rectangle Viewport::cellRectToScreen(Rectangle cells) const {
+    Vector2 top_left = cellToScreen({cells.x, cells.y});
+    return { top_left.x, top_left.y, cells.width * zoom, cells.height * zoom };
+}
+
+Rectangle Viewport::getVisibleCells() const {
+    float x0 = std::max(0.0f, std::floor(target.x));
+    float y0 = std::max(0.0f, std::floor(target.y));
+    float x1 = std::min((float)world_width, std::ceil(target.x + screen_rect.width / zoom));
+    float y1 = std::min((float)world_height, std::ceil(target.y + screen_rect.height / zoom));
+    return { x0, y0, std::max(0.0f, x1 - x0), std::max(0.0f, y1 - y0) };
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "raylib.h"
+#include "config.h"
+
+// The Viewport maps world cells onto a rectangle of the window, with zoom and pan.
+// Zoom is expressed in screen pixels per cell; below one pixel per cell the renderer
+// switches to aggregated level-of-detail tiles.
+// Controls: mouse wheel zooms around the cursor, middle mouse button drags,
+// arrow keys pan and Home fits the whole world into the view.
+class Viewport {
+public:
+    void setScreenRect(Rectangle rect);
+    void setWorldSize(int width, int height); // Refits the view when the size changes
+    void handleInput(bool mouse_captured, bool keyboard_captured);
+    void fit();
+
+    Rectangle getScreenRect() const { return screen_rect; }
+    float getZoom() const { return zoom; }
+    bool containsScreenPoint(Vector2 point) const;
+    Vector2 screenToCell(Vector2 point) const; // Fractional cell coordinates
+    Vector2 cellToScreen(Vector2 cell) const;
+    Rectangle cellRectToScreen(Rectangle cells) const;
+    // The range of cells that intersects the view, clamped to the world (whole cells).
+    Rectangle getVisibleCells() const;
+
+private:
+    void _zoomAround(Vector2 screen_point, float new_zoom);
+    void _clampTarget();
+    float _fitZoom() const;
+
+    Rectangle screen_rect = {0, 0, 1, 1};
+    int world_width = 0;
+    int world_height = 0;
+    float zoom = CELL_SIZE;
+    Vector2 target = {0, 0}; // Cell coordinate shown at the top-left corner of screen_rect
+};
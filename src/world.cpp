@@ -1,8 +1,9 @@
 #include <world.h>
 #include <algorithm>
 #include <stdexcept>
-#include <fstream>
 #include "config.h"
+#include "save_format.h"
+#include "trajectory.h"
 
 World::World() : World(WORLD_WIDTH, WORLD_HEIGHT) {}
 
@@ -16,20 +17,20 @@ World::World(int width, int height) : world_width(width), world_height(height) {
 void World::newWorld(unsigned int seed, int initial_bot_count) {
     clear();
     this->seed = seed;
-    SetRandomSeed(seed);
+    this->random.seed(seed);
     spawnInitialBots(initial_bot_count);
 }
 
 void World::spawnInitialBots(int count) {
     for (int i = 0; i < count; i++) {
-        Bot* bot = new Bot();
+        Bot* bot = new Bot(this->random);
         Vector2 spawn_pos = {-1, -1};
         int attempts = 0;
         const int max_attempts = world_width * world_height;
 
         // Find a random empty cell for the new bot
         do {
-            spawn_pos = {(float)GetRandomValue(0, world_width - 1), (float)GetRandomValue(0, world_height - 1)};
+            spawn_pos = {(float)this->random.next(0, world_width - 1), (float)this->random.next(0, world_height - 1)};
             if (attempts++ > max_attempts) {
                 delete bot; // Clean up memory
                 throw std::runtime_error("Could not find an empty cell to spawn a new bot.");
@@ -41,21 +42,143 @@ void World::spawnInitialBots(int count) {
     }
 }
 
+int World::spawnCopies(const std::vector<Bot>& prototypes, int count) {
+    if (prototypes.empty()) return 0;
+    std::vector<Vector2> empty_cells;
+    for (int x = 0; x < world_width; x++) {
+        for (int y = 0; y < world_height; y++) {
+            if (this->grid[x][y] == nullptr) empty_cells.push_back({(float)x, (float)y});
+        }
+    }
+    count = std::min(count, (int)empty_cells.size());
+    for (int i = 0; i < count; i++) {
+        // A partial Fisher-Yates shuffle: every cell is drawn at most once.
+        int j = this->random.next(i, (int)empty_cells.size() - 1);
+        std::swap(empty_cells[i], empty_cells[j]);
+        Bot* bot = new Bot(prototypes[i % prototypes.size()]);
+        bot->resetLife();
+        bot->clearLineage();
+        bot->setPosition(empty_cells[i]);
+        addBot(bot);
+    }
+    return count;
+}
+
 void World::addBot(Bot *bot_ptr) {
+    bot_ptr->setLineageId(this->phylogeny.addBirth(bot_ptr->getParentId(), this->step_count, bot_ptr->getMutationCount()));
+    _insertBot(bot_ptr);
+}
+
+void World::_insertBot(Bot* bot_ptr) {
+    bot_ptr->is_relative = this->showing_relatives && !bot_ptr->isOrganic &&
+        Bot::areRelatives(this->relative_genome, bot_ptr->getGenome());
+    bot_ptr->census_record = CensusRecord(); // Copies of counted bots start uncounted
+    if (!bot_ptr->isOrganic) {
+        this->genome_index.add(bot_ptr);
+        this->census.addBot(*bot_ptr);
+    } else {
+        this->census.addOrganic();
+    }
     this->bots.push_back(bot_ptr);
     this->grid[(int)bot_ptr->getPosition().x][(int)bot_ptr->getPosition().y] = bot_ptr;
+    _trackCell(bot_ptr);
 }
 
 void World::removeBot(Bot *bot_ptr) {
+    if (bot_ptr->is_dead) return;
     bot_ptr->is_dead = true;
+    if (bot_ptr->isOrganic) {
+        this->census.removeOrganic();
+    } else {
+        this->census.removeBot(*bot_ptr);
+    }
+    if (bot_ptr == this->selected_bot) this->selected_bot = nullptr;
+    this->genome_index.remove(bot_ptr);
+    this->phylogeny.recordDeath(bot_ptr->getLineageId(), this->step_count);
     this->grid[(int)bot_ptr->getPosition().x][(int)bot_ptr->getPosition().y] = nullptr;
+    _untrackCell(bot_ptr->getPosition());
+    if (this->observer && !bot_ptr->isOrganic) this->observer->onDeath(*bot_ptr);
+}
+
+void World::botBecameOrganic(Bot* bot_ptr) {
+    this->census.removeBot(*bot_ptr);
+    this->census.addOrganic();
+    this->genome_index.remove(bot_ptr);
+    this->phylogeny.recordDeath(bot_ptr->getLineageId(), this->step_count);
+    _trackCell(bot_ptr);
+    if (this->observer) this->observer->onDeath(*bot_ptr);
+}
+
+void World::botEnergyChanged(Bot* bot_ptr) {
+    _trackCell(bot_ptr);
 }
 
 void World::updateBotPosition(Bot* bot_ptr, Vector2 old_pos) {
-    if (old_pos.x >= 0 && old_pos.x < world_width && old_pos.y >= 0 && old_pos.y < world_height)
+    if (old_pos.x >= 0 && old_pos.x < world_width && old_pos.y >= 0 && old_pos.y < world_height) {
         this->grid[(int)old_pos.x][(int)old_pos.y] = nullptr;
-    if (bot_ptr->getPosition().x >= 0 && bot_ptr->getPosition().x < world_width && bot_ptr->getPosition().y >= 0 && bot_ptr->getPosition().y < world_height)
+        _untrackCell(old_pos);
+    }
+    if (bot_ptr->getPosition().x >= 0 && bot_ptr->getPosition().x < world_width && bot_ptr->getPosition().y >= 0 && bot_ptr->getPosition().y < world_height) {
         this->grid[(int)bot_ptr->getPosition().x][(int)bot_ptr->getPosition().y] = bot_ptr;
+        _trackCell(bot_ptr);
+    }
+}
+
+void World::setTrackingCells(bool tracking) {
+    if (!tracking) {
+        std::vector<uint8_t>().swap(this->tracked_cells);
+        return;
+    }
+    this->tracked_cells.resize(2 * (size_t)this->world_width * this->world_height);
+    captureTrajectoryFrame(*this, this->tracked_cells.data());
+}
+
+void World::_trackCell(const Bot* bot_ptr) {
+    if (!this->tracked_cells.empty()) captureTrajectoryCell(*bot_ptr, this->world_width, this->world_height, this->tracked_cells.data());
+}
+
+void World::_trackCellState(const Bot* bot_ptr) {
+    if (this->tracked_cells.empty()) return;
+    Vector2 position = bot_ptr->getPosition();
+    // The census has just classified its diet; asking the bot again costs mispredicted branches.
+    this->tracked_cells[(size_t)position.y * this->world_width + (size_t)position.x] =
+        trajectoryCellState(*bot_ptr, bot_ptr->census_record.diet);
+}
+
+void World::_untrackCell(Vector2 position) {
+    if (this->tracked_cells.empty()) return;
+    size_t cell = (size_t)position.y * this->world_width + (size_t)position.x;
+    this->tracked_cells[cell] = 0;
+    this->tracked_cells[(size_t)this->world_width * this->world_height + cell] = 0;
+}
+
+void World::highlightRelatives(const Bot* origin) {
+    clearRelatives();
+    if (origin == nullptr || origin->isOrganic) return;
+    this->showing_relatives = true;
+    this->relative_genome = origin->getGenome();
+    std::vector<Bot*> relatives;
+    findBotsWithin(this->relative_genome, RELATIVE_GENOME_DIFFERENCE - 1, relatives);
+    for (Bot* bot : relatives) {
+        if (bot != origin) bot->is_relative = true;
+    }
+}
+
+void World::findBotsWithin(const std::vector<uint8_t>& genome, int max_distance, std::vector<Bot*>& out) const {
+    this->genome_index.findWithin(genome, max_distance, out);
+}
+
+void World::clearRelatives() {
+    if (!this->showing_relatives) return;
+    // Only living relatives can still carry the flag (dead bots are never drawn again), and
+    // those are exactly what the index returns for the scanned genome.
+    std::vector<Bot*> relatives;
+    findBotsWithin(this->relative_genome, RELATIVE_GENOME_DIFFERENCE - 1, relatives);
+    for (Bot* bot : relatives) {
+        bot->is_relative = false;
+    }
+    this->showing_relatives = false;
+    this->relative_genome.clear();
 }
 
 const std::vector<Bot*>& World::getBots() const {
@@ -69,40 +192,58 @@ World::~World() {
     // The vector will be cleared automatically when the World object is destroyed.
 }
 
-void World::render(int view_mode, Bot* selected_bot, const std::vector<Bot*>& relatives) {
-    // --- Draw Biome Backgrounds ---
-    if (world_width == WORLD_WIDTH && world_height == WORLD_HEIGHT) { // Only for main world
-        DrawRectangle(0, 0, (world_width / 3) * CELL_SIZE, world_height * CELL_SIZE, {255, 200, 0, 40});
-        DrawRectangle((world_width / 3) * CELL_SIZE, 0, (world_width / 3) * CELL_SIZE, world_height * CELL_SIZE, {0, 255, 100, 40});
-        DrawRectangle((2 * world_width / 3) * CELL_SIZE, 0, (world_width / 3) * CELL_SIZE, world_height * CELL_SIZE, {0, 255, 255, 40});
+// Blends src over dst using src's alpha, the same way the GPU would for a DrawRectangle call.
+Color blendOver(Color dst, Color src) {
+    int a = src.a;
+    return {
+        (unsigned char)((src.r * a + dst.r * (255 - a) + 127) / 255),
+        (unsigned char)((src.g * a + dst.g * (255 - a) + 127) / 255),
+        (unsigned char)((src.b * a + dst.b * (255 - a) + 127) / 255),
+        255
+    };
+}
+
+// Writes the final color of every cell into pixels (one texel per cell, row-major,
+// world_width * world_height entries). The biome backgrounds are baked in, so the
+// result can be uploaded as an opaque texture and drawn with a single call.
+// The positions of highlighted relatives are collected into outlined_cells.
+void renderBackground(Color* pixels, int width, int height) {
+    Color background[3] = { BG_COLOR, BG_COLOR, BG_COLOR };
+    if (width == WORLD_WIDTH && height == WORLD_HEIGHT) { // Only for main world
+        background[0] = blendOver(BG_COLOR, {255, 200, 0, 40});
+        background[1] = blendOver(BG_COLOR, {0, 255, 100, 40});
+        background[2] = blendOver(BG_COLOR, {0, 255, 255, 40});
+    }
+    for (int x = 0; x < width; x++) {
+        int biome = std::min(2, x / std::max(1, width / 3));
+        pixels[x] = background[biome];
     }
+    for (int y = 1; y < height; y++) {
+        std::copy(pixels, pixels + width, pixels + y * width);
+    }
+}
+
+void World::render(Color* pixels, std::vector<Vector2>& outlined_cells, int view_mode) const {
+    // --- Biome Backgrounds ---
+    renderBackground(pixels, world_width, world_height);
 
-    bool highlight_mode = (selected_bot != nullptr);
+    bool highlight_mode = (selected_bot != nullptr || showing_relatives);
+    outlined_cells.clear();
 
     for (Bot* bot : this->bots) {
-        bool is_relative = std::find(relatives.begin(), relatives.end(), bot) != relatives.end();
+        Vector2 pos = bot->getPosition();
+        Color& pixel = pixels[(int)pos.y * world_width + (int)pos.x];
+        bool is_relative = bot->is_relative && !bot->isOrganic && !bot->is_dead;
         bool is_selected = (bot == selected_bot);
+        if (is_relative) {
+            outlined_cells.push_back(pos);
+        }
         if (!highlight_mode || is_selected || is_relative) {
-            bot->render(view_mode);
-            if (is_relative) {
-                DrawRectangleLinesEx({bot->getPosition().x * CELL_SIZE, bot->getPosition().y * CELL_SIZE, (float)CELL_SIZE, (float)CELL_SIZE}, 2, WHITE);
-            }
+            pixel = blendOver(pixel, bot->getRenderColor(view_mode));
         } else {
-            bot->render(view_mode, (unsigned char)(255.0 * 0.2));
+            pixel = blendOver(pixel, bot->getRenderColor(view_mode, (unsigned char)(255.0 * 0.2)));
         }
     }
-
-    // Draw grid
-    for (int i = 0; i < world_width; i++) {
-        DrawLineEx({float(i) * CELL_SIZE, 0},
-                   {float(i) * CELL_SIZE, (float)world_height * CELL_SIZE},
-                   GRID_THICKNESS, GRID_COLOR);
-    }
-    for (int i = 0; i < world_height; i++) {
-        DrawLineEx({0, float(i) * CELL_SIZE},
-                   {(float)world_width * CELL_SIZE, float(i) * CELL_SIZE},
-                   GRID_THICKNESS, GRID_COLOR);
-    }
 }
 
 void World::process() {
@@ -116,21 +257,25 @@ void World::process() {
         // If so, don't process it.
         if (!bot->is_dead) {
             bot->process(*this);
+            this->census.updateBot(*bot); // Does nothing if it died or turned organic
+            // Its energy and diet change every turn. Corpses only change by moving.
+            if (!bot->is_dead && !bot->isOrganic) _trackCellState(bot);
         }
     }
 
     // Second phase: clean up bots that were marked as dead during the processing phase.
     auto it = std::remove_if(this->bots.begin(), this->bots.end(), [](Bot* bot) {
         if (bot->is_dead) {
-            // In the GenomeAnalyzer, we need to be careful not to delete the main sim_bot
-            // while the analyzer might still reference it in the same frame.
-            // The analyzer will handle the cleanup of sim_bot.
-            if (bot->isOrganic || bot->getEnergy() > 0) delete bot;
+            // Nothing keeps pointers to removed bots past the step (the analyzer copies its bot
+            // when it dies, see WorldObserver::onDeath), so starved bots are freed as well.
+            delete bot;
             return true;
         }
         return false;
     });
     this->bots.erase(it, this->bots.end());
+
+    this->census.record(this->step_count, this->genome_index.getGenomeCount());
 }
 
 Bot* World::getBotAt(Vector2 position) {
@@ -143,6 +288,14 @@ Bot* World::getBotAt(Vector2 position) {
 void World::clear() {
     for (Bot* bot : bots) { delete bot; }
     bots.clear();
+    epoch++;
+    genome_index.clear();
+    phylogeny.clear();
+    census.clear();
+    std::fill(tracked_cells.begin(), tracked_cells.end(), 0);
+    selected_bot = nullptr;
+    showing_relatives = false;
+    relative_genome.clear();
     for (int x = 0; x < grid.size(); x++) {
         for (int y = 0; y < grid[x].size(); y++) {
             grid[x][y] = nullptr;
@@ -151,38 +304,214 @@ void World::clear() {
     step_count = 0;
 }
 
-void World::saveWorld(const std::string& filename) {
-    std::ofstream out(filename, std::ios::binary);
-    if (!out.is_open()) return;
+void World::captureImage(WorldImage& image) const {
+    image.width = this->world_width;
+    image.height = this->world_height;
+    image.seed = this->seed;
+    image.step_count = this->step_count;
+    this->random.getState(image.resume.random_state);
+    image.resume.next_lineage_id = this->phylogeny.getNextId();
+    image.genes.clear();
+    image.genome_ends.clear();
+    image.record_ends.clear();
+    image.ids.clear();
+    image.epoch = this->epoch;
+    size_t gene_count = 0;
+    for (const Bot* bot : this->bots) gene_count += bot->getGenome().size();
+    image.genes.reserve(gene_count);
+    image.genome_ends.reserve(this->bots.size());
+    image.record_ends.reserve(this->bots.size());
+    image.ids.reserve(this->bots.size());
+    ByteWriter records;
+    records.getBytes().swap(image.records); // Keep the buffer's capacity
+    records.getBytes().clear();
+    records.getBytes().reserve(this->bots.size() * 24); // Typical records take 12-20 bytes
+    for (const Bot* bot : this->bots) {
+        const std::vector<uint8_t>& genome = bot->getGenome();
+        image.genes.insert(image.genes.end(), genome.begin(), genome.end());
+        image.genome_ends.push_back((uint32_t)image.genes.size());
+        bot->serialize(records);
+        image.record_ends.push_back((uint32_t)records.size());
+        image.ids.push_back(bot->getLineageId());
+    }
+    image.records.swap(records.getBytes());
+}
 
-    out.write(reinterpret_cast<char*>(&seed), sizeof(seed));
-    out.write(reinterpret_cast<char*>(&step_count), sizeof(step_count));
-    size_t bot_count = bots.size();
-    out.write(reinterpret_cast<char*>(&bot_count), sizeof(bot_count));
+void writeResumeState(ByteWriter& out, const ResumeState& state) {
+    for (uint32_t word : state.random_state) out.putU32(word);
+    out.putVarint(state.next_lineage_id);
+}
 
-    for (Bot* bot : bots) {
-        bot->serialize(out);
+bool readResumeState(ByteReader& in, ResumeState& state) {
+    for (uint32_t& word : state.random_state) word = in.getU32();
+    state.next_lineage_id = in.getVarint();
+    const uint32_t* words = state.random_state;
+    if ((words[0] | words[1] | words[2] | words[3]) == 0) in.fail();
+    return !in.failed();
+}
+
+void encodeWorldImage(const WorldImage& image, ByteWriter& out) {
+    GenomeTable genomes;
+    std::vector<uint32_t> genome_ids;
+    encodeWorldImage(image, out, genomes, genome_ids);
+}
+
+void encodeWorldImage(const WorldImage& image, ByteWriter& out, GenomeTable& genomes, std::vector<uint32_t>& genome_ids) {
+    beginSaveFile(out, SAVE_MAGIC_WORLD);
+    out.putVarint((uint64_t)image.width);
+    out.putVarint((uint64_t)image.height);
+    out.putVarint(image.seed);
+    out.putVarint((uint64_t)image.step_count);
+    writeResumeState(out, image.resume);
+
+    // Genome table: every distinct genome once, bots refer to it by index.
+    const size_t bot_count = image.getBotCount();
+    genome_ids.resize(bot_count);
+    for (size_t i = 0; i < bot_count; i++) {
+        size_t begin = i > 0 ? image.genome_ends[i - 1] : 0;
+        genome_ids[i] = genomes.intern(image.genes.data() + begin, image.genome_ends[i] - begin);
+    }
+    out.putVarint(genomes.size());
+    for (uint32_t id = 0; id < genomes.size(); id++) {
+        out.putVarint(genomes.getSize(id));
+        out.putBytes(genomes.getGenes(id), genomes.getSize(id));
+    }
+
+    out.putVarint(bot_count);
+    for (size_t i = 0; i < bot_count; i++) {
+        out.putVarint(genome_ids[i]);
+        size_t begin = i > 0 ? image.record_ends[i - 1] : 0;
+        out.putBytes(image.records.data() + begin, image.record_ends[i] - begin);
     }
-    out.close();
+    finishSaveFile(out);
 }
 
-void World::loadWorld(const std::string& filename) {
-    std::ifstream in(filename, std::ios::binary);
-    if (!in.is_open()) return;
+bool World::saveWorld(const std::string& filename, int compression_level) {
+    WorldImage image;
+    captureImage(image);
+    ByteWriter out;
+    encodeWorldImage(image, out);
+    compressSaveFile(out, compression_level);
+    return writeFile(filename, out.getBytes());
+}
 
-    clear();
+bool World::loadWorld(const std::string& filename) {
+    MappedFile file(filename);
+    if (!file.isOpen()) return false;
 
-    in.read(reinterpret_cast<char*>(&seed), sizeof(seed));
-    SetRandomSeed(seed);
+    // Decode everything first, so a damaged file leaves the world as it was.
+    unsigned int loaded_seed = 0;
+    long long loaded_step_count = 0;
+    ResumeState resume;
+    std::vector<Bot*> loaded;
+    int version = 0;
+    bool is_legacy = false;
+    std::vector<uint8_t> decompressed;
+    ByteReader in = openSaveFile(file.data(), file.size(), SAVE_MAGIC_WORLD, version, is_legacy, decompressed);
+    bool ok;
+    if (is_legacy) {
+        // Raw fields: unsigned int seed, long long step count, size_t bot count, then the bots.
+        ByteReader legacy(file.data(), file.size());
+        loaded_seed = legacy.getU32();
+        loaded_step_count = (long long)(legacy.getU32() | ((uint64_t)legacy.getU32() << 32));
+        uint64_t bot_count = legacy.getU32() | ((uint64_t)legacy.getU32() << 32);
+        ok = !legacy.failed() && bot_count <= (uint64_t)this->world_width * this->world_height;
+        for (uint64_t i = 0; ok && i < bot_count; i++) {
+            Bot* bot = new Bot(std::vector<uint8_t>());
+            loaded.push_back(bot);
+            ok = bot->deserializeLegacy(legacy);
+        }
+    } else {
+        ok = in.getVarint() == (uint64_t)this->world_width && in.getVarint() == (uint64_t)this->world_height;
+        loaded_seed = (unsigned int)in.getVarint();
+        loaded_step_count = (long long)in.getVarint();
+        if (version >= 2) ok = ok && readResumeState(in, resume);
+        // The genome table stays in the file's pages; every bot copies its genome once.
+        struct GenomeSpan { const uint8_t* genes; size_t size; };
+        uint64_t genome_count = in.getVarint();
+        ok = ok && !in.failed() && genome_count <= in.remaining();
+        std::vector<GenomeSpan> genomes(ok ? (size_t)genome_count : 0);
+        for (size_t i = 0; ok && i < genomes.size(); i++) {
+            genomes[i].genes = readGenomeInPlace(in, genomes[i].size);
+            ok = genomes[i].genes != nullptr;
+        }
+        uint64_t bot_count = in.getVarint();
+        ok = ok && !in.failed() && bot_count <= (uint64_t)this->world_width * this->world_height;
+        if (ok) loaded.reserve((size_t)bot_count);
+        for (uint64_t i = 0; ok && i < bot_count; i++) {
+            uint64_t genome_id = in.getVarint();
+            if (genome_id >= genomes.size()) break;
+            const GenomeSpan& genome = genomes[genome_id];
+            Bot* bot = new Bot(std::vector<uint8_t>(genome.genes, genome.genes + genome.size));
+            loaded.push_back(bot);
+            ok = bot->deserialize(in, version);
+        }
+        ok = ok && loaded.size() == bot_count;
+    }
 
-    in.read(reinterpret_cast<char*>(&step_count), sizeof(step_count));
-    size_t bot_count;
-    in.read(reinterpret_cast<char*>(&bot_count), sizeof(bot_count));
+    if (!ok) {
+        for (Bot* bot : loaded) delete bot;
+        return false;
+    }
+    return restoreState(loaded_seed, loaded_step_count, loaded, !is_legacy && version >= 2 ? &resume : nullptr);
+}
 
-    for (size_t i = 0; i < bot_count; ++i) {
-        Bot* bot = new Bot();
-        bot->deserialize(in);
-        addBot(bot);
+bool World::restoreState(unsigned int seed, long long step_count, std::vector<Bot*>& loaded, const ResumeState* resume) {
+    // Every bot needs a cell of its own.
+    bool ok = true;
+    std::vector<char> occupied((size_t)this->world_width * this->world_height, 0);
+    for (size_t i = 0; ok && i < loaded.size(); i++) {
+        Vector2 position = loaded[i]->getPosition();
+        if (position.x < 0 || position.x >= this->world_width || position.y < 0 || position.y >= this->world_height) {
+            ok = false;
+            break;
+        }
+        char& cell = occupied[(size_t)position.x * this->world_height + (size_t)position.y];
+        ok = !cell;
+        cell = 1;
+    }
+    // Saved lineage ids must be unique; the phylogeny gets them in ascending order, so parents
+    // come before their children.
+    std::vector<Bot*> by_id;
+    if (ok && resume) {
+        for (Bot* bot : loaded) {
+            if (bot->getLineageId() != 0) by_id.push_back(bot);
+        }
+        std::sort(by_id.begin(), by_id.end(), [](const Bot* a, const Bot* b) { return a->getLineageId() < b->getLineageId(); });
+        for (size_t i = 1; ok && i < by_id.size(); i++) ok = by_id[i - 1]->getLineageId() != by_id[i]->getLineageId();
+    }
+    if (!ok) {
+        for (Bot* bot : loaded) delete bot;
+        loaded.clear();
+        return false;
     }
-    in.close();
+
+    clear();
+    this->seed = seed;
+    if (!resume || !this->random.setState(resume->random_state)) this->random.seed(this->seed);
+    this->step_count = step_count;
+    this->bots.reserve(loaded.size());
+    this->genome_index.reserve(loaded.size());
+    if (resume) {
+        for (Bot* bot : by_id) {
+            this->phylogeny.restoreBirth(bot->getLineageId(), bot->getParentId(), step_count - bot->getAge(), bot->getMutationCount());
+        }
+        this->phylogeny.setNextId(resume->next_lineage_id);
+    }
+    for (Bot* bot : loaded) {
+        if (resume && bot->getLineageId() != 0) {
+            _insertBot(bot);
+        } else {
+            addBot(bot); // Saved without a lineage
+        }
+    }
+    return true;
+}
+
+uint32_t World::getStateChecksum() const {
+    WorldImage image;
+    captureImage(image);
+    ByteWriter out;
+    encodeWorldImage(image, out);
+    return crc32(out.getBytes().data() + SAVE_HEADER_SIZE, out.size() - SAVE_HEADER_SIZE);
 }
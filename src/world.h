@@ -1,7 +1,57 @@
 #include <bot.h>
 #include <string>
+#include "genome_index.h"
+#include "phylogeny.h"
+#include "census.h"
+#include "random.h"
 #pragma once
 
+// Receives notable events of a world as they happen. The world calls it from the thread that
+// processes it, in the middle of a step, so implementations must not modify the world.
+class WorldObserver {
+public:
+    virtual ~WorldObserver() = default;
+    virtual void onReproduce(const Bot& parent, const Bot& child) {}
+    virtual void onAttack(const Bot& attacker, const Bot& victim) {} // A living victim, killed by the attack
+    virtual void onDeath(const Bot& bot) {} // Starved, killed or died of age (not for consumed corpses)
+};
+
+// What a world needs besides its bots to go on exactly as if it had never been saved: the
+// random generator and the next lineage id. Stored after the step count since save format
+// version 2.
+struct ResumeState {
+    uint32_t random_state[4] = {0, 0, 0, 0};
+    uint64_t next_lineage_id = 1;
+};
+void writeResumeState(ByteWriter& out, const ResumeState& state);
+bool readResumeState(ByteReader& in, ResumeState& state); // Fails the reader on an invalid generator state
+
+// Everything a world save file holds, copied out of a world by World::captureImage(). Taking
+// it is a few plain copies; encoding it (genome table, checksum) and writing the file can then
+// happen on another thread while the world moves on, see Checkpointer.
+struct WorldImage {
+    int width = 0;
+    int height = 0;
+    unsigned int seed = 0;
+    long long step_count = 0;
+    ResumeState resume;
+    std::vector<uint8_t> genes;          // The bots' genomes, back to back
+    std::vector<uint32_t> genome_ends;   // Bot i's genome ends at genes[genome_ends[i]]
+    std::vector<uint8_t> records;        // The bots' Bot::serialize() records, back to back
+    std::vector<uint32_t> record_ends;
+    std::vector<uint64_t> ids;           // The bots' lineage ids (not saved), see World::getEpoch()
+    uint64_t epoch = 0;
+    size_t getBotCount() const { return this->genome_ends.size(); }
+};
+// Encodes a complete world save file (see save_format.h) into out.
+void encodeWorldImage(const WorldImage& image, ByteWriter& out);
+// The same, interning the genomes into an empty table; genome_ids receives every bot's id.
+void encodeWorldImage(const WorldImage& image, ByteWriter& out, GenomeTable& genomes, std::vector<uint32_t>& genome_ids);
+
+// The biome backgrounds World::render() draws the bots over, and its blending.
+void renderBackground(Color* pixels, int width, int height);
+Color blendOver(Color dst, Color src);
+
 class World {
 public:
     World(int width, int height);
@@ -9,9 +59,14 @@ public:
     ~World();
     void newWorld(unsigned int seed, int initial_bot_count);
     void spawnInitialBots(int count);
+    // Places count newborn copies of the prototypes, taken in turn, at random empty cells, as
+    // founders of their own clades. Returns how many found a cell.
+    int spawnCopies(const std::vector<Bot>& prototypes, int count);
     void addBot(Bot *bot_ptr);
     void removeBot(Bot* bot_ptr);
-    void render(int view_mode, Bot* selected_bot, const std::vector<Bot*>& relatives);
+    void botBecameOrganic(Bot* bot_ptr); // Called when a bot dies and leaves a corpse
+    void botEnergyChanged(Bot* bot_ptr); // Called when a bot changes another bot's energy
+    void render(Color* pixels, std::vector<Vector2>& outlined_cells, int view_mode) const;
     void process();
     void updateBotPosition(Bot* bot_ptr, Vector2 old_pos);
     Bot* getBotAt(Vector2 position);
@@ -19,16 +74,69 @@ public:
     int getBotsSize() const { return this->bots.size(); }
     long long getStepCount() const { return this->step_count; }
     unsigned int getSeed() const { return this->seed; }
-    void saveWorld(const std::string& filename);
-    void loadWorld(const std::string& filename); 
+    bool saveWorld(const std::string& filename, int compression_level = SAVE_COMPRESSION_LEVEL); // See save_format.h
+    void captureImage(WorldImage& image) const;   // Reuses the image's buffers
+    bool loadWorld(const std::string& filename); // Either format; leaves the world untouched on failure
+    // Replaces the world's contents with the given bots and takes ownership of them. If any
+    // bot is outside the world or shares a cell, or two share a lineage id, deletes them all
+    // and leaves the world untouched. With a resume state the generator and the bots' lineage
+    // ids are restored too; without one (older saves) the generator is reseeded with the seed
+    // and the bots get new lineage ids.
+    bool restoreState(unsigned int seed, long long step_count, std::vector<Bot*>& loaded, const ResumeState* resume = nullptr);
+    // CRC-32 of the world as it would be saved (uncompressed), so it covers every bot's full
+    // state and the generator: two worlds with the same checksum go on identically.
+    uint32_t getStateChecksum() const;
+    // Increases with every clear(). Lineage ids are unique within an epoch, so two images of
+    // the same epoch can be matched bot by bot (see DeltaEncoder).
+    uint64_t getEpoch() const { return this->epoch; }
     void clear();
+    // The world keeps the UI's selection so it can drop it as soon as the bot is removed.
+    void selectBot(Bot* bot_ptr) { this->selected_bot = bot_ptr; }
+    Bot* getSelectedBot() const { return this->selected_bot; }
+    // Relative highlighting: every living bot whose genome differs from the scanned one by less
+    // than RELATIVE_GENOME_DIFFERENCE carries Bot::is_relative. The relatives are looked up once
+    // in the genome index, afterwards newborns are checked in addBot() and dead bots simply lose their cell.
+    void highlightRelatives(const Bot* origin);
+    void clearRelatives();
+    bool isShowingRelatives() const { return this->showing_relatives; }
+    // Appends all living (non-organic) bots whose genome is at most max_distance away.
+    void findBotsWithin(const std::vector<uint8_t>& genome, int max_distance, std::vector<Bot*>& out) const;
+    int getGenomeCount() const { return this->genome_index.getGenomeCount(); } // Distinct living genomes
+    const Phylogeny& getPhylogeny() const { return this->phylogeny; }
+    const Census& getCensus() const { return this->census; }
+    void setObserver(WorldObserver* observer) { this->observer = observer; } // nullptr to detach
+    WorldObserver* getObserver() const { return this->observer; }
+    Random& getRandom() { return this->random; } // All randomness of the world's processing
+    // The biome a bot in column x lives in. Small local worlds can be put into a single biome.
+    int getBiome(float x) const { return this->biome_override >= 0 ? this->biome_override : biomeAt(x); }
+    void setBiomeOverride(int biome) { this->biome_override = biome; } // -1 for the main world's thirds
     int getWidth() const { return world_width; }
     int getHeight() const { return world_height; }
+    // While tracking, the world keeps a trajectory frame of its cells (see trajectory.h) up to
+    // date as bots act, move, are born and die, so a recorder copies it instead of visiting
+    // every bot. nullptr while not tracking.
+    void setTrackingCells(bool tracking);
+    const uint8_t* getTrackedCells() const { return this->tracked_cells.empty() ? nullptr : this->tracked_cells.data(); }
 private:
+    void _insertBot(Bot* bot_ptr); // addBot() without assigning a lineage id
+    void _trackCell(const Bot* bot_ptr);
+    void _trackCellState(const Bot* bot_ptr); // _trackCell() for a living bot after its census update
+    void _untrackCell(Vector2 position);
     std::vector<Bot*> bots;
     std::vector<std::vector<Bot*>> grid;
     int world_width;
     int world_height;
     long long step_count = 0;
     unsigned int seed = 0;
+    uint64_t epoch = 0;
+    Bot* selected_bot = nullptr;
+    bool showing_relatives = false;
+    std::vector<uint8_t> relative_genome; // Copy, so highlighting survives the origin's death
+    GenomeIndex genome_index{RELATIVE_GENOME_DIFFERENCE - 1}; // Living, non-organic bots
+    Phylogeny phylogeny; // Ancestry of the living bots
+    Census census;
+    std::vector<uint8_t> tracked_cells; // Empty while not tracking
+    WorldObserver* observer = nullptr;
+    Random random;
+    int biome_override = -1;
 };
\ No newline at end of file
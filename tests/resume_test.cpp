@@ -0,0 +1,87 @@
+// Exact resume: a run of 2N steps must end in the same state as a run of N steps that is
+// saved, loaded and run for N more, both through a full save and through a chain of
+// incremental checkpoints (keyframe plus deltas). Anything Bot or World gains that is not
+// saved shows up here as a different state checksum.
+#include "checkpoint_chain.h"
+#include "checkpointer.h"
+#include "world.h"
+#include <cstdio>
+
+static const unsigned int SEED = 7;
+static const int INITIAL_BOTS = 8000;
+static const int HALF_STEPS = 1000;    // N
+static const int CHECKPOINTS = 3;       // In the first half, for the delta chain
+static const int KEYFRAME_INTERVAL = 5; // So all of them form one chain: a keyframe and deltas
+
+struct State {
+    uint32_t checksum;
+    int bots;
+    unsigned long long next_id;
+};
+
+static State stateOf(const World& world) {
+    return {world.getStateChecksum(), world.getBotsSize(), (unsigned long long)world.getPhylogeny().getNextId()};
+}
+
+static void run(World& world, int steps) {
+    for (int i = 0; i < steps; i++) world.process();
+}
+
+static bool check(const char* name, const State& expected, const State& actual) {
+    bool equal = expected.checksum == actual.checksum && expected.bots == actual.bots && expected.next_id == actual.next_id;
+    printf("%-12s checksum %08x, %d bots, next lineage id %llu%s\n", name, actual.checksum, actual.bots, actual.next_id,
+           equal ? "" : "  MISMATCH");
+    return equal;
+}
+
+int main() {
+    World uninterrupted;
+    uninterrupted.newWorld(SEED, INITIAL_BOTS);
+    run(uninterrupted, 2 * HALF_STEPS);
+    State expected = stateOf(uninterrupted);
+    printf("%-12s checksum %08x, %d bots, next lineage id %llu\n", "2N steps", expected.checksum, expected.bots, expected.next_id);
+    bool ok = true;
+
+    // Full save: the encoded image goes through a file, as in World > Save and Load.
+    {
+        World first;
+        first.newWorld(SEED, INITIAL_BOTS);
+        run(first, HALF_STEPS);
+        WorldImage image;
+        first.captureImage(image);
+        ByteWriter out;
+        encodeWorldImage(image, out);
+        compressSaveFile(out, SAVE_COMPRESSION_LEVEL);
+        World resumed;
+        if (!writeFile("resume_test.save", out.getBytes()) || !resumed.loadWorld("resume_test.save")) {
+            printf("could not save and load resume_test.save\n");
+            return 1;
+        }
+        ok = check("loaded", stateOf(first), stateOf(resumed)) && ok;
+        run(resumed, HALF_STEPS);
+        ok = check("full save", expected, stateOf(resumed)) && ok;
+    }
+
+    // Incremental checkpoints: the last one is a delta, loaded through its keyframe.
+    {
+        World first;
+        first.newWorld(SEED, INITIAL_BOTS);
+        Checkpointer checkpointer;
+        for (int i = 1; i <= CHECKPOINTS; i++) {
+            run(first, HALF_STEPS * i / CHECKPOINTS - HALF_STEPS * (i - 1) / CHECKPOINTS);
+            WorldImage image;
+            first.captureImage(image);
+            checkpointer.submitIncremental(std::move(image), "resume_test_chain.save", KEYFRAME_INTERVAL, 1);
+        }
+        checkpointer.wait();
+        World resumed;
+        std::string last = numberedFilename("resume_test_chain.save", first.getStepCount(), ".delta");
+        if (checkpointer.getFailureCount() > 0 || !loadCheckpoint(resumed, last)) {
+            printf("could not write or load %s\n", last.c_str());
+            return 1;
+        }
+        run(resumed, HALF_STEPS);
+        ok = check("delta chain", expected, stateOf(resumed)) && ok;
+    }
+    return ok ? 0 : 1;
+}